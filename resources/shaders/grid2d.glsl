@@ -10,16 +10,11 @@ void main() {
 #shader fragment
 #version 450 core
 
-layout (std140, binding = 0) uniform Globals {
-    ivec2 screenSize;
-    ivec2 virtualScreenSize;
-    mat4 projection;
-    mat4 view;
-    mat4 projView;
-};
+#include "include/globals.glsl"
 
 uniform ivec2 tileSize;
 uniform vec3 cameraPos;
+uniform ivec4 viewport; // x, y, width, height of the window area the world is shown in
 out vec4 fColor;
 
 bool NearZero(float f, float tolerance) {
@@ -27,13 +22,14 @@ bool NearZero(float f, float tolerance) {
 }
 
 void main() {
-    vec2 aspectRatio = virtualScreenSize / vec2(screenSize);
+    vec2 aspectRatio = virtualScreenSize / vec2(viewport.zw);
     vec2 gridOffset = cameraPos.xy / aspectRatio; // scaled from virtual screen pos to screen pos
     vec2 scaledTileSize = tileSize / aspectRatio;
-    vec2 screenCenter = screenSize / 2.0;
+    vec2 screenCenter = viewport.zw / 2.0;
+    vec2 fragCoord = gl_FragCoord.xy - viewport.xy;
    
-    vec2 fragWorldPos = vec2(-screenCenter + gl_FragCoord.xy + gridOffset);
-    vec2 fragPos = vec2(-screenCenter + gl_FragCoord.xy);
+    vec2 fragWorldPos = vec2(-screenCenter + fragCoord + gridOffset);
+    vec2 fragPos = vec2(-screenCenter + fragCoord);
 
     if (NearZero(fract(fragPos.x / scaledTileSize.x), 0.05) || NearZero(fract(fragPos.y / scaledTileSize.y), 0.05)) {
         if (int(fragWorldPos.x) == 0) 
@@ -3,10 +3,7 @@
 
 layout (location = 0) in vec2 pos;
 
-layout (std140, binding = 1) uniform UIMatrices {
-    mat4 uiProjection;
-    mat4 uiVirtualProjection;
-};
+#include "include/uiMatrices.glsl"
 
 out vec2 texCoord;
 
@@ -0,0 +1,9 @@
+// Globals UniformBuffer, see the layout in Renderer.hpp
+layout (std140, binding = 0) uniform Globals {
+    ivec2 screenSize;
+    ivec2 virtualScreenSize;
+    mat4 projection;
+    mat4 view;
+    mat4 projView;
+    float time;
+};
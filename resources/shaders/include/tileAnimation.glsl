@@ -0,0 +1,22 @@
+// Needs the Globals block (time)
+layout (binding = 2) uniform usamplerBuffer tileAnimations;
+uniform int tileAnimationCount; // 0 if the tilemap has no animations
+
+// Replaces an animated tile id by its current frame (see TileAnimationTable for the layout)
+uint AnimateTile(uint tileId) {
+    if (tileId >= uint(tileAnimationCount))
+        return tileId;
+
+    uvec2 animation = texelFetch(tileAnimations, int(tileId)).xy;
+    if (animation.y == 0u)
+        return tileId;
+
+    float cycle = uintBitsToFloat(texelFetch(tileAnimations, int(animation.x + animation.y - 1u)).y);
+    float cycleTime = mod(time, cycle);
+    for (uint i = 0u; i < animation.y - 1u; ++i) {
+        uvec2 frame = texelFetch(tileAnimations, int(animation.x + i)).xy;
+        if (cycleTime < uintBitsToFloat(frame.y))
+            return frame.x;
+    }
+    return texelFetch(tileAnimations, int(animation.x + animation.y - 1u)).x;
+}
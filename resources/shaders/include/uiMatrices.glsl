@@ -0,0 +1,4 @@
+layout (std140, binding = 1) uniform UIMatrices {
+    mat4 uiProjection;
+    mat4 uiVirtualProjection;
+};
@@ -6,13 +6,7 @@ layout (location = 1) in vec2 UV;
 layout (location = 2) in vec4 Color;
 layout (location = 3) in int TexIndex;
 
-layout (std140, binding = 0) uniform Globals {
-    ivec2 screenSize;
-    ivec2 virtualScreenSize;
-    mat4 projection;
-    mat4 view;
-    mat4 projView;
-};
+#include "include/globals.glsl"
 
 out vec2 texCoord;
 out vec4 color;
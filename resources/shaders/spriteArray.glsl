@@ -0,0 +1,36 @@
+#shader vertex
+#version 450 core
+
+layout (location = 0) in vec4 Position;
+layout (location = 1) in vec2 UV;
+layout (location = 2) in vec4 Color;
+layout (location = 3) in int TexIndex;
+
+#include "include/globals.glsl"
+
+out vec2 texCoord;
+out vec4 color;
+out flat int layer;
+
+void main() {
+    texCoord = UV;
+    color = Color;
+    layer = TexIndex;
+
+    gl_Position = projView * Position;
+}
+
+#shader fragment
+#version 450 core
+
+out vec4 fColor;
+
+in vec2 texCoord;
+in vec4 color;
+in flat int layer;
+
+layout (binding = 0) uniform sampler2DArray atlasPages;
+
+void main() {
+    fColor = texture(atlasPages, vec3(texCoord, layer)) * color;
+}
@@ -0,0 +1,64 @@
+#shader vertex
+#version 450 core
+
+layout (location = 0) in vec3 Position;
+layout (location = 1) in uint Scale;
+layout (location = 2) in uint Pivot;
+layout (location = 3) in uint RotationLayer;
+layout (location = 4) in uint RectID;
+layout (location = 5) in vec4 Color;
+
+#include "include/globals.glsl"
+
+struct SpriteRect {
+    vec4 uv;
+    vec2 size;
+    vec2 padding;
+};
+
+layout (std430, binding = 2) readonly buffer SpriteRects {
+    SpriteRect rects[];
+};
+
+out vec2 texCoord;
+out vec4 color;
+out flat int layer;
+
+// Same corner order as the vertex batch: bottom-left, bottom-right, top-left, top-right
+const vec2 corners[4] = vec2[](vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(-0.5, 0.5), vec2(0.5, 0.5));
+
+void main() {
+    SpriteRect rect = rects[RectID];
+    vec2 corner = corners[gl_VertexID];
+
+    vec2 scale = unpackHalf2x16(Scale);
+    vec2 pivotOffset = (unpackHalf2x16(Pivot) - vec2(0.5)) * rect.size;
+    float rotation = unpackHalf2x16(RotationLayer).x;
+
+    vec2 local = (corner * rect.size - pivotOffset * sign(scale)) * scale;
+    float s = sin(rotation);
+    float c = cos(rotation);
+    vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y) + Position.xy;
+
+    texCoord = mix(rect.uv.xy, rect.uv.zw, corner + vec2(0.5));
+    // Color is stored as 0xRRGGBBAA, so the bytes are read in reverse order
+    color = Color.wzyx;
+    layer = int(RotationLayer >> 16);
+
+    gl_Position = projView * vec4(world, Position.z, 1.0);
+}
+
+#shader fragment
+#version 450 core
+
+out vec4 fColor;
+
+in vec2 texCoord;
+in vec4 color;
+in flat int layer;
+
+layout (binding = 0) uniform sampler2DArray atlasPages;
+
+void main() {
+    fColor = texture(atlasPages, vec3(texCoord, layer)) * color;
+}
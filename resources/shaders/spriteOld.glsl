@@ -3,13 +3,7 @@
 
 layout (location = 0) in vec2 pos;
 
-layout (std140, binding = 0) uniform Globals {
-    ivec2 screenSize;
-    ivec2 virtualScreenSize;
-    mat4 projection;
-    mat4 view;
-    mat4 projView;
-};
+#include "include/globals.glsl"
 
 out vec2 texCoord;
 
@@ -3,40 +3,60 @@
 
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
 layout (location = 1) in vec4 color;
+layout (location = 2) in float layer; // Glyph page
 
-layout (std140, binding = 1) uniform UIMatrices {
-    mat4 uiProjection;
-    mat4 uiVirtualProjection;
-};
+#include "include/uiMatrices.glsl"
 
-layout (std140, binding = 0) uniform Globals {
-    ivec2 screenSize;
-    ivec2 virtualScreenSize;
-    mat4 projection;
-    mat4 view;
-    mat4 projView;
-};
+#include "include/globals.glsl"
 
 out vec4 textColor;
-out vec2 texCoords;
+out vec3 texCoords;
 
 void main() {
     gl_Position = uiVirtualProjection * vec4(vertex.xy, 0.0, 1.0);
     textColor = color;
-    texCoords = vertex.zw;
+    texCoords = vec3(vertex.zw, layer);
 }
 
 #shader fragment
 #version 450 core
 
+// Variants: SDF for signed distance field fonts, raster fonts otherwise
+
+#ifdef SDF
+struct TextInfo {
+    float width;
+    float edge;
+    float borderWidth; // Setting to 0 make the border disappear
+    float borderEdge;
+    vec2 borderOffset; // For drop shadows
+    vec3 outlineColor;
+};
+
+uniform TextInfo textInfo;
+#endif
+
 out vec4 fragColor;
 
 in vec4 textColor;
-in vec2 texCoords;
+in vec3 texCoords;
 
-uniform sampler2D text;
+uniform sampler2DArray tex;
 
 void main() {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, texCoords).r);
+#ifdef SDF
+    float distance = 1.0 - texture(tex, texCoords).r;
+    float alpha = 1.0 - smoothstep(textInfo.width, textInfo.width + textInfo.edge, distance);
+
+    float distance2 = 1.0 - texture(tex, texCoords + vec3(textInfo.borderOffset, 0.0)).r;
+    float outlineAlpha = 1.0 - smoothstep(textInfo.borderWidth, textInfo.borderWidth + textInfo.borderEdge, distance2);
+
+    float overallAlpha = alpha + (1.0 - alpha) * outlineAlpha;
+    vec3 overallColor = mix(textInfo.outlineColor, textColor.rgb, alpha / overallAlpha);
+
+    fragColor = vec4(overallColor, overallAlpha);
+#else
+    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(tex, texCoords).r);
     fragColor = textColor * sampled;
-}
\ No newline at end of file
+#endif
+}
@@ -3,7 +3,10 @@
 
 layout (location = 0) in uint itileId;
 
-uniform ivec2 mapSize;
+#include "include/globals.glsl"
+
+uniform ivec2 chunkSize;
+uniform ivec2 chunkOffset; // In tiles
 uniform mat4 model;
 uniform int tileSize;
 
@@ -11,12 +14,14 @@ out SData {
     uint tileId;
 } vsOut;
 
+#include "include/tileAnimation.glsl"
+
 void main() {
-    vsOut.tileId = itileId;
+    vsOut.tileId = AnimateTile(itileId);
 
     int i = gl_VertexID;
-    float x = i % mapSize.x * tileSize;
-    float y = i / mapSize.x * tileSize;
+    float x = (i % chunkSize.x + chunkOffset.x) * tileSize;
+    float y = (i / chunkSize.x + chunkOffset.y) * tileSize;
     gl_Position = vec4(x, y, 0, 1);
 }
 
@@ -26,13 +31,7 @@ void main() {
 layout (points) in;
 layout (triangle_strip, max_vertices = 4) out;
 
-layout (std140, binding = 0) uniform Globals {
-    ivec2 screenSize;
-    ivec2 virtualScreenSize;
-    mat4 projection;
-    mat4 view;
-    mat4 projView;
-};
+#include "include/globals.glsl"
 
 uniform int tileSize;
 uniform mat4 model;
@@ -0,0 +1,58 @@
+#shader vertex
+#version 450 core
+
+layout (location = 0) in vec2 pos; // Unit quad
+
+#include "include/globals.glsl"
+
+uniform ivec2 chunkOffset; // In tiles
+uniform ivec2 firstTile;   // Visible tiles of the chunk, relative to the chunk (inclusive)
+uniform ivec2 lastTile;    // (exclusive)
+uniform mat4 model;
+uniform int tileSize;
+
+out vec2 chunkCoord; // In tiles, relative to the chunk
+
+void main() {
+    chunkCoord = mix(vec2(firstTile), vec2(lastTile), pos);
+    gl_Position = projView * model * vec4((chunkCoord + vec2(chunkOffset)) * tileSize, 0, 1);
+}
+
+#shader fragment
+#version 450 core
+
+in vec2 chunkCoord;
+out vec4 fColor;
+
+#include "include/globals.glsl"
+
+layout (binding = 0) uniform sampler2D tex;
+layout (binding = 1) uniform usampler2D tileMap; // R16UI, one texel per tile of the chunk
+
+uniform ivec2 firstTile;
+uniform ivec2 lastTile;
+uniform ivec2 atlasTexSize;
+
+#include "include/tileAnimation.glsl"
+
+void main() {
+    //! Clamped since interpolation can land a hair outside of the quad on its edges
+    ivec2 tile = clamp(ivec2(floor(chunkCoord)), firstTile, lastTile - 1);
+    uint tileId = AnimateTile(texelFetch(tileMap, tile, 0).r);
+    if (tileId == 0) // 0 is considered an empty tile
+        discard;
+
+    tileId -= 1;
+    vec2 tilePos = vec2((tileId % atlasTexSize.x),
+                        (tileId / atlasTexSize.x));
+    vec2 uvStep = vec2(1.0 / float(atlasTexSize.x),
+                       1.0 / float(atlasTexSize.y));
+    float offset = 0.00001;
+
+    // Same uvs as the geometry shader path: tile rows go from the top of the atlas down
+    vec2 inTile = clamp(chunkCoord - vec2(tile), vec2(0.0), vec2(1.0));
+    vec2 texCoord = vec2(tilePos.x * uvStep.x + mix(offset, uvStep.x - offset, inTile.x),
+                         1 - uvStep.y - tilePos.y * uvStep.y + mix(offset, uvStep.y - offset, inTile.y));
+    // Explicit lod, the uvs jump between tiles so the derivatives are meaningless there
+    fColor = textureLod(tex, texCoord, 0);
+}
@@ -0,0 +1,42 @@
+#shader vertex
+#version 450 core
+
+layout (location = 0) in vec3 pos;
+
+out vec2 texCoords;
+
+void main() {
+    gl_Position = vec4(pos, 1.0);
+    texCoords = pos.xy * 0.5 + 0.5;
+}
+
+#shader fragment
+#version 450 core
+
+// Variants: SHARP_BILINEAR keeps the texels sharp and only blends their edges (the texture must use linear filtering),
+// otherwise the texture is just sampled (nearest filtering, meant for integer scales)
+
+in vec2 texCoords;
+out vec4 fragColor;
+
+uniform sampler2D scene;
+#ifdef SHARP_BILINEAR
+uniform vec2 outputSize;
+#endif
+
+void main() {
+#ifdef SHARP_BILINEAR
+    vec2 sceneSize = vec2(textureSize(scene, 0));
+    vec2 texel = texCoords * sceneSize;
+    vec2 scale = max(floor(outputSize / sceneSize), vec2(1.0));
+
+    // Inside each texel only the outer 0.5 / scale band is interpolated
+    vec2 regionRange = 0.5 - 0.5 / scale;
+    vec2 centerDistance = fract(texel) - 0.5;
+    vec2 offset = (centerDistance - clamp(centerDistance, -regionRange, regionRange)) * scale + 0.5;
+
+    fragColor = vec4(texture(scene, (floor(texel) + offset) / sceneSize).rgb, 1.0);
+#else
+    fragColor = vec4(texture(scene, texCoords).rgb, 1.0);
+#endif
+}
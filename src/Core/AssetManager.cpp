@@ -7,27 +7,61 @@
 #include "Rendering/VertexArray.hpp"
 
 std::unordered_map<std::string, Ref<Shader>> AssetManager::shaders;
+std::unordered_map<std::string, Ref<Shader>> AssetManager::shaderVariants;
+std::vector<Ref<Shader>> AssetManager::pendingShaders;
 std::unordered_map<std::string, Ref<Buffer>> AssetManager::buffers;
 std::unordered_map<std::string, Ref<Texture>> AssetManager::textures;
 std::unordered_map<std::string, Ref<class VertexArray>> AssetManager::vertexArrays;
 
 //+ Shaders
-Ref<Shader> AssetManager::AddShader(const std::string& name, const std::string& shaderPath) {
-    auto& result{shaders.emplace(name, MakeRef<Shader>(shaderPath))};
-    LOGIF_DEBUG(!result.second, "A shader with the name '{}' is already registered. No insertion was done.", name);
-    return result.first->second;
+Ref<Shader> AssetManager::AddShader(const std::string& name, const std::string& shaderPath, const std::vector<std::string>& defines) {
+    auto iter {shaders.find(name)};
+    if (iter != shaders.end()) {
+        LOG_DEBUG("A shader with the name '{}' is already registered. No insertion was done.", name);
+        return iter->second;
+    }
+
+    std::string variantKey {shaderPath};
+    for (const std::string& define : defines)
+        variantKey += "|" + define;
+
+    auto& variant {shaderVariants[variantKey]};
+    if (!variant) {
+        variant = MakeRef<Shader>();
+        if (variant->BeginLoad(shaderPath, defines) && variant->IsLoadPending())
+            pendingShaders.push_back(variant);
+    }
+    return shaders.emplace(name, variant).first->second;
 }
 
 Ref<Shader> AssetManager::GetShader(const std::string& name) {
     auto iter{shaders.find(name)};
-    if (iter != shaders.end())
+    if (iter != shaders.end()) {
+        if (iter->second->IsLoadPending())
+            iter->second->FinishLoad();
         return iter->second;
+    }
     LOG_DEBUG("No shader with name '{}' was found.", name);
     return nullptr;
 }
 
 void AssetManager::RemoveShader(const std::string& name) {
     shaders.erase(name);
+    //! Variants are only kept alive by the names that use them
+    for (auto iter {shaderVariants.begin()}; iter != shaderVariants.end();) {
+        if (iter->second.use_count() == 1)
+            iter = shaderVariants.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+void AssetManager::FinishShaderLoading() {
+    for (auto& shader : pendingShaders) {
+        if (shader->IsLoadPending())
+            shader->FinishLoad();
+    }
+    pendingShaders.clear();
 }
 
 //+ Buffers
@@ -90,6 +124,8 @@ void AssetManager::RemoveVertexArray(const std::string& name) {
 
 void AssetManager::Clear() {
     shaders.clear();
+    shaderVariants.clear();
+    pendingShaders.clear();
     buffers.clear();
     textures.clear();
     vertexArrays.clear();
@@ -4,12 +4,17 @@
 #include "Common.hpp"
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class AssetManager {
 public:  
-    static Ref<class Shader> AddShader(const std::string& name, const std::string& shaderPath);
+    // Shaders registered with the same path and defines share the same program. The compilation is only started here,
+    // it's finished by FinishShaderLoading or the first GetShader of the shader
+    static Ref<class Shader> AddShader(const std::string& name, const std::string& shaderPath, const std::vector<std::string>& defines = {});
     static Ref<class Shader> GetShader(const std::string& name);
     static void RemoveShader(const std::string& name);
+    // Waits for every shader added since the last call, call it once after adding them so they compile in parallel
+    static void FinishShaderLoading();
 
     static Ref<class Buffer> AddBuffer(const std::string& name, Ref<class Buffer> buffer);
     static Ref<class Buffer> GetBuffer(const std::string& name);
@@ -30,6 +35,8 @@ public:
 
 private:
     static std::unordered_map<std::string, Ref<class Shader>> shaders;
+    static std::unordered_map<std::string, Ref<class Shader>> shaderVariants; // By path and defines
+    static std::vector<Ref<class Shader>> pendingShaders;
     static std::unordered_map<std::string, Ref<class Buffer>> buffers;
     static std::unordered_map<std::string, Ref<class Texture>> textures;
     static std::unordered_map<std::string, Ref<class VertexArray>> vertexArrays;
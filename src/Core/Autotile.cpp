@@ -0,0 +1,51 @@
+#include "Autotile.hpp"
+
+#include "Log.hpp"
+
+#include <algorithm>
+
+AutotileSet::AutotileSet(AutotileMode mode, const std::vector<uint16_t>& tiles) : mode{mode} {
+    uint32_t expectedTiles {mode == AutotileMode::FourNeighbours ? fourNeighboursTileCount : eightNeighboursTileCount};
+    if (tiles.size() != expectedTiles)
+        LOG_ERROR("Autotile set needs {} tiles, {} were given.", expectedTiles, tiles.size());
+
+    // Valid blob masks in ascending order, their position is the index of their tile
+    std::array<int, 256> blobIndex;
+    blobIndex.fill(-1);
+    int blobCount {0};
+    for (uint32_t mask {0}; mask < 256; ++mask) {
+        if (ReduceMask(static_cast<uint8_t>(mask)) == mask)
+            blobIndex[mask] = blobCount++;
+    }
+
+    for (uint32_t mask {0}; mask < 256; ++mask) {
+        uint32_t index;
+        if (mode == AutotileMode::FourNeighbours) {
+            index = ((mask & AutotileMask::north) ? 1 : 0) | ((mask & AutotileMask::east) ? 2 : 0) |
+                    ((mask & AutotileMask::south) ? 4 : 0) | ((mask & AutotileMask::west) ? 8 : 0);
+        }
+        else {
+            index = static_cast<uint32_t>(blobIndex[ReduceMask(static_cast<uint8_t>(mask))]);
+        }
+        lookup[mask] = index < tiles.size() ? tiles[index] : 0;
+    }
+
+    for (uint16_t tile : tiles) {
+        if (tile == 0) {
+            LOG_WARN("Autotile sets can't use the empty tile (0).");
+            continue;
+        }
+        if (tile >= members.size())
+            members.resize(tile + 1, false);
+        members[tile] = true;
+    }
+}
+
+uint8_t AutotileSet::ReduceMask(uint8_t mask) {
+    using namespace AutotileMask;
+    if ((mask & north) == 0 || (mask & east) == 0) mask &= ~northEast;
+    if ((mask & south) == 0 || (mask & east) == 0) mask &= ~southEast;
+    if ((mask & south) == 0 || (mask & west) == 0) mask &= ~southWest;
+    if ((mask & north) == 0 || (mask & west) == 0) mask &= ~northWest;
+    return mask;
+}
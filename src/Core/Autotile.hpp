@@ -0,0 +1,59 @@
+#ifndef __AUTOTILE_H__
+#define __AUTOTILE_H__
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+enum class AutotileMode {
+    // Only the edge neighbours count: 16 tiles, indexed directly by the mask
+    FourNeighbours,
+    // Edges and corners (blob / Wang 47-tile set), a corner only counts when both of its edges are set
+    EightNeighbours
+};
+
+//+ Neighbour bits of an autotile mask (y goes up, so north is y + 1)
+namespace AutotileMask {
+    constexpr uint8_t north     {1 << 0};
+    constexpr uint8_t northEast {1 << 1};
+    constexpr uint8_t east      {1 << 2};
+    constexpr uint8_t southEast {1 << 3};
+    constexpr uint8_t south     {1 << 4};
+    constexpr uint8_t southWest {1 << 5};
+    constexpr uint8_t west      {1 << 6};
+    constexpr uint8_t northWest {1 << 7};
+}
+
+/**
+ * @brief Tiles of one terrain plus a lookup table from every possible 8-bit neighbour mask to the tile to use,
+ * precomputed once so evaluating a cell is a single array read.
+ *
+ * Tile order for FourNeighbours: the value of the mask built with the north, east, south and west bits packed as
+ * 1, 2, 4, 8 (0 = isolated, 15 = surrounded).
+ * Tile order for EightNeighbours: the 47 valid masks (corners without both edges removed) in ascending order.
+ */
+class AutotileSet {
+public:
+    static constexpr uint32_t fourNeighboursTileCount  {16};
+    static constexpr uint32_t eightNeighboursTileCount {47};
+
+    AutotileSet(AutotileMode mode, const std::vector<uint16_t>& tiles);
+
+    // Tile for a mask built with the AutotileMask bits (corner bits are ignored or reduced depending on the mode)
+    uint16_t GetTile(uint8_t mask) const { return lookup[mask]; }
+    // Whether the tile is one of the tiles of this terrain, neighbours only connect with cells of the same terrain
+    bool Contains(uint16_t tile) const { return tile < members.size() && members[tile]; }
+    // Any tile of the terrain, used to mark a cell before the neighbourhood is evaluated
+    uint16_t GetDefaultTile() const { return lookup[0xFF]; }
+    AutotileMode GetMode() const { return mode; }
+
+    // Removes the corners whose adjacent edges are not both set, leaving one of the 47 blob masks
+    static uint8_t ReduceMask(uint8_t mask);
+
+private:
+    AutotileMode mode;
+    std::array<uint16_t, 256> lookup;
+    std::vector<bool> members;
+};
+
+#endif // __AUTOTILE_H__
@@ -1,11 +1,17 @@
 #include "Components.hpp"
 
+#include "Autotile.hpp"
+#include "JobSystem.hpp"
 #include "Log.hpp"
+#include "Rendering/Shader.hpp"
+#include "Rendering/Sprite.hpp"
 #include "Rendering/Texture.hpp"
 #include "GameObject.hpp"
 #include "Time.hpp"
 // #include "Rendering/VertexArray.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
 //+ Transform =================================================================
@@ -48,8 +54,29 @@ void Transform::UpdateTransform() {
     }
 }
 
+//+ SpriteRenderer =================================================================
+
+void SpriteRenderer::UpdateSortKey() {
+    sortKey = ComputeSortKey();
+}
+
+uint64_t SpriteRenderer::ComputeSortKey() const {
+    // Sprites packed in the atlas are drawn before the ones using their own texture, so the batch changes mode less often
+    int atlasLayer {sprite->GetAtlasLayer()};
+    if (atlasLayer >= 0)
+        return MakeRenderSortKey(renderOrder, 0, static_cast<uint32_t>(atlasLayer));
+    return MakeRenderSortKey(renderOrder, 1, sprite->GetTexture()->GetID());
+}
+
+Bounds2D SpriteRenderer::GetBounds(const Transform& transform) const {
+    // With the pivot inside the sprite, no corner is further from the position than the scaled sprite diagonal, whatever the rotation
+    glm::vec2 scaledSize {sprite->GetSize().x * std::abs(transform.GetScale().x), sprite->GetSize().y * std::abs(transform.GetScale().y)};
+    float radius {glm::length(scaledSize)};
+    glm::vec2 position {transform.GetPosition().x, transform.GetPosition().y};
+    return Bounds2D{position - radius, position + radius};
+}
+
 //+ TilemapRenderer =================================================================
-// TODO: Add autotiling support
 TilemapRenderer::TilemapRenderer(GameObject* gameobject, glm::ivec2 size, int tileSize, Ref<Texture> textureAtlas, int layer) {
     this->gameobject = gameobject;
     Construct(size, tileSize, textureAtlas, layer);
@@ -58,52 +85,326 @@ TilemapRenderer::TilemapRenderer(GameObject* gameobject, glm::ivec2 size, int ti
 void TilemapRenderer::Construct(glm::ivec2 size, int tileSize, Ref<Texture> textureAtlas, int layer) {
     this->size = size;
     this->tileSize = tileSize;
-    tiles = std::vector<tile_t>(size.x * size.y);
     this->textureAtlas = textureAtlas;
     atlasTexSize = glm::ivec2{textureAtlas->GetWidth() / tileSize, textureAtlas->GetHeight() / tileSize}; 
     this->layer = layer;
 
-    VertexLayout layout { VertexElement{1, DataType::UShort, true} }; //! Datatype mush be equals to tile_t
-    mesh = MakeOwned<VertexArray>(tiles.data(), static_cast<uint32_t>(tiles.size()), layout, BufferUsage::Dynamic);
-    mesh->SetDrawMode(DrawMode::Points);
+    //! Chunks are allocated when their first tile is set
+    chunkCount = (size + TilemapChunk::size - 1) / TilemapChunk::size;
+    chunks.clear();
+    chunks.resize(chunkCount.x * chunkCount.y);
+    dirtyChunks.clear();
 
-    tilesTypeSize = GetDataTypeSize(layout[0].dataType);
     isConstructed = true;
 }
 
-tile_t TilemapRenderer::GetTile(int x, int y) {
-    int idx {x + y * size.x};
+tile_t TilemapRenderer::GetTile(int x, int y) const {
     // if (idx >= tiles.size() || x < 0 || y < 0)
     if (x >= size.x || y >= size.y || x < 0 || y < 0)
         return 0;
-    return tiles[idx];
+
+    const TilemapChunk& chunk {chunks[x / TilemapChunk::size + y / TilemapChunk::size * chunkCount.x]};
+    if (chunk.tiles.empty())
+        return 0;
+    return chunk.tiles[x % TilemapChunk::size + y % TilemapChunk::size * TilemapChunk::size];
 }
 
 void TilemapRenderer::SetTile(int x, int y, tile_t tileIdx) {
-    uint32_t idx {x + y * (uint32_t)size.x};
     // ASSERT(idx > tiles.size() - 1, "Index out of bounds. Values was: {} ({}, {}). Range was: [{} - {}]", idx, x, y, 0, tiles.size() - 1);
     ASSERT(x >= size.x || y >= size.y, "Index out of bounds. Values was: ({}, {}). Range was: ({}, {})",  x, y, size.x, size.y);
-    tiles[idx] = tileIdx;
+    uint32_t chunkIdx {static_cast<uint32_t>(x / TilemapChunk::size + y / TilemapChunk::size * chunkCount.x)};
+    TilemapChunk& chunk {chunks[chunkIdx]};
+    if (chunk.tiles.empty()) {
+        if (tileIdx == 0)
+            return;
+        chunk.tiles.resize(TilemapChunk::size * TilemapChunk::size);
+    }
+
+    uint8_t column {static_cast<uint8_t>(x % TilemapChunk::size)};
+    uint8_t row {static_cast<uint8_t>(y % TilemapChunk::size)};
+    tile_t& tile {chunk.tiles[column + row * TilemapChunk::size]};
+    if (tile == tileIdx)
+        return;
+
+    if (tile == 0)
+        ++chunk.usedTiles;
+    else if (tileIdx == 0)
+        --chunk.usedTiles;
+    tile = tileIdx;
+
+    if (MarkDirty(chunk, column, row))
+        dirtyChunks.push_back(chunkIdx);
+}
+
+bool TilemapRenderer::MarkDirty(TilemapChunk& chunk, uint8_t column, uint8_t row) {
+    bool wasClean {chunk.dirtyRows == 0};
+    uint32_t rowBit {1u << row};
+    if ((chunk.dirtyRows & rowBit) == 0) {
+        chunk.dirtyRows |= rowBit;
+        chunk.dirtyFirstColumn[row] = column;
+        chunk.dirtyLastColumn[row] = column;
+    }
+    else {
+        chunk.dirtyFirstColumn[row] = std::min(chunk.dirtyFirstColumn[row], column);
+        chunk.dirtyLastColumn[row] = std::max(chunk.dirtyLastColumn[row], column);
+    }
+    return wasClean;
+}
 
-    if (uploadEndIdx == 0)
-        uploadStartIdx = idx;
-    else if (uploadStartIdx > idx) 
-        uploadStartIdx = idx;
+// Offsets of the neighbours in the same order as the AutotileMask bits
+static const int autotileNeighbours[8][2] {{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
 
-    if (uploadEndIdx <= idx)
-        uploadEndIdx = idx + 1;
+uint8_t TilemapRenderer::GetAutotileMask(int x, int y, const AutotileSet& set) const {
+    uint8_t mask {0};
+    for (int i {0}; i < 8; ++i) {
+        if (set.Contains(GetTile(x + autotileNeighbours[i][0], y + autotileNeighbours[i][1])))
+            mask |= static_cast<uint8_t>(1 << i);
+    }
+    return mask;
+}
+
+void TilemapRenderer::SetAutotile(int x, int y, const AutotileSet& set, bool filled) {
+    if (filled)
+        SetTile(x, y, set.GetDefaultTile());
+    else if (set.Contains(GetTile(x, y)))
+        SetTile(x, y, 0);
+    else
+        return;
+
+    //+ Masks only depend on which cells belong to the terrain, so only the 3x3 neighbourhood can change
+    for (int ny {y - 1}; ny <= y + 1; ++ny) {
+        for (int nx {x - 1}; nx <= x + 1; ++nx) {
+            if (set.Contains(GetTile(nx, ny)))
+                SetTile(nx, ny, set.GetTile(GetAutotileMask(nx, ny, set)));
+        }
+    }
+}
+
+void TilemapRenderer::Autotile(const AutotileSet& set, const glm::ivec2& first, const glm::ivec2& last) {
+    glm::ivec2 start {glm::max(first, glm::ivec2{0})};
+    glm::ivec2 end {glm::min(last, size)};
+    if (start.x >= end.x || start.y >= end.y)
+        return;
+
+    //+ Evaluate the masks (reads only, so every row can go to a different thread)
+    glm::ivec2 regionSize {end - start};
+    std::vector<tile_t> newTiles(static_cast<size_t>(regionSize.x) * regionSize.y);
+    JobSystem::ParallelFor(static_cast<uint32_t>(regionSize.y), 16, [&](uint32_t firstRow, uint32_t lastRow) {
+        for (uint32_t row {firstRow}; row < lastRow; ++row) {
+            int y {start.y + static_cast<int>(row)};
+            tile_t* rowTiles {&newTiles[static_cast<size_t>(row) * regionSize.x]};
+            for (int x {start.x}; x < end.x; ++x) {
+                tile_t tile {GetTile(x, y)};
+                rowTiles[x - start.x] = set.Contains(tile) ? set.GetTile(GetAutotileMask(x, y, set)) : tile;
+            }
+        }
+    });
+
+    //+ Write them back, each chunk is handled by a single thread so its tiles and dirty flags are never shared
+    glm::ivec2 firstChunk {start / TilemapChunk::size};
+    glm::ivec2 regionChunks {(end - 1) / TilemapChunk::size + 1 - firstChunk};
+    std::vector<uint8_t> newDirtyChunks(regionChunks.x * regionChunks.y, 0);
+    JobSystem::ParallelFor(static_cast<uint32_t>(newDirtyChunks.size()), 4, [&](uint32_t firstIdx, uint32_t lastIdx) {
+        for (uint32_t i {firstIdx}; i < lastIdx; ++i) {
+            glm::ivec2 chunkCoords {firstChunk.x + static_cast<int>(i) % regionChunks.x, firstChunk.y + static_cast<int>(i) / regionChunks.x};
+            TilemapChunk& chunk {chunks[chunkCoords.x + chunkCoords.y * chunkCount.x]};
+            if (chunk.tiles.empty())
+                continue;
+
+            glm::ivec2 chunkStart {chunkCoords * TilemapChunk::size};
+            glm::ivec2 from {glm::max(start, chunkStart)};
+            glm::ivec2 to {glm::min(end, chunkStart + TilemapChunk::size)};
+            bool wasClean {chunk.dirtyRows == 0};
+            for (int y {from.y}; y < to.y; ++y) {
+                for (int x {from.x}; x < to.x; ++x) {
+                    // Terrain tiles are only swapped for other terrain tiles, so usedTiles doesn't change
+                    uint8_t column {static_cast<uint8_t>(x - chunkStart.x)};
+                    uint8_t row {static_cast<uint8_t>(y - chunkStart.y)};
+                    tile_t newTile {newTiles[static_cast<size_t>(y - start.y) * regionSize.x + (x - start.x)]};
+                    tile_t& tile {chunk.tiles[column + row * TilemapChunk::size]};
+                    if (tile != newTile) {
+                        tile = newTile;
+                        MarkDirty(chunk, column, row);
+                    }
+                }
+            }
+            newDirtyChunks[i] = wasClean && chunk.dirtyRows != 0;
+        }
+    });
+
+    for (uint32_t i {0}; i < newDirtyChunks.size(); ++i) {
+        if (newDirtyChunks[i]) {
+            glm::ivec2 chunkCoords {firstChunk.x + static_cast<int>(i) % regionChunks.x, firstChunk.y + static_cast<int>(i) / regionChunks.x};
+            dirtyChunks.push_back(static_cast<uint32_t>(chunkCoords.x + chunkCoords.y * chunkCount.x));
+        }
+    }
 }
 
 void TilemapRenderer::UpdateBufferData() {
-    if (uploadEndIdx > 0) {
-        // int dataTypeSize {static_cast<int>(mesh->GetVertexBuffer().GetSize() / tiles.size())};
-        mesh->GetVertexBuffer().SetData(uploadStartIdx * tilesTypeSize, (uploadEndIdx - uploadStartIdx) * tilesTypeSize, &tiles[uploadStartIdx]);
+    uploadStats = TilemapUploadStats{};
+
+    for (uint32_t chunkIdx : dirtyChunks) {
+        TilemapChunk& chunk {chunks[chunkIdx]};
+        if (renderMode == TilemapRenderMode::TileTexture && !chunk.tileTexture) {
+            chunk.tileTexture = MakeOwned<Texture>();
+            chunk.tileTexture->Generate(TilemapChunk::size, TilemapChunk::size, chunk.tiles.data(), TextureFormat::R16UI, TextureFormat::RED_INTEGER, DataType::UShort);
+            chunk.tileTexture->SetMinFilter(TextureParameter::Nearest).SetMagFilter(TextureParameter::Nearest)
+                .SetWrapS(TextureParameter::ClampToEdge).SetWrapT(TextureParameter::ClampToEdge);
+
+            uploadStats.uploadedBytes += static_cast<uint32_t>(chunk.tiles.size() * sizeof(tile_t));
+            ++uploadStats.uploadCalls;
+            chunk.dirtyRows = 0;
+            continue;
+        }
+        if (renderMode == TilemapRenderMode::GeometryShader && !chunk.mesh) {
+            VertexLayout layout { VertexElement{1, DataType::UShort, true} }; //! Datatype mush be equals to tile_t
+            chunk.mesh = MakeOwned<VertexArray>(chunk.tiles.data(), static_cast<uint32_t>(chunk.tiles.size()), layout, BufferUsage::Dynamic);
+            chunk.mesh->SetDrawMode(DrawMode::Points);
+
+            uploadStats.uploadedBytes += static_cast<uint32_t>(chunk.tiles.size() * sizeof(tile_t));
+            ++uploadStats.uploadCalls;
+            chunk.dirtyRows = 0;
+            continue;
+        }
+
+        int row {0};
+        while (row < TilemapChunk::size) {
+            if ((chunk.dirtyRows & (1u << row)) == 0) {
+                ++row;
+                continue;
+            }
+
+            int firstRow {row};
+            while (row + 1 < TilemapChunk::size && (chunk.dirtyRows & (1u << (row + 1))) != 0)
+                ++row;
+            int lastRow {row++};
+
+            if (renderMode == TilemapRenderMode::TileTexture) {
+                // Whole rows are uploaded, so the run stays contiguous without changing the unpack row length
+                uint32_t rowCount {static_cast<uint32_t>(lastRow - firstRow + 1)};
+                chunk.tileTexture->SubImage(0, firstRow, TilemapChunk::size, rowCount, &chunk.tiles[firstRow * TilemapChunk::size], DataType::UShort);
+
+                uploadStats.uploadedBytes += rowCount * TilemapChunk::size * sizeof(tile_t);
+                ++uploadStats.uploadCalls;
+                continue;
+            }
+
+            // The rows are contiguous in memory, so the whole run is a single range
+            uint32_t start {static_cast<uint32_t>(firstRow * TilemapChunk::size + chunk.dirtyFirstColumn[firstRow])};
+            uint32_t end {static_cast<uint32_t>(lastRow * TilemapChunk::size + chunk.dirtyLastColumn[lastRow] + 1)};
+            chunk.mesh->GetVertexBuffer().SetData(start * sizeof(tile_t), (end - start) * sizeof(tile_t), &chunk.tiles[start]);
+
+            uploadStats.uploadedBytes += (end - start) * sizeof(tile_t);
+            ++uploadStats.uploadCalls;
+        }
+        chunk.dirtyRows = 0;
+    }
+    dirtyChunks.clear();
+}
+
+bool TilemapRenderer::GetVisibleTileRange(const glm::mat4& model, const Bounds2D& viewBounds, glm::ivec2* outFirst, glm::ivec2* outLast) const {
+    Bounds2D localBounds {TransformBounds(viewBounds, glm::inverse(model))};
+    // Clamped as floats, the view may be far enough to overflow an int
+    glm::vec2 mapSize {size};
+    glm::vec2 firstTile {glm::clamp(glm::floor(localBounds.min / static_cast<float>(tileSize)), glm::vec2{0.0f}, mapSize)};
+    glm::vec2 lastTile {glm::clamp(glm::floor(localBounds.max / static_cast<float>(tileSize)) + 1.0f, glm::vec2{0.0f}, mapSize)};
+
+    *outFirst = glm::ivec2{firstTile};
+    *outLast = glm::ivec2{lastTile};
+    return outFirst->x < outLast->x && outFirst->y < outLast->y;
+}
+
+// Reused by every tilemap to draw only the visible rows of a chunk
+static std::vector<int> chunkRowFirsts;
+static std::vector<int> chunkRowCounts;
+
+uint32_t TilemapRenderer::Draw(const Shader& shader, const glm::ivec2& firstTile, const glm::ivec2& lastTile) const {
+    glm::ivec2 firstChunk {firstTile / TilemapChunk::size};
+    glm::ivec2 lastChunk {(lastTile + TilemapChunk::size - 1) / TilemapChunk::size}; // exclusive
+    uint32_t submittedTiles {0};
+
+    // Unit quad shared by every chunk, the vertex shader scales it to the visible part of the chunk
+    VertexArray* quad {nullptr};
+    if (renderMode == TilemapRenderMode::TileTexture) {
+        quad = AssetManager::GetVertexArray("gui").get();
+        quad->Use();
+    }
+
+    UniformHandle chunkOffsetUniform {shader.GetUniform("chunkOffset")};
+    UniformHandle firstTileUniform {shader.GetUniform("firstTile")};
+    UniformHandle lastTileUniform {shader.GetUniform("lastTile")};
+    shader.SetIVec2("chunkSize", glm::ivec2{TilemapChunk::size});
+    for (int cy {firstChunk.y}; cy < lastChunk.y; ++cy) {
+        for (int cx {firstChunk.x}; cx < lastChunk.x; ++cx) {
+            const TilemapChunk& chunk {chunks[cx + cy * chunkCount.x]};
+            if (chunk.usedTiles == 0 || (quad ? !chunk.tileTexture : !chunk.mesh))
+                continue;
+
+            glm::ivec2 chunkStart {cx * TilemapChunk::size, cy * TilemapChunk::size};
+            glm::ivec2 first {glm::max(firstTile, chunkStart) - chunkStart};
+            glm::ivec2 last {glm::min(lastTile, chunkStart + TilemapChunk::size) - chunkStart};
+            submittedTiles += (last.x - first.x) * (last.y - first.y);
+
+            shader.SetIVec2(chunkOffsetUniform, chunkStart);
+            if (quad) {
+                shader.SetIVec2(firstTileUniform, first);
+                shader.SetIVec2(lastTileUniform, last);
+                chunk.tileTexture->Use(1);
+                quad->Draw();
+                continue;
+            }
+
+            chunk.mesh->Use();
+            if (first == glm::ivec2{0} && last == glm::ivec2{TilemapChunk::size}) {
+                chunk.mesh->Draw();
+                continue;
+            }
+
+            // Tiles are drawn as points indexed by gl_VertexID, so each visible row is a range of points
+            chunkRowFirsts.clear();
+            chunkRowCounts.clear();
+            for (int y {first.y}; y < last.y; ++y) {
+                chunkRowFirsts.push_back(y * TilemapChunk::size + first.x);
+                chunkRowCounts.push_back(last.x - first.x);
+            }
+            chunk.mesh->MultiDraw(chunkRowFirsts.data(), chunkRowCounts.data(), static_cast<int>(chunkRowFirsts.size()));
+        }
+    }
+
+    return submittedTiles;
+}
+
+void TilemapRenderer::SetRenderMode(TilemapRenderMode mode) {
+    if (mode == renderMode)
+        return;
+
+    renderMode = mode;
+    dirtyChunks.clear();
+    for (uint32_t chunkIdx {0}; chunkIdx < chunks.size(); ++chunkIdx) {
+        TilemapChunk& chunk {chunks[chunkIdx]};
+        chunk.mesh.reset();
+        chunk.tileTexture.reset();
+        if (chunk.tiles.empty())
+            continue;
 
-        uploadStartIdx = 0;
-        uploadEndIdx = 0;
+        // Chunks without gpu data are uploaded whole, the rows are only flagged so SetTile doesn't queue the chunk again
+        chunk.dirtyRows = ~0u;
+        dirtyChunks.push_back(chunkIdx);
     }
 }
 
+const char* TilemapRenderer::GetShaderName() const {
+    return renderMode == TilemapRenderMode::TileTexture ? "tilemapTexture" : "tilemap";
+}
+
+void TilemapRenderer::UpdateSortKey() {
+    sortKey = ComputeSortKey();
+}
+
+uint64_t TilemapRenderer::ComputeSortKey() const {
+    return MakeRenderSortKey(layer, 0, textureAtlas->GetID());
+}
+
 // void OnTilemapAdded(entt::registry& reg, entt::entity entity) {
 //     auto& tilemapRender{reg.get<TilemapRenderer>(entity)};
 //     reg.emplace_or_replace<Tilemap<Tile>>(entity, tilemapRender.gameobject, tilemapRender.GetSize());
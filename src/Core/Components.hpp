@@ -5,15 +5,17 @@
 #include "Common.hpp"
 #include "Event.hpp"
 #include "Log.hpp"
+#include "Rendering/Texture.hpp"
 #include "Rendering/VertexArray.hpp"
 #include "Utils/MathExtras.hpp"
 #include "Utils/Color.hpp"
 
 // #include <entt/entity/registry.hpp>
 
+class AutotileSet;
 class GameObject;
 class Sprite;
-class Texture;
+class TileAnimationTable;
 // class VertexArray;
 
 // TODO: Use constructors to simplify work with the AddComponent function
@@ -46,12 +48,47 @@ private:
     bool isDirty       {true};
 };
 
+/**
+ * @brief Packs the draw order (biased so negative values go first) in the upper 32 bits, followed by 8 bits for
+ * the shader/batch group and 24 bits for the texture. Sorting by this key keeps the draw order and then groups
+ * draws that share state.
+ */
+inline uint64_t MakeRenderSortKey(int order, uint32_t group, uint32_t texture) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(order) ^ 0x80000000u) << 32) 
+         | (static_cast<uint64_t>(group & 0xff) << 24) 
+         | (texture & 0xffffff);
+}
+
 struct SpriteRenderer : public Component {
     Ref<Sprite> sprite {MakeRef<Sprite>(AssetManager::GetTexture("missing"))};
     Color color        {0xffffffff};
     int renderOrder    {0};
     // (0, 0) is bottom-left corner
     glm::vec2 pivot    {0.0f, 0.0f};
+
+    // Refreshed by the scene after the component is added or patched (call GameObject::NotifyChanged<SpriteRenderer> 
+    // after changing the render order or the texture), it only triggers a sort when the key changed
+    uint64_t sortKey       {0}; //! Kept public so the component can still be created with aggregate initialization
+    bool isSortKeyDirty    {false};
+
+    void UpdateSortKey();
+    // Key of the current values, GetSortKey returns the one of the last UpdateSortKey
+    uint64_t ComputeSortKey() const;
+    uint64_t GetSortKey() const { return sortKey; }
+    bool IsSortKeyDirty() const { return isSortKeyDirty; }
+    void SetSortKeyDirty(bool dirty) { isSortKeyDirty = dirty; }
+
+    // Conservative world space bounds of the sprite quad, used for culling (assumes a pivot inside the sprite)
+    Bounds2D GetBounds(const Transform& transform) const;
+};
+
+/**
+ * @brief Marks a sprite as static. Static sprites are drawn from retained buffers split in spatial chunks (see StaticSpriteLayer) 
+ * which are only rebuilt when a static sprite is added, removed or notified as changed with GameObject::NotifyChanged<StaticSprite>().
+ * They are drawn after the tilemaps and before the dynamic sprites.
+ */
+struct StaticSprite : public Component {
+    glm::ivec2 chunk {0, 0}; //! Managed by StaticSpriteLayer
 };
 
 struct Animator : public Component { // For this game, something this simple will do the job
@@ -112,42 +149,128 @@ private:
 
 using tile_t = uint16_t;
 
+enum class TilemapRenderMode {
+    // One point per tile expanded to a quad in a geometry shader
+    GeometryShader,
+    // One quad per chunk, the fragment shader reads the tile from an R16UI texture holding the chunk (no geometry shader)
+    TileTexture
+};
+
+// Square block of tiles with its own vertex buffer (or tile texture), the tiles and the gpu data are only allocated once a tile is set
+struct TilemapChunk {
+    static constexpr int size {32};
+
+    std::vector<tile_t> tiles;
+    Owned<VertexArray> mesh;     // TilemapRenderMode::GeometryShader
+    Owned<Texture> tileTexture;  // TilemapRenderMode::TileTexture
+    uint32_t usedTiles {0};  // Non-empty tiles, chunks without them are not drawn
+    
+    //+ Modified tiles waiting for upload: one bit per row plus the modified columns of each dirty row (inclusive)
+    uint32_t dirtyRows {0};
+    uint8_t dirtyFirstColumn[size];
+    uint8_t dirtyLastColumn[size];
+};
+static_assert(TilemapChunk::size <= 32, "TilemapChunk::dirtyRows needs one bit per row");
+
+struct TilemapUploadStats {
+    uint32_t uploadedBytes {0};
+    uint32_t uploadCalls   {0};
+};
+
 struct TilemapRenderer : public Component {
 private:
     glm::ivec2 size{0, 0};
     int tileSize{0};
-    std::vector<tile_t> tiles;
+    std::vector<TilemapChunk> chunks;
+    glm::ivec2 chunkCount{0, 0};
+    std::vector<uint32_t> dirtyChunks;
+    TilemapUploadStats uploadStats;
     Ref<Texture> textureAtlas{AssetManager::GetTexture("missing")};
     glm::ivec2 atlasTexSize{0, 0};
     int layer{0};
-    Owned<VertexArray> mesh;
+    uint64_t sortKey{0};
+    bool isSortKeyDirty{false};
+    TilemapRenderMode renderMode {TilemapRenderMode::GeometryShader};
+    Ref<TileAnimationTable> tileAnimations;
 
     bool isConstructed      {false};
-    uint32_t uploadStartIdx {0};  // inclusive
-    uint32_t uploadEndIdx   {0};  // exclusive
-    int tilesTypeSize       {0};
 
 public:
     TilemapRenderer(GameObject* gameobject, glm::ivec2 size, int tileSize, Ref<Texture> textureAtlas, int layer = 0);
     // This must be called in order to properly configure tilemap info
     void Construct(glm::ivec2 size, int tileSize, Ref<Texture> textureAtlas, int layer = 0);
 
-    // TODO: Support autotiling
     void SetTile(int x, int y, tile_t tileIdx);
-    tile_t GetTile(int x, int y);
+    tile_t GetTile(int x, int y) const;
+
+    /**
+     * @brief Adds (or removes) a cell of the set terrain and picks the tiles of it and its 8 neighbours from their masks.
+     * Cells outside of the tilemap don't connect.
+     */
+    void SetAutotile(int x, int y, const AutotileSet& set, bool filled = true);
+    /**
+     * @brief Picks the tile of every cell of the set terrain inside [first, last) in parallel, use it after generating a
+     * whole map instead of calling SetAutotile per cell
+     */
+    void Autotile(const AutotileSet& set, const glm::ivec2& first, const glm::ivec2& last);
+    void Autotile(const AutotileSet& set) { Autotile(set, glm::ivec2{0, 0}, size); }
 
     const glm::ivec2& GetSize() const { return size; }
     int GetTileSize() const { return tileSize; }
     Ref<Texture> GetTextureAtlas() const { return textureAtlas; }
     const glm::ivec2& GetAtlasTexSize() const { return atlasTexSize; }
     int GetLayer() const { return layer; }
-    VertexArray* GetMesh() const { return mesh.get(); }
+    const glm::ivec2& GetChunkCount() const { return chunkCount; }
+    TilemapRenderMode GetRenderMode() const { return renderMode; }
     bool IsConstructed() const { return isConstructed; }
 
     // TODO: Calculate other parameters
+    // Call GameObject::NotifyChanged<TilemapRenderer> afterwards so the scene refreshes the sort key
     void SetTextureAtlas(Ref<Texture> texture) { textureAtlas = texture; }
-
+    // Animations of the atlas tile ids, resolved in the shader so animated tiles cost nothing per frame (nullptr disables them)
+    void SetTileAnimations(Ref<TileAnimationTable> animations) { tileAnimations = animations; }
+    Ref<TileAnimationTable> GetTileAnimations() const { return tileAnimations; }
+    // Releases the gpu data of the current mode, the chunks are uploaded again in the new format on the next UpdateBufferData
+    void SetRenderMode(TilemapRenderMode mode);
+    // Name of the shader Draw expects to be in use for the current render mode
+    const char* GetShaderName() const;
+
+    /**
+     * @brief Uploads the modified tiles of the dirty chunks only. Consecutive dirty rows of a chunk are coalesced in a 
+     * single upload going from the first modified column of the first row to the last modified column of the last row.
+     */
     void UpdateBufferData();
+    // Bytes and calls used by the last UpdateBufferData
+    const TilemapUploadStats& GetUploadStats() const { return uploadStats; }
+
+    /**
+     * @brief Finds the tiles that overlap the given world space bounds
+     * 
+     * @param model Model matrix of the tilemap
+     * @param outFirst First visible column and row (inclusive)
+     * @param outLast Last visible column and row (exclusive)
+     * @return false if no tile is visible
+     */
+    bool GetVisibleTileRange(const glm::mat4& model, const Bounds2D& viewBounds, glm::ivec2* outFirst, glm::ivec2* outLast) const;
+
+    /**
+     * @brief Draws the non-empty chunks inside the given tile range (the shader named by GetShaderName must be in use)
+     * 
+     * @return Number of tiles submitted
+     */
+    uint32_t Draw(const class Shader& shader, const glm::ivec2& firstTile, const glm::ivec2& lastTile) const;
+
+    void UpdateSortKey();
+    // Key of the current values, GetSortKey returns the one of the last UpdateSortKey
+    uint64_t ComputeSortKey() const;
+    uint64_t GetSortKey() const { return sortKey; }
+    bool IsSortKeyDirty() const { return isSortKeyDirty; }
+    void SetSortKeyDirty(bool dirty) { isSortKeyDirty = dirty; }
+
+private:
+    uint8_t GetAutotileMask(int x, int y, const AutotileSet& set) const;
+    // Flags a tile of the chunk for upload, returns true if the chunk had no pending changes
+    static bool MarkDirty(TilemapChunk& chunk, uint8_t column, uint8_t row);
 };
 
 // void OnTilemapAdded(entt::registry& reg, entt::entity entity);
@@ -2,15 +2,20 @@
 
 #include "AssetManager.hpp"
 #include "Input/Input.hpp"
+#include "JobSystem.hpp"
 #include "Log.hpp"
 #include "Time.hpp"
 #include "Rendering/Batch.hpp"
+#include "Rendering/NullGL.hpp"
 #include "Rendering/Renderer.hpp"
 #include "Rendering/Shader.hpp"
+#include "Rendering/Texture.hpp"
+#include "Rendering/TextureAtlas.hpp"
 #include "Utils/OGLDebug.hpp"
 #include "Scene.hpp"
 
 #include "Game/TestScene.hpp"
+#include "UI/Text/GlyphCache.hpp"
 #include "UI/UI.hpp"
 #include "UI/UIStack.hpp"
 
@@ -19,10 +24,10 @@
 #endif // IMGUI
 #include <glm/ext/vector_int2.hpp>
 
-Engine::Engine(const std::string& title, int width, int height) 
+Engine::Engine(const std::string& title, int width, int height, bool headless) 
     : state{GameState::Running}, 
       uiStack{},
-      renderer{MakeOwned<Renderer>(this, glm::ivec2{width, height}, title)} {
+      renderer{MakeOwned<Renderer>(this, glm::ivec2{width, height}, title, false, headless)} {
 
     OGLDebugOutput::Enable(true);
 
@@ -31,6 +36,8 @@ Engine::Engine(const std::string& title, int width, int height)
 
     UI::Init(&uiStack);
 
+    JobSystem::Init();
+
     LoadData();
 
     activeScene = MakeOwned<TestScene>(this);
@@ -39,6 +46,7 @@ Engine::Engine(const std::string& title, int width, int height)
 Engine::~Engine() {
     Input::system->Shutdown();
     UnloadData();
+    JobSystem::Shutdown();
 }
 
 void Engine::Run() {
@@ -51,6 +59,45 @@ void Engine::Run() {
     }
 }
 
+bool Engine::RunHeadless(uint32_t frames, const FrameBudget& budget, HeadlessResult* outResult) {
+    //! The first frame fills the caches (glyphs, static sprite chunks...), so it isn't checked
+    constexpr uint32_t warmupFrames {1};
+
+    bool withinBudget {true};
+    uint32_t maxDrawCalls {0};
+    uint64_t maxUploadedBytes {0};
+    NullGL::NewFrame();
+    for (uint32_t frame {0}; frame < frames && state != GameState::Quit; ++frame) {
+        Time::BeginFrame();
+
+        ProcessInput();
+        Update();
+        Render();
+
+        NullGL::NewFrame();
+        const NullGLStats& stats {NullGL::GetFrameStats()};
+        LOG_DEBUG("Frame {}: {} draw calls, {} vertices, {:.1f} KB uploaded, {} program binds, {} texture binds, {} state changes.",
+                  frame, stats.drawCalls, stats.vertices, stats.GetUploadedBytes() / 1024.0f, stats.programBinds,
+                  stats.textureBinds, stats.stateChanges);
+        if (frame < warmupFrames)
+            continue;
+
+        maxDrawCalls = std::max(maxDrawCalls, stats.drawCalls);
+        maxUploadedBytes = std::max(maxUploadedBytes, stats.GetUploadedBytes());
+        if (stats.drawCalls > budget.maxDrawCalls || stats.GetUploadedBytes() > budget.maxUploadedBytes) {
+            LOG_ERROR("Frame {} went over budget: {} draw calls (max {}), {:.1f} KB uploaded (max {:.1f} KB).", frame,
+                      stats.drawCalls, budget.maxDrawCalls, stats.GetUploadedBytes() / 1024.0f, budget.maxUploadedBytes / 1024.0f);
+            withinBudget = false;
+        }
+    }
+
+    LOG_INFO("Headless run of {} frames: at most {} draw calls and {:.1f} KB uploaded per frame.", frames, maxDrawCalls,
+             maxUploadedBytes / 1024.0f);
+    if (outResult)
+        *outResult = HeadlessResult{maxDrawCalls, maxUploadedBytes};
+    return withinBudget;
+}
+
 void Engine::Shutdown() {
     state = GameState::Quit;
     LOG_INFO("Shutting down...");
@@ -180,12 +227,23 @@ void Engine::LoadData() {
 
     //+ Shaders
     AssetManager::AddShader("tilemap", "resources/shaders/tilemap.glsl");
+    AssetManager::AddShader("tilemapTexture", "resources/shaders/tilemapTexture.glsl");
     AssetManager::AddShader("sprite", "resources/shaders/sprite.glsl");
+    AssetManager::AddShader("spriteArray", "resources/shaders/spriteArray.glsl");
+    AssetManager::AddShader("spriteInstanced", "resources/shaders/spriteInstanced.glsl");
     AssetManager::AddShader("spriteOld", "resources/shaders/spriteOld.glsl");
     AssetManager::AddShader("grid2d", "resources/shaders/grid2d.glsl");
     AssetManager::AddShader("gui", "resources/shaders/gui.glsl");
     AssetManager::AddShader("text", "resources/shaders/text.glsl");
-    AssetManager::AddShader("textSDF", "resources/shaders/textsdf.glsl");
+    AssetManager::AddShader("textSDF", "resources/shaders/text.glsl", {"SDF"});
+    AssetManager::AddShader("upscale", "resources/shaders/upscale.glsl");
+    AssetManager::AddShader("upscaleSharpBilinear", "resources/shaders/upscale.glsl", {"SHARP_BILINEAR"});
+    AssetManager::FinishShaderLoading();
+    LOG_INFO("Parallel shader compilation: {}.", Shader::IsParallelCompileSupported() ? "supported" : "not supported");
+    auto& shaderCache {Shader::GetCacheStats()};
+    LOG_INFO("Shaders: {} loaded from the binary cache in {:.2f} ms ({:.2f} ms saved), {} compiled in {:.2f} ms.",
+             shaderCache.cachedPrograms, shaderCache.cacheLoadTime, shaderCache.cachedCompileTime - shaderCache.cacheLoadTime,
+             shaderCache.compiledPrograms, shaderCache.compileTime);
 
     //+ Assets
     AssetManager::AddTexture("player0_spritesheet", MakeRef<Texture>("resources/assets/Player0.png", true))->SetMinFilter(TextureParameter::Nearest)
@@ -201,11 +259,19 @@ void Engine::LoadData() {
     AssetManager::AddTexture("gui1", MakeRef<Texture>("resources/assets/DawnLike/GUI/GUI1.png", true))->SetMinFilter(TextureParameter::Nearest)
         .SetMagFilter(TextureParameter::Nearest).SetWrapS(TextureParameter::ClampToEdge).SetWrapT(TextureParameter::ClampToEdge);
 
+    //+ Texture Atlas
+    // Sprites from these textures end up in the same page so the batches don't need to switch textures
+    for (auto& name : {"default", "missing", "player0_spritesheet", "player1_spritesheet", "pit0_spritesheet", "pit1_spritesheet", "gui0", "gui1"})
+        TextureAtlas::Add(AssetManager::GetTexture(name));
+    TextureAtlas::Build();
+
     //+ Init Batch Renderers
     int textureUnits;
     glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
     SpriteBatch::Init(textureUnits);
+    SpriteInstanceBatch::Init();
     TextBatch::Init();
+    GlyphCache::Init();
 }
 
 void Engine::UnloadData() {
@@ -11,15 +11,30 @@ enum class GameState {
     Quit
 };
 
+// Limits checked on every frame of a headless run
+struct FrameBudget {
+    uint32_t maxDrawCalls     {UINT32_MAX};
+    uint64_t maxUploadedBytes {UINT64_MAX};
+};
+
+// Peaks measured by a headless run (the first frame isn't counted)
+struct HeadlessResult {
+    uint32_t maxDrawCalls     {0};
+    uint64_t maxUploadedBytes {0};
+};
+
 class Scene;
 class Renderer;
 
 class Engine {
 public:
-    Engine(const std::string& title, int width, int height);
+    // A headless engine has no window and renders through the null GL backend, see RunHeadless
+    Engine(const std::string& title, int width, int height, bool headless = false);
     ~Engine();
 
     void Run();
+    // Runs the given number of frames and returns false if any of them (after the first one) went over the budget
+    bool RunHeadless(uint32_t frames, const FrameBudget& budget, HeadlessResult* outResult = nullptr);
     void Shutdown();
     void Pause();
     void ProcessInput();
@@ -57,6 +57,12 @@ public:
         return false;
     }
 
+    // Triggers the on_update signal of the component (e.g. to rebuild the chunk of a StaticSprite after changing it)
+    template <class Component>
+    void NotifyChanged() {
+        scene->entityRegistry.patch<Component>(entity);
+    }
+
     template <class Component>
     void RemoveComponent() {
         if (HasComponents<Component>())
@@ -0,0 +1,106 @@
+#include "JobSystem.hpp"
+
+#include "Log.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+std::vector<std::thread> JobSystem::workers;
+std::queue<std::function<void()>> JobSystem::jobs;
+std::mutex JobSystem::jobsMutex;
+std::condition_variable JobSystem::jobsCondition;
+bool JobSystem::running {false};
+
+void JobSystem::Init(uint32_t workerCount) {
+    if (running)
+        return;
+
+    if (workerCount == 0) {
+        uint32_t hardwareThreads {std::thread::hardware_concurrency()};
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    running = true;
+    workers.reserve(workerCount);
+    for (uint32_t i {0}; i < workerCount; ++i)
+        workers.emplace_back(WorkerLoop);
+
+    LOG_INFO("Job system started with {} workers.", workerCount);
+}
+
+void JobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock {jobsMutex};
+        running = false;
+    }
+    jobsCondition.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t minRangeSize, const std::function<void(uint32_t, uint32_t)>& func) {
+    if (count == 0)
+        return;
+
+    minRangeSize = std::max(minRangeSize, 1u);
+    uint32_t rangeCount {std::min(GetWorkerCount() + 1, (count + minRangeSize - 1) / minRangeSize)};
+    if (rangeCount <= 1) {
+        func(0, count);
+        return;
+    }
+
+    uint32_t rangeSize {(count + rangeCount - 1) / rangeCount};
+    std::atomic<uint32_t> remaining {rangeCount - 1};
+    {
+        std::lock_guard<std::mutex> lock {jobsMutex};
+        for (uint32_t i {1}; i < rangeCount; ++i) {
+            uint32_t begin {i * rangeSize};
+            uint32_t end {std::min(begin + rangeSize, count)};
+            jobs.emplace([&func, &remaining, begin, end]() {
+                if (begin < end)
+                    func(begin, end);
+                --remaining;
+            });
+        }
+    }
+    jobsCondition.notify_all();
+
+    // The first range runs here, then help with whatever is still queued instead of blocking
+    func(0, std::min(rangeSize, count));
+    while (remaining > 0) {
+        if (!RunPendingJob())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::WorkerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock {jobsMutex};
+            jobsCondition.wait(lock, []() { return !running || !jobs.empty(); });
+            if (!running && jobs.empty())
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
+
+bool JobSystem::RunPendingJob() {
+    std::function<void()> job;
+    {
+        std::lock_guard<std::mutex> lock {jobsMutex};
+        if (jobs.empty())
+            return false;
+
+        job = std::move(jobs.front());
+        jobs.pop();
+    }
+    job();
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef __JOBSYSTEM_H__
+#define __JOBSYSTEM_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Small pool of worker threads used to split data-parallel work (e.g. generating sprite vertices).
+ * Jobs must not touch OpenGL, only the main thread owns the context.
+ */
+class JobSystem {
+public:
+    // A workerCount of 0 creates one worker less than the available hardware threads
+    static void Init(uint32_t workerCount = 0);
+    static void Shutdown();
+
+    /**
+     * @brief Splits [0, count) into ranges and calls func(begin, end) for each one on the workers and the calling thread.
+     * Returns once every range has been processed.
+     *
+     * @param minRangeSize Ranges are never smaller than this, so small counts run on the calling thread only
+     */
+    static void ParallelFor(uint32_t count, uint32_t minRangeSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+    static uint32_t GetWorkerCount() { return static_cast<uint32_t>(workers.size()); }
+
+private:
+    static void WorkerLoop();
+    // Runs one queued job on the calling thread, returns false if the queue was empty
+    static bool RunPendingJob();
+
+private:
+    static std::vector<std::thread> workers;
+    static std::queue<std::function<void()>> jobs;
+    static std::mutex jobsMutex;
+    static std::condition_variable jobsCondition;
+    static bool running;
+};
+
+#endif // __JOBSYSTEM_H__
@@ -7,21 +7,38 @@
 #include "Log.hpp"
 #include "Time.hpp"
 #include "Rendering/Batch.hpp"
+#include "Rendering/Camera.hpp"
+#include "Rendering/GLState.hpp"
+#include "Rendering/RenderStats.hpp"
 #include "Rendering/VertexArray.hpp"
 #include "Rendering/Shader.hpp"
 #include "Rendering/Sprite.hpp"
 #include "Rendering/Texture.hpp"
+#include "Rendering/TileAnimationTable.hpp"
 
 #include <algorithm>
+#include <entt/core/algorithm.hpp>
 
 // TODO: If game is closed while a component is being retrived by the entt system, it will crash (e.i. if (Input::GetKey(key) {go.GetComponent<T>()...} ))
 
+bool Scene::useCulling {true};
+
 Scene::Scene(Engine* engine) : engine{engine} {
     // entityRegistry.on_construct<TilemapRenderer>().connect<&OnTilemapAdded>();
+    entityRegistry.on_construct<SpriteRenderer>().connect<&Scene::OnSpriteChanged>(*this);
+    entityRegistry.on_update<SpriteRenderer>().connect<&Scene::OnSpriteChanged>(*this);
+    entityRegistry.on_construct<TilemapRenderer>().connect<&Scene::OnTilemapChanged>(*this);
+    entityRegistry.on_update<TilemapRenderer>().connect<&Scene::OnTilemapChanged>(*this);
 }
 
 Scene::~Scene() {
-   
+    entityRegistry.on_construct<SpriteRenderer>().disconnect<&Scene::OnSpriteChanged>(*this);
+    entityRegistry.on_update<SpriteRenderer>().disconnect<&Scene::OnSpriteChanged>(*this);
+    entityRegistry.on_construct<TilemapRenderer>().disconnect<&Scene::OnTilemapChanged>(*this);
+    entityRegistry.on_update<TilemapRenderer>().disconnect<&Scene::OnTilemapChanged>(*this);
+
+    if (tilemapTimerQuery != 0)
+        glDeleteQueries(1, &tilemapTimerQuery);
 }
 
 // TODO: Add IsActive checks on EVERYTHING in here
@@ -49,6 +66,8 @@ void Scene::Update() {
             if (animator.currentFrame >= animator.frames.size()) 
                 animator.currentFrame = 0;
             sprite.sprite->SetTexture(animator.frames[animator.currentFrame].texture);
+            // The texture is part of the sort key (and rebuilds the chunk if the sprite is static)
+            entityRegistry.patch<SpriteRenderer>(entity);
         }
     } 
     for (auto&& [entity, animator, tilemap] : entityRegistry.view<Animator, TilemapRenderer>().each()) {
@@ -62,6 +81,7 @@ void Scene::Update() {
             if (animator.currentFrame >= animator.frames.size())
                 animator.currentFrame = 0;
             tilemap.SetTextureAtlas(animator.frames[animator.currentFrame].texture);
+            entityRegistry.patch<TilemapRenderer>(entity);
         }
     }
 
@@ -156,6 +176,91 @@ void Scene::Update() {
     }
 }
 
+// Below this amount of changed keys, an insertion pass is cheaper than a full sort
+constexpr uint32_t insertionSortMaxChanged {32};
+
+template<class T>
+static void MarkSortKeyDirty(entt::registry& registry, entt::entity entity, std::vector<entt::entity>& dirtyKeys) {
+    T& component {registry.get<T>(entity)};
+    if (component.IsSortKeyDirty())
+        return;
+    component.SetSortKeyDirty(true);
+    dirtyKeys.push_back(entity);
+}
+
+void Scene::OnSpriteChanged(entt::registry& registry, entt::entity entity) {
+    MarkSortKeyDirty<SpriteRenderer>(registry, entity, dirtySpriteKeys);
+}
+
+void Scene::OnTilemapChanged(entt::registry& registry, entt::entity entity) {
+    MarkSortKeyDirty<TilemapRenderer>(registry, entity, dirtyTilemapKeys);
+}
+
+/**
+ * @brief Refreshes the sort keys of the components added or changed since the last call and sorts the pool only if
+ * any of them changed. The rest of the pool keeps its keys and order from the previous frames.
+ * 
+ * @param dirtyKeys Entities queued by the on_construct/on_update signals, cleared after refreshing them
+ * @param outChanged Returns the number of keys that changed
+ * @return true if the pool was sorted
+ */
+template<class T>
+static bool SortByKey(entt::registry& registry, std::vector<entt::entity>& dirtyKeys, uint32_t& outChanged) {
+    outChanged = 0;
+    for (entt::entity entity : dirtyKeys) {
+        //! The entity (or just the component) might have been destroyed after being queued
+        if (!registry.valid(entity) || !registry.all_of<T>(entity))
+            continue;
+
+        T& component {registry.get<T>(entity)};
+        if (!component.IsSortKeyDirty())
+            continue;
+        component.SetSortKeyDirty(false);
+
+        uint64_t previousKey {component.GetSortKey()};
+        component.UpdateSortKey();
+        if (component.GetSortKey() != previousKey)
+            ++outChanged;
+    }
+    dirtyKeys.clear();
+
+#ifndef NDEBUG
+    //! Keys changed without patching the component would keep drawing in the old order, refresh them with a warning
+    for (auto&& [entity, component] : registry.view<T>().each()) {
+        uint64_t key {component.ComputeSortKey()};
+        if (key == component.GetSortKey())
+            continue;
+
+        LOG_WARN("Sort key of entity {} changed without patching the component, call GameObject::NotifyChanged after changing it.",
+                 entt::to_integral(entity));
+        component.UpdateSortKey();
+        ++outChanged;
+    }
+#endif // NDEBUG
+
+    if (outChanged == 0)
+        return false;
+
+    auto compare {[](const T& a, const T& b) { return a.GetSortKey() < b.GetSortKey(); }};
+    if (outChanged <= insertionSortMaxChanged)
+        registry.template sort<T>(compare, entt::insertion_sort{});
+    else
+        registry.template sort<T>(compare);
+    return true;
+}
+
+void Scene::SortRenderers() {
+    uint64_t sortStart {Time::GetPerformanceCounter()};
+    sortInfo.tilemapsSorted = SortByKey<TilemapRenderer>(entityRegistry, dirtyTilemapKeys, sortInfo.tilemapsChanged);
+    sortInfo.spritesSorted = SortByKey<SpriteRenderer>(entityRegistry, dirtySpriteKeys, sortInfo.spritesChanged);
+    //+ Also sort Transform in order to reduce cache misses (sprites go last since there are many more of them than tilemaps)
+    if (sortInfo.tilemapsSorted)
+        entityRegistry.sort<Transform, TilemapRenderer>();
+    if (sortInfo.tilemapsSorted || sortInfo.spritesSorted)
+        entityRegistry.sort<Transform, SpriteRenderer>();
+    sortInfo.sortTime = Time::GetMilisecondsSince(sortStart);
+}
+
 #define SPRITE_BATCHING
 void Scene::Render() {
     //! First update model matrices for all gameobjects
@@ -163,16 +268,38 @@ void Scene::Render() {
         transform.UpdateTransform();
     }
 
+    //! Sort tilemaps and sprites (only when a key changed)
+    SortRenderers();
+
+    //! Everything outside of this bounds is culled
+    cullInfo = RenderCullInfo{};
+    Bounds2D viewBounds {vec2::ninf, vec2::inf};
+    if (useCulling)
+        viewBounds = Camera::GetMainCamera().GetViewBounds();
+
+    //! Time the tilemap pass on the gpu (the result of the previous frame is read once available, so the pipeline never stalls)
+    if (tilemapTimerQuery == 0)
+        glCreateQueries(GL_TIME_ELAPSED, 1, &tilemapTimerQuery);
+    if (isTilemapTimerPending) {
+        GLint available {GL_FALSE};
+        glGetQueryObjectiv(tilemapTimerQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 elapsed {0};
+            glGetQueryObjectui64v(tilemapTimerQuery, GL_QUERY_RESULT, &elapsed);
+            tilemapGpuTime = static_cast<float>(elapsed) / 1000000.0f;
+            isTilemapTimerPending = false;
+        }
+    }
+    bool timeTilemaps {!isTilemapTimerPending};
+    if (timeTilemaps)
+        glBeginQuery(GL_TIME_ELAPSED, tilemapTimerQuery);
+
     //! Render tilemaps
-    entityRegistry.sort<TilemapRenderer>([](const TilemapRenderer& a, const TilemapRenderer& b) {
-        return a.GetLayer() < b.GetLayer();
-    });
-    entityRegistry.sort<Transform, TilemapRenderer>();  //+ Also sort Transform in order to reduce cache misses
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_BLEND);
-    glEnable(GL_CULL_FACE); //! Face culling only tilemaps since sprites can swap x scale to flip around (and for optimizing tilemap rendering)
-    auto tilemapShader {AssetManager::GetShader("tilemap")};
-    tilemapShader->Use();
+    GLState::SetBlend(BlendMode::Alpha);
+    GLState::SetCullFace(true); //! Face culling only tilemaps since sprites can swap x scale to flip around (and for optimizing tilemap rendering)
+    TilemapRenderMode activeTilemapMode {TilemapRenderMode::GeometryShader};
+    Ref<Shader> tilemapShader;
+    UniformHandle modelUniform, tileSizeUniform, atlasTexSizeUniform, tileAnimationCountUniform;
     for (auto&& [entity, tilemap, transform] : entityRegistry.view<TilemapRenderer, Transform>().each()) {
         if (!tilemap.IsConstructed())
             continue;
@@ -180,22 +307,51 @@ void Scene::Render() {
         // Update tilemap buffer data to gpu
         tilemap.UpdateBufferData();
 
-        tilemapShader->SetIVec2("mapSize", glm::ivec2{tilemap.GetSize().x, tilemap.GetSize().y});
-        tilemapShader->SetMatrix4("model", transform.GetModel());
-        tilemapShader->SetInt("tileSize", tilemap.GetTileSize());
-        tilemapShader->SetIVec2("atlasTexSize", tilemap.GetAtlasTexSize());
+        uint32_t tileCount {static_cast<uint32_t>(tilemap.GetSize().x * tilemap.GetSize().y)};
+        glm::ivec2 firstTile {0, 0};
+        glm::ivec2 lastTile {tilemap.GetSize()};
+        if (useCulling && !tilemap.GetVisibleTileRange(transform.GetModel(), viewBounds, &firstTile, &lastTile)) {
+            cullInfo.tilesCulled += tileCount;
+            continue;
+        }
+
+        //+ Each tilemap may use a different render mode, the shader only changes when it differs from the previous one
+        if (!tilemapShader || tilemap.GetRenderMode() != activeTilemapMode) {
+            activeTilemapMode = tilemap.GetRenderMode();
+            tilemapShader = AssetManager::GetShader(tilemap.GetShaderName());
+            tilemapShader->Use();
+            modelUniform = tilemapShader->GetUniform("model");
+            tileSizeUniform = tilemapShader->GetUniform("tileSize");
+            atlasTexSizeUniform = tilemapShader->GetUniform("atlasTexSize");
+            tileAnimationCountUniform = tilemapShader->GetUniform("tileAnimationCount");
+        }
+        tilemapShader->SetMatrix4(modelUniform, transform.GetModel());
+        tilemapShader->SetInt(tileSizeUniform, tilemap.GetTileSize());
+        tilemapShader->SetIVec2(atlasTexSizeUniform, tilemap.GetAtlasTexSize());
+        auto tileAnimations {tilemap.GetTileAnimations()};
+        if (tileAnimations) {
+            if (tileAnimations->IsDirty())
+                tileAnimations->Upload();
+            tileAnimations->Use();
+        }
+        tilemapShader->SetInt(tileAnimationCountUniform, tileAnimations ? static_cast<int>(tileAnimations->GetEntryCount()) : 0);
         tilemap.GetTextureAtlas()->Use();
-        tilemap.GetMesh()->Use();
-        tilemap.GetMesh()->Draw();
+        uint32_t submittedTiles {tilemap.Draw(*tilemapShader, firstTile, lastTile)};
+        cullInfo.tilesSubmitted += submittedTiles;
+        cullInfo.tilesCulled += tileCount - submittedTiles;
+    }
+    GLState::SetCullFace(false);
+    if (timeTilemaps) {
+        glEndQuery(GL_TIME_ELAPSED);
+        isTilemapTimerPending = true;
     }
-    glDisable(GL_CULL_FACE);
+
+    //! Prepare static sprites (only the chunks that changed are rebuilt), their ranges are drawn between the dynamic sprites
+    staticSprites.Prepare(viewBounds);
+    cullInfo.staticChunksDrawn = staticSprites.GetDrawnChunks();
+    cullInfo.staticChunksCulled = staticSprites.GetChunkCount() - staticSprites.GetDrawnChunks();
 
     //! Render sprites
-    entityRegistry.sort<SpriteRenderer>([](const SpriteRenderer& a, const SpriteRenderer& b) {
-        return a.renderOrder < b.renderOrder;
-        // TODO: Add texture id check so it is also considered but with less impact than render order
-    });
-    entityRegistry.sort<Transform, SpriteRenderer>(); //+ Also sort Transform in order to reduce cache misses
     // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     // glEnable(GL_BLEND);
     auto spriteShader{AssetManager::GetShader("spriteOld")};
@@ -206,8 +362,40 @@ void Scene::Render() {
     Texture* activeTexture {};
 #else
     SpriteBatch::Start();
+    SpriteInstanceBatch::Start();
+    bool bulkSubmission {SpriteBatch::useBulkSubmission && !SpriteInstanceBatch::useInstancing};
+    spriteDrawItems.clear();
 #endif  // SPRITE_BATCHING
-    for (auto&& [entity, sprite, transform] : entityRegistry.view<SpriteRenderer, Transform>().each()) {
+    //+ Draws the dynamic sprites submitted so far followed by the static ranges up to maxSortKey
+    auto drawStaticSprites {[&](uint64_t maxSortKey) {
+#ifndef SPRITE_BATCHING
+        staticSprites.DrawUpTo(maxSortKey);
+        spriteShader->Use();
+        spriteVAO->Use();
+        activeTexture = nullptr;
+#else
+        if (bulkSubmission) {
+            SpriteBatch::DrawSprites(spriteDrawItems.data(), static_cast<uint32_t>(spriteDrawItems.size()));
+            spriteDrawItems.clear();
+        }
+        SpriteInstanceBatch::Flush(FlushCause::BatchChange);
+        staticSprites.DrawUpTo(maxSortKey);
+        SpriteBatch::Start();
+        SpriteInstanceBatch::Start();
+#endif  // SPRITE_BATCHING
+    }};
+    for (auto&& [entity, sprite, transform] : entityRegistry.view<SpriteRenderer, Transform>(entt::exclude<StaticSprite>).each()) {
+        if (useCulling && !sprite.GetBounds(transform).Overlaps(viewBounds)) {
+            ++cullInfo.spritesCulled;
+            continue;
+        }
+        ++cullInfo.spritesSubmitted;
+
+        //! Static ranges of a lower (or the same) render order go first, the sprites are iterated in sort key order
+        uint64_t renderOrderEnd {sprite.GetSortKey() | 0xffffffffull};
+        if (staticSprites.GetNextSortKey() <= renderOrderEnd)
+            drawStaticSprites(renderOrderEnd);
+
 #ifndef SPRITE_BATCHING
         if (!activeTexture || sprite.sprite->GetTexture()->GetID() != activeTexture->GetID()) {
             activeTexture = sprite.sprite->GetTexture().get();
@@ -224,11 +412,25 @@ void Scene::Render() {
         spriteShader->SetVec2("pivot", sprite.pivot);
         spriteVAO->Draw();
 #else
-        SpriteBatch::DrawSprite(transform, sprite);
+        if (bulkSubmission)
+            spriteDrawItems.push_back(SpriteDrawItem{&transform, &sprite, 0});
+        else if (SpriteInstanceBatch::useInstancing)
+            SpriteInstanceBatch::DrawSprite(transform, sprite);
+        else
+            SpriteBatch::DrawSprite(transform, sprite);
 #endif  // SPRITE_BATCHING
     }
-    SpriteBatch::Flush();
-    glDisable(GL_BLEND);
+#ifdef SPRITE_BATCHING
+    if (bulkSubmission)
+        SpriteBatch::DrawSprites(spriteDrawItems.data(), static_cast<uint32_t>(spriteDrawItems.size()));
+#endif  // SPRITE_BATCHING
+    SpriteInstanceBatch::Flush();
+    //! Static ranges above the render order of every dynamic sprite
+    staticSprites.DrawUpTo(UINT64_MAX);
+    GLState::SetBlend(BlendMode::None);
+
+    RenderStats::AddTiles(cullInfo.tilesSubmitted);
+    RenderStats::AddCulled(cullInfo.spritesCulled, cullInfo.staticChunksCulled, cullInfo.tilesCulled);
 }
 
 void Scene::UpdateGameObjects() {
@@ -2,6 +2,8 @@
 #define __SCENE_H__
 
 #include "Common.hpp"
+#include "Rendering/Batch.hpp"
+#include "Rendering/StaticSpriteLayer.hpp"
 
 #include <entt/entity/registry.hpp>
 #include <vector>
@@ -9,6 +11,25 @@
 class Engine;
 class GameObject;
 
+struct RenderSortInfo {
+    // Components whose sort key changed since the last frame
+    uint32_t spritesChanged     {0};
+    uint32_t tilemapsChanged    {0};
+    bool spritesSorted          {false};
+    bool tilemapsSorted         {false};
+    // Time spent refreshing the keys and sorting, in milliseconds
+    float sortTime              {0.0f};
+};
+
+struct RenderCullInfo {
+    uint32_t spritesSubmitted   {0};
+    uint32_t spritesCulled      {0};
+    uint32_t staticChunksDrawn  {0};
+    uint32_t staticChunksCulled {0};
+    uint32_t tilesSubmitted     {0};
+    uint32_t tilesCulled        {0};
+};
+
 class Scene {
 public:
     Scene(Engine* engine);
@@ -57,6 +78,16 @@ public:
     virtual void DebugGUI() { }
 
     Engine* GetEngine() { return engine; }
+    // Sorting information of the last rendered frame
+    const RenderSortInfo& GetSortInfo() const { return sortInfo; }
+    const StaticSpriteLayer& GetStaticSprites() const { return staticSprites; }
+    // Culling information of the last rendered frame
+    const RenderCullInfo& GetCullInfo() const { return cullInfo; }
+    // Gpu time of the tilemap pass in milliseconds, a frame or more behind
+    float GetTilemapGpuTime() const { return tilemapGpuTime; }
+
+    // Skip the sprites, static chunks and tiles outside of the main camera view
+    static bool useCulling;
 
 protected:
     virtual void LastUpdate() {}
@@ -66,6 +97,12 @@ private:
     void Render();
 
     void UpdateGameObjects();
+    // Refreshes the queued sort keys and sorts the renderers (and their transforms) if any of them changed
+    void SortRenderers();
+
+    // Queue the component to refresh its sort key before the next render
+    void OnSpriteChanged(entt::registry& registry, entt::entity entity);
+    void OnTilemapChanged(entt::registry& registry, entt::entity entity);
     
 protected:
     Engine* engine;
@@ -76,10 +113,24 @@ protected:
     bool isAnyGameObjectDead {false};
     bool firstLoop           {true};
 
+    RenderSortInfo sortInfo;
+    //! Entities whose sort key must be refreshed, only these are checked every frame instead of the whole pools
+    std::vector<entt::entity> dirtySpriteKeys;
+    std::vector<entt::entity> dirtyTilemapKeys;
+    RenderCullInfo cullInfo;
+    uint32_t tilemapTimerQuery  {0};
+    bool isTilemapTimerPending  {false};
+    float tilemapGpuTime        {0.0f};
+    // Reused every frame to submit the sprites in bulk
+    std::vector<SpriteDrawItem> spriteDrawItems;
+    //! Declared after the registry and the gameobjects so it is destroyed (and disconnected from the registry) first
+    StaticSpriteLayer staticSprites {entityRegistry};
+
     friend class Engine;
     friend class GameObject;
     friend class Renderer;
     friend class Scene;
+    friend class SelfTests;
 };
 
 #endif // __SCENE_H__
\ No newline at end of file
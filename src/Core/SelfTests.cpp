@@ -0,0 +1,472 @@
+#include "SelfTests.hpp"
+
+#include "AssetManager.hpp"
+#include "Autotile.hpp"
+#include "Components.hpp"
+#include "Log.hpp"
+#include "Scene.hpp"
+#include "Time.hpp"
+#include "Rendering/Batch.hpp"
+#include "Rendering/Camera.hpp"
+#include "Rendering/RenderBackend.hpp"
+#include "Rendering/RenderCommands.hpp"
+#include "Rendering/Sprite.hpp"
+#include "UI/Image.hpp"
+#include "UI/Text/GlyphCache.hpp"
+#include "Utils/Random.hpp"
+
+#include <cstring>
+#include <fmt/core.h>
+#include <glm/gtc/quaternion.hpp>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+bool SelfTests::Run() {
+    bool passed {true};
+    passed &= CheckSpriteQuadKernels();
+    passed &= CheckScatteredTileUpload();
+    passed &= CheckUICommandStream();
+    passed &= CheckIncrementalSortKeys();
+    passed &= CheckIncrementalAutotile();
+    passed &= CheckTilemapRenderModes();
+    passed &= CheckGlyphHashMap();
+    passed &= CheckGlyphShelfEviction();
+
+    if (passed) {
+        LOG_INFO("Self tests passed.");
+    }
+    else {
+        LOG_ERROR("Self tests failed.");
+    }
+    return passed;
+}
+
+bool SelfTests::CheckSpriteQuadKernels() {
+    constexpr uint32_t count {4096};
+
+    //+ Sprites with random transforms (rotated, flipped and far from the origin), pivots and colors
+    std::vector<Ref<Sprite>> sprites {
+        MakeRef<Sprite>(AssetManager::GetTexture("missing")),
+        MakeRef<Sprite>(AssetManager::GetTexture("player0_spritesheet"), glm::ivec2{64, 224}, glm::ivec2{16, 16})
+    };
+    std::vector<Transform> transforms(count);
+    std::vector<SpriteRenderer> spriteRenderers(count);
+    std::vector<SpriteDrawItem> items(count);
+    for (uint32_t i {0}; i < count; ++i) {
+        Transform& transform {transforms[i]};
+        transform.SetPosition(glm::vec3{Random::Range(-4096.0f, 4096.0f), Random::Range(-4096.0f, 4096.0f), Random::Range(-1.0f, 1.0f)});
+        transform.SetRotation(glm::angleAxis(Random::Range(-3.14159f, 3.14159f), glm::vec3{0.0f, 0.0f, 1.0f}));
+        transform.SetScale(glm::vec3{Random::Range(0.1f, 8.0f) * (Random::Range(0, 1) != 0 ? -1.0f : 1.0f),
+                                     Random::Range(0.1f, 8.0f) * (Random::Range(0, 1) != 0 ? -1.0f : 1.0f), 1.0f});
+        transform.UpdateTransform();
+
+        SpriteRenderer& spriteRenderer {spriteRenderers[i]};
+        spriteRenderer.sprite = sprites[Random::Range(0, static_cast<int>(sprites.size()) - 1)];
+        spriteRenderer.color = Color{static_cast<uint8_t>(Random::Range(0, 255)), static_cast<uint8_t>(Random::Range(0, 255)),
+                                     static_cast<uint8_t>(Random::Range(0, 255)), static_cast<uint8_t>(Random::Range(0, 255))};
+        spriteRenderer.pivot = glm::vec2{Random::Range(0.0f, 1.0f), Random::Range(0.0f, 1.0f)};
+
+        items[i] = SpriteDrawItem{&transform, &spriteRenderer, Random::Range(0, 31)};
+    }
+
+    uint32_t mismatches {CompareSpriteQuadKernels(items.data(), count)};
+    if (mismatches > 0) {
+        LOG_ERROR("Sprite quad kernels: {} of {} quads differ between the scalar and the SIMD kernel.", mismatches, count);
+        return false;
+    }
+
+    LOG_INFO("Sprite quad kernels: {} quads match.", count);
+    return true;
+}
+
+bool SelfTests::CheckScatteredTileUpload() {
+    bool passed {true};
+    for (TilemapRenderMode mode : {TilemapRenderMode::GeometryShader, TilemapRenderMode::TileTexture}) {
+        TilemapRenderer tilemap {nullptr, glm::ivec2{64, 64}, 16, AssetManager::GetTexture("pit0_spritesheet")};
+        tilemap.SetRenderMode(mode);
+        for (int y {0}; y < tilemap.GetSize().y; ++y) {
+            for (int x {0}; x < tilemap.GetSize().x; ++x)
+                tilemap.SetTile(x, y, 1);
+        }
+        tilemap.UpdateBufferData();
+
+        // Opposite corners plus two tiles of the same row: 3 ranges, 2 + 2 + 5 * 2 bytes
+        auto toggle {[&tilemap](int x, int y) { tilemap.SetTile(x, y, tilemap.GetTile(x, y) == 1 ? 2 : 1); }};
+        toggle(0, 0);
+        toggle(tilemap.GetSize().x - 1, tilemap.GetSize().y - 1);
+        toggle(5, 2);
+        toggle(9, 2);
+        tilemap.UpdateBufferData();
+
+        // The tile textures upload whole chunk rows instead: 3 * 32 * 2 bytes
+        const char* modeName {mode == TilemapRenderMode::TileTexture ? "tile texture" : "geometry shader"};
+        uint32_t expectedBytes {mode == TilemapRenderMode::TileTexture ? 192u : 14u};
+        const TilemapUploadStats& stats {tilemap.GetUploadStats()};
+        if (stats.uploadedBytes != expectedBytes || stats.uploadCalls != 3) {
+            LOG_ERROR("Scattered tile upload ({}): {} bytes in {} calls, expected {} bytes in 3 calls.", modeName,
+                      stats.uploadedBytes, stats.uploadCalls, expectedBytes);
+            passed = false;
+            continue;
+        }
+        LOG_INFO("Scattered tile upload ({}): {} bytes in {} calls.", modeName, stats.uploadedBytes, stats.uploadCalls);
+    }
+    return passed;
+}
+
+bool SelfTests::CheckUICommandStream() {
+    auto guiShader {AssetManager::GetShader("gui")};
+    auto guiVao {AssetManager::GetVertexArray("gui")};
+    auto sprite {MakeRef<Sprite>(AssetManager::GetTexture("gui0"))};
+
+    //+ Clipping image with a child image, recorded like the UI pass of Renderer::Draw, followed by a world draw that
+    //+ must still be executed first
+    Image parent {Rect{glm::vec2{16.0f, 16.0f}, glm::vec2{128.0f, 64.0f}}, sprite};
+    parent.clipChildren = true;
+    Image* child {static_cast<Image*>(parent.AddChild(MakeOwned<Image>(Rect{glm::vec2{24.0f, 24.0f}, glm::vec2{32.0f, 32.0f}}, sprite)))};
+    child->color = glm::vec4{1.0f, 0.5f, 0.25f, 0.75f};
+
+    RenderCommandList& commands {RenderQueue::GetList()};
+    commands.GetState().blend = BlendMode::AlphaOverwrite;
+    parent.Render();
+    commands.SetState(RenderState{});
+    commands.Record(commands.NextSequentialKey(RenderPass::World), *guiShader, *guiVao);
+
+    RecordingRenderBackend backend;
+    RenderQueue::Execute(backend);
+
+    //+ Expected stream
+    struct ExpectedCommand {
+        RenderPass pass;
+        uint32_t texture;
+        BlendMode blend;
+        bool scissorTest;
+        std::vector<UniformType> uniforms;
+        std::vector<uint8_t> uniformData; // Values of the uniforms packed in the same order
+    };
+    // model, spriteMinUV, spriteMaxUV, color, flipX, flipY and useVirtualResolution
+    std::vector<UniformType> imageUniforms {UniformType::Mat4, UniformType::Vec2, UniformType::Vec2, UniformType::Vec4,
+                                            UniformType::Int, UniformType::Int, UniformType::Int};
+    auto imageValues {[&sprite](const Image& image) {
+        std::vector<uint8_t> data;
+        auto append {[&data](const auto& value) {
+            const uint8_t* bytes {reinterpret_cast<const uint8_t*>(&value)};
+            data.insert(data.end(), bytes, bytes + sizeof(value));
+        }};
+        append(image.GetModel());
+        append(sprite->GetMinUV());
+        append(sprite->GetMaxUV());
+        append(image.color);
+        append(static_cast<int>(sprite->flipX));
+        append(static_cast<int>(sprite->flipY));
+        append(1);
+        return data;
+    }};
+    uint32_t texture {sprite->GetTexture()->GetID()};
+    std::vector<ExpectedCommand> expected {
+        {RenderPass::World, 0, BlendMode::None, false, {}, {}},
+        {RenderPass::UI, texture, BlendMode::AlphaOverwrite, false, imageUniforms, imageValues(parent)},
+        {RenderPass::UI, texture, BlendMode::AlphaOverwrite, true, imageUniforms, imageValues(*child)}
+    };
+    Rect scissorRect {Camera::GetMainCamera().RectFromVirtual2ScreenSize(parent.GetRect(), true)};
+    glm::ivec4 expectedScissor {static_cast<int>(scissorRect.position.x), static_cast<int>(scissorRect.position.y),
+                                static_cast<int>(scissorRect.size.x), static_cast<int>(scissorRect.size.y)};
+
+    //+ Compare
+    auto fail {[](const std::string& reason) {
+        LOG_ERROR("UI command stream: {}.", reason);
+        return false;
+    }};
+    const std::vector<DrawCommand>& executed {backend.GetCommands()};
+    if (executed.size() != expected.size())
+        return fail(fmt::format("{} commands executed, expected {}", executed.size(), expected.size()));
+    if (backend.GetFinishedLists() != 1)
+        return fail(fmt::format("{} lists finished, expected 1", backend.GetFinishedLists()));
+
+    for (size_t i {0}; i < executed.size(); ++i) {
+        const DrawCommand& command {executed[i]};
+        const ExpectedCommand& expectedCommand {expected[i]};
+        if (static_cast<RenderPass>(command.sortKey >> 56) != expectedCommand.pass)
+            return fail(fmt::format("command {} is in pass {}", i, command.sortKey >> 56));
+        if (i > 0 && command.sortKey <= executed[i - 1].sortKey)
+            return fail(fmt::format("command {} is not sorted after the previous one", i));
+        if (command.shader != guiShader.get() || command.vertexArray != guiVao->GetID())
+            return fail(fmt::format("command {} uses another shader or vertex array", i));
+        if (command.textures[0] != expectedCommand.texture)
+            return fail(fmt::format("command {} binds texture {}, expected {}", i, command.textures[0], expectedCommand.texture));
+        if (command.state.blend != expectedCommand.blend || command.state.scissorTest != expectedCommand.scissorTest ||
+            (expectedCommand.scissorTest && command.state.scissor != expectedScissor))
+            return fail(fmt::format("command {} has another render state", i));
+        if (command.uniformCount != expectedCommand.uniforms.size())
+            return fail(fmt::format("command {} sets {} uniforms, expected {}", i, command.uniformCount, expectedCommand.uniforms.size()));
+        uint32_t expectedOffset {0};
+        for (uint32_t uniform {0}; uniform < command.uniformCount; ++uniform) {
+            const UniformCommand& recorded {backend.GetUniforms()[command.firstUniform + uniform]};
+            if (recorded.type != expectedCommand.uniforms[uniform])
+                return fail(fmt::format("uniform {} of command {} has another type", uniform, i));
+
+            uint32_t size {GetUniformSize(recorded.type)};
+            if (std::memcmp(&backend.GetUniformData()[recorded.dataOffset], &expectedCommand.uniformData[expectedOffset], size) != 0)
+                return fail(fmt::format("uniform {} of command {} has another value", uniform, i));
+            expectedOffset += size;
+        }
+    }
+
+    LOG_INFO("UI command stream: {} commands match.", executed.size());
+    return true;
+}
+
+bool SelfTests::CheckIncrementalSortKeys() {
+    constexpr uint32_t count {20000};
+    constexpr uint32_t changes {16};
+
+    // Only sorted, never updated or rendered, so it needs no engine
+    Scene scene {nullptr};
+    entt::registry& registry {scene.entityRegistry};
+    auto sprite {MakeRef<Sprite>(AssetManager::GetTexture("missing"))};
+    std::vector<entt::entity> entities(count);
+    for (entt::entity& entity : entities) {
+        entity = registry.create();
+        registry.emplace<Transform>(entity);
+        SpriteRenderer& spriteRenderer {registry.emplace<SpriteRenderer>(entity)};
+        spriteRenderer.sprite = sprite;
+        spriteRenderer.renderOrder = Random::Range(-100, 100);
+    }
+
+    auto isSorted {[&registry]() {
+        uint64_t previousKey {0};
+        for (auto&& [entity, spriteRenderer] : registry.view<SpriteRenderer>().each()) {
+            if (spriteRenderer.GetSortKey() < previousKey)
+                return false;
+            previousKey = spriteRenderer.GetSortKey();
+        }
+        return true;
+    }};
+    auto fail {[](const std::string& reason) {
+        LOG_ERROR("Incremental sort keys: {}.", reason);
+        return false;
+    }};
+
+    //+ The added sprites are queued by on_construct, the next frame without changes must not touch the pool
+    scene.SortRenderers();
+    if (!scene.sortInfo.spritesSorted || scene.sortInfo.spritesChanged != count || !isSorted())
+        return fail(fmt::format("the first sort refreshed {} keys and left the pool {}", scene.sortInfo.spritesChanged,
+                                isSorted() ? "sorted" : "out of order"));
+    scene.SortRenderers();
+    if (scene.sortInfo.spritesSorted || scene.sortInfo.spritesChanged != 0)
+        return fail(fmt::format("a frame without changes refreshed {} keys", scene.sortInfo.spritesChanged));
+    float unchangedTime {scene.sortInfo.sortTime};
+
+    //+ A few patched sprites moved above every other one (the insertion sort path)
+    for (uint32_t i {0}; i < changes; ++i) {
+        entt::entity entity {entities[i * (count / changes)]};
+        registry.get<SpriteRenderer>(entity).renderOrder = 200 + static_cast<int>(i);
+        registry.patch<SpriteRenderer>(entity);
+    }
+    scene.SortRenderers();
+    if (scene.sortInfo.spritesChanged != changes || !isSorted())
+        return fail(fmt::format("{} patched sprites refreshed {} keys and left the pool {}", changes, scene.sortInfo.spritesChanged,
+                                isSorted() ? "sorted" : "out of order"));
+    float incrementalTime {scene.sortInfo.sortTime};
+
+    //+ Reference: refreshing every key each frame like before the keys were queued
+    uint64_t fullStart {Time::GetPerformanceCounter()};
+    for (auto&& [entity, spriteRenderer] : registry.view<SpriteRenderer>().each())
+        spriteRenderer.UpdateSortKey();
+    float fullRefreshTime {Time::GetMilisecondsSince(fullStart)};
+
+#ifndef NDEBUG
+    //+ Debug builds also catch keys changed without patching the component (this logs the expected warning)
+    registry.get<SpriteRenderer>(entities[1]).renderOrder = 1000;
+    scene.SortRenderers();
+    if (scene.sortInfo.spritesChanged != 1 || !isSorted())
+        return fail("a key changed without patching the component was not refreshed");
+#endif // NDEBUG
+
+    LOG_INFO("Incremental sort keys: {} sprites, frame without changes {:.3f} ms, {} patched sprites {:.3f} ms, "
+             "refreshing every key {:.3f} ms.", count, unchangedTime, changes, incrementalTime, fullRefreshTime);
+    return true;
+}
+
+bool SelfTests::CheckIncrementalAutotile() {
+    constexpr int edits {512};
+
+    bool passed {true};
+    for (AutotileMode mode : {AutotileMode::FourNeighbours, AutotileMode::EightNeighbours}) {
+        // The atlas has no real blob set, so the tiles are consecutive ids just to exercise the autotiling
+        std::vector<uint16_t> tiles(mode == AutotileMode::FourNeighbours ? AutotileSet::fourNeighboursTileCount : AutotileSet::eightNeighboursTileCount);
+        std::iota(tiles.begin(), tiles.end(), 1);
+        AutotileSet set {mode, tiles};
+        const char* modeName {mode == AutotileMode::FourNeighbours ? "4 neighbours" : "8 neighbours"};
+
+        //+ Random floor autotiled in a full pass (timed, the 1024x1024 region of the stress test)
+        TilemapRenderer tilemap {nullptr, glm::ivec2{1024, 1024}, 16, AssetManager::GetTexture("pit0_spritesheet")};
+        for (int y {0}; y < tilemap.GetSize().y; ++y) {
+            for (int x {0}; x < tilemap.GetSize().x; ++x)
+                tilemap.SetTile(x, y, Random::Range(0, 2) != 0 ? set.GetDefaultTile() : 0);
+        }
+        uint64_t start {Time::GetPerformanceCounter()};
+        tilemap.Autotile(set);
+        float fullTime {Time::GetMilisecondsSince(start)};
+
+        //+ Random incremental edits, then a full pass over the result must not change any tile
+        for (int i {0}; i < edits; ++i)
+            tilemap.SetAutotile(Random::Range(0, tilemap.GetSize().x - 1), Random::Range(0, tilemap.GetSize().y - 1), set, Random::Range(0, 1) != 0);
+        std::vector<tile_t> incremental;
+        incremental.reserve(tilemap.GetSize().x * tilemap.GetSize().y);
+        for (int y {0}; y < tilemap.GetSize().y; ++y) {
+            for (int x {0}; x < tilemap.GetSize().x; ++x)
+                incremental.push_back(tilemap.GetTile(x, y));
+        }
+        tilemap.Autotile(set);
+
+        uint32_t mismatches {0};
+        for (int y {0}; y < tilemap.GetSize().y; ++y) {
+            for (int x {0}; x < tilemap.GetSize().x; ++x)
+                mismatches += tilemap.GetTile(x, y) != incremental[x + y * tilemap.GetSize().x] ? 1 : 0;
+        }
+        if (mismatches > 0) {
+            LOG_ERROR("Incremental autotile ({}): {} tiles differ from a full pass after {} edits.", modeName, mismatches, edits);
+            passed = false;
+            continue;
+        }
+        LOG_INFO("Incremental autotile ({}): {} edits match a full pass, full pass of {}x{} tiles in {:.3f} ms.", modeName,
+                 edits, tilemap.GetSize().x, tilemap.GetSize().y, fullTime);
+    }
+    return passed;
+}
+
+bool SelfTests::CheckTilemapRenderModes() {
+    constexpr int mapSize {512};
+    constexpr int drawRepeats {64};
+
+    // Not aligned to the chunks, so the partially visible chunks are drawn too
+    const glm::ivec2 firstTile {40, 23};
+    const glm::ivec2 lastTile {mapSize - 17, mapSize - 50};
+    const uint32_t expectedTiles {static_cast<uint32_t>((lastTile.x - firstTile.x) * (lastTile.y - firstTile.y))};
+
+    bool passed {true};
+    for (TilemapRenderMode mode : {TilemapRenderMode::GeometryShader, TilemapRenderMode::TileTexture}) {
+        TilemapRenderer tilemap {nullptr, glm::ivec2{mapSize, mapSize}, 16, AssetManager::GetTexture("pit0_spritesheet")};
+        tilemap.SetRenderMode(mode);
+        for (int y {0}; y < mapSize; ++y) {
+            for (int x {0}; x < mapSize; ++x)
+                tilemap.SetTile(x, y, static_cast<tile_t>(1 + (x + y) % 4));
+        }
+
+        uint64_t start {Time::GetPerformanceCounter()};
+        tilemap.UpdateBufferData();
+        float uploadTime {Time::GetMilisecondsSince(start)};
+
+        auto shader {AssetManager::GetShader(tilemap.GetShaderName())};
+        shader->Use();
+        uint32_t submittedTiles {0};
+        start = Time::GetPerformanceCounter();
+        for (int i {0}; i < drawRepeats; ++i)
+            submittedTiles = tilemap.Draw(*shader, firstTile, lastTile);
+        float drawTime {Time::GetMilisecondsSince(start) / drawRepeats};
+
+        const char* modeName {mode == TilemapRenderMode::TileTexture ? "tile texture" : "geometry shader"};
+        if (submittedTiles != expectedTiles) {
+            LOG_ERROR("Tilemap render modes ({}): {} tiles submitted, expected {}.", modeName, submittedTiles, expectedTiles);
+            passed = false;
+            continue;
+        }
+        LOG_INFO("Tilemap render modes ({}): {:.1f} KB uploaded in {:.3f} ms, {} tiles submitted in {:.3f} ms per draw.", modeName,
+                 tilemap.GetUploadStats().uploadedBytes / 1024.0f, uploadTime, submittedTiles, drawTime);
+    }
+    return passed;
+}
+
+bool SelfTests::CheckGlyphHashMap() {
+    constexpr int operations {100000};
+    // Few keys compared to the operations, so the map grows and erases often go through long probe sequences
+    constexpr int keyCount {4096};
+
+    GlyphHashMap map;
+    std::unordered_map<uint64_t, int> reference;
+    for (int i {0}; i < operations; ++i) {
+        uint64_t key {static_cast<uint64_t>(Random::Range(1, keyCount))};
+        if (Random::Range(0, 2) != 0) {
+            map.Insert(key, i);
+            reference[key] = i;
+        }
+        else {
+            map.Erase(key);
+            reference.erase(key);
+        }
+
+        if (map.GetSize() != reference.size()) {
+            LOG_ERROR("Glyph hash map: {} entries after {} operations, expected {}.", map.GetSize(), i + 1, reference.size());
+            return false;
+        }
+    }
+
+    for (uint64_t key {1}; key <= keyCount; ++key) {
+        auto iter {reference.find(key)};
+        int expected {iter != reference.end() ? iter->second : -1};
+        if (map.Find(key) != expected) {
+            LOG_ERROR("Glyph hash map: key {} maps to {}, expected {}.", key, map.Find(key), expected);
+            return false;
+        }
+    }
+
+    LOG_INFO("Glyph hash map: {} operations match, {} entries.", operations, map.GetSize());
+    return true;
+}
+
+bool SelfTests::CheckGlyphShelfEviction() {
+    //+ A glyph that didn't fit, stored like GlyphCache::GetGlyph does
+    uint64_t failedKey {MakeGlyphKey(UINT16_MAX, 1, 'x')};
+    int failedIndex {static_cast<int>(GlyphCache::glyphs.size())};
+    GlyphCache::glyphs.push_back(CharacterInfo{glm::ivec2{0}, glm::ivec2{0}, glm::ivec2{0}, glm::vec2{0.0f}, 0, GlyphCache::failedShelf});
+    GlyphCache::glyphKeys.push_back(failedKey);
+    GlyphCache::lookup.Insert(failedKey, failedIndex);
+    GlyphCache::failedGlyphs.push_back(failedIndex);
+    uint32_t failedGeneration {GlyphCache::GetShelfGeneration(GlyphCache::failedShelf)};
+
+    //+ Small glyphs until a shelf is evicted. The shelves used this frame can't be, so a new frame starts whenever the
+    //+ pages are full of them
+    std::vector<uint32_t> generations;
+    for (const GlyphCache::Shelf& entry : GlyphCache::shelves)
+        generations.push_back(entry.generation);
+    uint32_t evictedShelves {GlyphCache::stats.evictedShelves};
+    uint32_t shelf {GlyphCache::noShelf};
+    int newFrames {0};
+    GlyphCache::NewFrame();
+    while (GlyphCache::stats.evictedShelves == evictedShelves) {
+        glm::ivec2 position;
+        int layer;
+        shelf = GlyphCache::Allocate(glm::ivec2{6, 6}, position, layer);
+        if (shelf == GlyphCache::noShelf) {
+            if (++newFrames > 1) {
+                LOG_ERROR("Glyph shelf eviction: the pages are full and no shelf was evicted.");
+                return false;
+            }
+            GlyphCache::NewFrame();
+            generations.clear();
+            for (const GlyphCache::Shelf& entry : GlyphCache::shelves)
+                generations.push_back(entry.generation);
+        }
+    }
+
+    //+ Only the shelf that got the glyph was evicted
+    if (shelf >= generations.size()) {
+        LOG_ERROR("Glyph shelf eviction: shelf {} was evicted but it was created this frame.", shelf);
+        return false;
+    }
+    for (uint32_t i {0}; i < generations.size(); ++i) {
+        uint32_t expected {generations[i] + (i == shelf ? 1 : 0)};
+        if (GlyphCache::GetShelfGeneration(i) != expected) {
+            LOG_ERROR("Glyph shelf eviction: shelf {} has generation {}, expected {}.", i, GlyphCache::GetShelfGeneration(i), expected);
+            return false;
+        }
+    }
+    if (GlyphCache::GetShelfGeneration(GlyphCache::failedShelf) != failedGeneration + 1 || GlyphCache::lookup.Find(failedKey) >= 0) {
+        LOG_ERROR("Glyph shelf eviction: the glyph that didn't fit was not dropped.");
+        return false;
+    }
+
+    LOG_INFO("Glyph shelf eviction: shelf {} evicted after filling {} shelves.", shelf, GlyphCache::shelves.size());
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef __SELFTESTS_H__
+#define __SELFTESTS_H__
+
+/**
+ * @brief Checks of engine behaviour that must hold bit for bit (vertex kernels, upload sizes...), run after a headless
+ * run with --self-test so they don't need a GPU. The self_tests CTest target runs them.
+ */
+class SelfTests {
+public:
+    // Runs every check, logging the result of each one. Returns false if any of them failed
+    static bool Run();
+
+private:
+    // The SIMD sprite kernel must write the same bytes as WriteSpriteQuad
+    static bool CheckSpriteQuadKernels();
+    // Scattered tile edits must upload only the modified row ranges, in both tilemap render modes
+    static bool CheckScatteredTileUpload();
+    // A known UI frame recorded in the render queue must execute as the expected command stream
+    static bool CheckUICommandStream();
+    // Only the patched sprites refresh their sort keys, and the pool must still end up in key order
+    static bool CheckIncrementalSortKeys();
+    // Incremental autotile edits must leave the same tiles a full pass picks, in both neighbourhood modes
+    static bool CheckIncrementalAutotile();
+    // Both tilemap render modes must submit the same tiles for a view that cuts through chunks. Logs the upload size and
+    // the cpu time of each mode (the gpu time is only shown by the tilemap timer of the debug window)
+    static bool CheckTilemapRenderModes();
+    // Random inserts and erases in the GlyphHashMap must match a std::unordered_map
+    static bool CheckGlyphHashMap();
+    // Filling the glyph pages must evict the least recently used shelf, increasing its generation and the one of the
+    // glyphs that didn't fit (run last, it fills the pages)
+    static bool CheckGlyphShelfEviction();
+};
+
+#endif // __SELFTESTS_H__
@@ -21,6 +21,14 @@ float Time::GetSecondsSinceStartup() {
     return SDL_GetTicks() / 1000.f;
 }
 
+uint64_t Time::GetPerformanceCounter() {
+    return SDL_GetPerformanceCounter();
+}
+
+float Time::GetMilisecondsSince(uint64_t counter) {
+    return static_cast<float>((SDL_GetPerformanceCounter() - counter) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
 void Time::BeginFrame() {
     // Limit frame rate (60 fps)
     while (!SDL_TICKS_PASSED(SDL_GetTicks(), _ticksCount + 16));
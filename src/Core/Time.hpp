@@ -9,6 +9,9 @@ public:
     static uint32_t GetMilisecondsSinceStartup();
     // Real time in seconds since the game started
     static float GetSecondsSinceStartup();
+    // High resolution counter, use it with GetMilisecondsSince to measure small intervals of time
+    static uint64_t GetPerformanceCounter();
+    static float GetMilisecondsSince(uint64_t counter);
     
 private:
     static void BeginFrame();
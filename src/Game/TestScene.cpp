@@ -2,9 +2,11 @@
 
 #include "Battlers.hpp"
 #include "Core/AssetManager.hpp"
+#include "Core/Autotile.hpp"
 #include "Core/Components.hpp"
 #include "Core/Engine.hpp"
 #include "Core/GameObject.hpp"
+#include "Core/Time.hpp"
 #include "Rendering/Sprite.hpp"
 #include "PlayerTest.hpp"
 #include "TilemapTest.hpp"
@@ -16,6 +18,7 @@
 #include "Rendering/Camera.hpp"
 #include "Rendering/Sprite.hpp"
 #include "Rendering/Texture.hpp"
+#include "Rendering/TileAnimationTable.hpp"
 #include "UI/Image.hpp"
 #include "UI/Label.hpp"
 #include "UI/Panel.hpp"
@@ -30,6 +33,7 @@
 #include "UI/UI.hpp"
 
 #include <imgui.h>
+#include <numeric>
 
 TestScene::TestScene(Engine* engine) 
     : Scene{engine} {
@@ -54,6 +58,23 @@ ScrollView* scrollviewTest {nullptr};
     Widget* testClip;
 #endif  // CLIP_TEST
 
+//+ Sprite sorting stress test
+std::vector<GameObject*> sortTestObjects;
+bool sortTestShuffle {false};
+float sortTestChangeRatio {0.01f};
+bool sortTestStatic {false};
+
+//+ Large tilemap stress test
+GameObject* largeTilemap {nullptr};
+bool largeTilemapEdits {false};
+int largeTilemapEditsPerFrame {64};
+TilemapRenderMode tilemapRenderMode {TilemapRenderMode::GeometryShader};
+AutotileSet autotileSet {AutotileMode::EightNeighbours, []() {
+    std::vector<uint16_t> tiles(AutotileSet::eightNeighboursTileCount);
+    std::iota(tiles.begin(), tiles.end(), 1);
+    return tiles;
+}()};
+
 // #define LAYER_TEST
 // #define NINE_SLICE_TEST
 #define ANCHOR_TEST
@@ -379,6 +400,23 @@ void TestScene::Load() {
 void TestScene::LastUpdate() {
     TurnManager::Instance().Update();
 
+    if (sortTestShuffle && !sortTestObjects.empty()) {
+        int changes {static_cast<int>(sortTestObjects.size() * sortTestChangeRatio)};
+        for (int i {0}; i < changes; ++i) {
+            auto go {sortTestObjects[Random::Range(0, static_cast<int>(sortTestObjects.size()) - 1)]};
+            go->GetComponent<SpriteRenderer>().renderOrder = Random::Range(-100, 100);
+            go->NotifyChanged<SpriteRenderer>(); // Rebuilds the chunk if the sprite is static
+        }
+    }
+
+    if (largeTilemap && largeTilemapEdits) {
+        auto& tilemap {largeTilemap->GetComponent<TilemapRenderer>()};
+        for (int i {0}; i < largeTilemapEditsPerFrame; ++i) {
+            tilemap.SetTile(Random::Range(0, tilemap.GetSize().x - 1), Random::Range(0, tilemap.GetSize().y - 1), 
+                            static_cast<tile_t>(Random::Range(1, 64)));
+        }
+    }
+
 #ifdef CLIP_TEST
     if (testClip) {
         if (Input::GetKeyDown(SDL_SCANCODE_O)) {
@@ -574,4 +612,88 @@ void TestScene::DebugGUI() {
         ImGui::Text("Content y: %f", scrollviewTest->Content()->GetPosition().y);
         ImGui::End();
     }
-}
\ No newline at end of file
+
+    ImGui::Begin("Sprite Sorting");
+    const RenderSortInfo& sortInfo {GetSortInfo()};
+    ImGui::Text("Sprite keys changed: %u", sortInfo.spritesChanged);
+    ImGui::Text("Sprites sorted: %s", sortInfo.spritesSorted ? "yes" : "no");
+    ImGui::Text("Tilemaps sorted: %s", sortInfo.tilemapsSorted ? "yes" : "no");
+    ImGui::Text("Sort time: %.3f ms", sortInfo.sortTime);
+    ImGui::Separator();
+    ImGui::Text("Stress test sprites: %zu", sortTestObjects.size());
+    if (ImGui::Button("Spawn 50k sprites")) {
+        auto sprite {MakeRef<Sprite>(AssetManager::GetTexture("player0_spritesheet"), glm::ivec2{64, 224}, glm::ivec2{16, 16})};
+        for (int i {0}; i < 50000; ++i) {
+            auto go {AddGameObject<GameObject>()};
+            go->AddCommponent<SpriteRenderer>(sprite, ColorNames::white, Random::Range(-100, 100));
+            go->GetComponent<Transform>().SetPosition(glm::vec2{Random::Range(-320.f, 320.f), Random::Range(-180.f, 180.f)});
+            if (sortTestStatic)
+                go->AddCommponent<StaticSprite>();
+            sortTestObjects.push_back(go);
+        }
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Static", &sortTestStatic);
+    ImGui::Checkbox("Change render orders every frame", &sortTestShuffle);
+    ImGui::SliderFloat("Changed ratio", &sortTestChangeRatio, 0.0f, 0.1f);
+    ImGui::End();
+
+    ImGui::Begin("Tilemap Chunks");
+    if (!largeTilemap && ImGui::Button("Create 4096x4096 tilemap")) {
+        glm::ivec2 size {4096, 4096};
+        largeTilemap = AddGameObject<GameObject>();
+        auto& tilemap {largeTilemap->AddCommponent<TilemapRenderer>(size, 16, AssetManager::GetTexture("pit0_spritesheet"), -1)};
+        tilemap.SetRenderMode(tilemapRenderMode);
+        for (int y {0}; y < size.y; ++y) {
+            for (int x {0}; x < size.x; ++x)
+                tilemap.SetTile(x, y, 34);
+        }
+    }
+    if (largeTilemap) {
+        auto& tilemap {largeTilemap->GetComponent<TilemapRenderer>()};
+        ImGui::Text("Chunks: %d x %d", tilemap.GetChunkCount().x, tilemap.GetChunkCount().y);
+        ImGui::Text("Last upload: %u bytes in %u calls", tilemap.GetUploadStats().uploadedBytes, tilemap.GetUploadStats().uploadCalls);
+        ImGui::Checkbox("Random edits every frame", &largeTilemapEdits);
+        ImGui::SliderInt("Edits per frame", &largeTilemapEditsPerFrame, 1, 1024);
+
+        //+ Autotiling (the atlas has no real blob set, so the 47 tiles are consecutive ids just to exercise the engine)
+        if (ImGui::Button("Autotile random 1024x1024 floor")) {
+            glm::ivec2 region {glm::min(tilemap.GetSize(), glm::ivec2{1024})};
+            for (int y {0}; y < region.y; ++y) {
+                for (int x {0}; x < region.x; ++x)
+                    tilemap.SetTile(x, y, Random::Range(0, 2) != 0 ? autotileSet.GetDefaultTile() : 0);
+            }
+
+            uint64_t start {Time::GetPerformanceCounter()};
+            tilemap.Autotile(autotileSet, glm::ivec2{0, 0}, region);
+            LOG_INFO("Autotiled {}x{} tiles in {} ms.", region.x, region.y, Time::GetMilisecondsSince(start));
+        }
+
+        // Every floor tile cycles through a few atlas tiles, resolved in the shader with no per frame CPU work
+        bool animatedTiles {tilemap.GetTileAnimations() != nullptr};
+        if (ImGui::Checkbox("Animated floor tiles", &animatedTiles)) {
+            if (animatedTiles) {
+                auto animations {MakeRef<TileAnimationTable>()};
+                animations->SetAnimation(34, {TileAnimationFrame{34, 0.5f}, TileAnimationFrame{35, 0.25f}, TileAnimationFrame{36, 0.25f}});
+                tilemap.SetTileAnimations(animations);
+            }
+            else {
+                tilemap.SetTileAnimations(nullptr);
+            }
+        }
+    }
+
+    //+ Render mode benchmark (applied to every tilemap of the scene)
+    ImGui::Separator();
+    ImGui::Text("Tilemap pass gpu time: %.3f ms", GetTilemapGpuTime());
+    int renderMode {static_cast<int>(tilemapRenderMode)};
+    bool modeChanged {ImGui::RadioButton("Geometry shader", &renderMode, static_cast<int>(TilemapRenderMode::GeometryShader))};
+    ImGui::SameLine();
+    modeChanged |= ImGui::RadioButton("Tile texture", &renderMode, static_cast<int>(TilemapRenderMode::TileTexture));
+    if (modeChanged) {
+        tilemapRenderMode = static_cast<TilemapRenderMode>(renderMode);
+        for (auto&& [entity, tilemap] : ViewComponents<TilemapRenderer>().each())
+            tilemap.SetRenderMode(tilemapRenderMode);
+    }
+    ImGui::End();
+}
@@ -1,14 +1,30 @@
 #include "Batch.hpp"
 
 #include "Core/AssetManager.hpp"
+#include "Buffer.hpp"
 #include "Core/Components.hpp"
+#include "Core/JobSystem.hpp"
+#include "RenderCommands.hpp"
 #include "Texture.hpp"
 #include "Shader.hpp"
 #include "Sprite.hpp"
+#include "TextureArray.hpp"
+#include "TextureAtlas.hpp"
 #include "Utils/MathExtras.hpp"
 #include "VertexArray.hpp"
 
 #include "UI/Text/TextRenderer.hpp"
+#include "Utils/FileSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPRITE_BATCH_SIMD
+#include <emmintrin.h>
+#endif
 
 // void InitBatchRenderers() {
 //     SpriteBatch::Init();
@@ -20,12 +36,20 @@
 std::unordered_map<Ref<class Texture>, int> SpriteBatch::textures;
 uint32_t SpriteBatch::currentTexture {0};
 
-std::vector<SpriteVertex> SpriteBatch::vertices {maxVertices};
+SpriteVertex* SpriteBatch::vertices {nullptr};
+uint32_t SpriteBatch::vertexCapacity {0};
 uint32_t SpriteBatch::currentVertex {0};
 
 uint32_t SpriteBatch::quadCount {0};
 
+bool SpriteBatch::useTextureArray {true};
+bool SpriteBatch::useBulkSubmission {true};
+bool SpriteBatch::validateBulkSubmission {false};
+std::atomic<uint32_t> SpriteBatch::bulkMismatches {0};
+
 int SpriteBatch::maxTextureSlots {32};
+SpriteBatchMode SpriteBatch::batchMode {SpriteBatchMode::TextureSlots};
+Ref<StreamingBuffer> SpriteBatch::vertexStream;
 
 void SpriteBatch::Init(int maxTextureUnits) {
     maxTextureSlots = maxTextureUnits;
@@ -51,9 +75,11 @@ void SpriteBatch::Init(int maxTextureUnits) {
         offset += 4; // vertices per quad
     }
 
+    // The vertices are sourced from the vertex stream at flush time
     AssetManager::AddVertexArray("spriteBatch",
-                                 MakeRef<VertexArray>(nullptr, maxVertices, spriteBatchLayout, BufferUsage::Dynamic,
+                                 MakeRef<VertexArray>(nullptr, 0, spriteBatchLayout, BufferUsage::Dynamic,
                                                       spriteIndices, maxIndices, BufferUsage::Static));
+    vertexStream = MakeRef<StreamingBuffer>(maxVertices * static_cast<uint32_t>(sizeof(SpriteVertex)), 3, static_cast<uint32_t>(sizeof(SpriteVertex)));
 
     //+ Shader samplers 2D set up 
     auto spriteShader {AssetManager::GetShader("sprite")};
@@ -72,35 +98,44 @@ void SpriteBatch::Start() {
     quadCount = 0;
 
     textures.clear();
+    ReserveVertices();
 }
 
-void SpriteBatch::Flush() {
+void SpriteBatch::Flush(FlushCause cause) {
     if (quadCount == 0)
         return;
 
-    AssetManager::GetShader("sprite")->Use();
+    RenderStats::AddFlush(cause);
+    RenderStats::AddDrawCalls();
+    RenderStats::AddSpriteQuads(quadCount);
+
+    uint32_t offset {vertexStream->Commit(currentVertex * sizeof(SpriteVertex))};
+    vertices = nullptr;
+    vertexCapacity = 0;
+
     auto vao {AssetManager::GetVertexArray("spriteBatch")};
     vao->Use();
-    vao->GetVertexBuffer().SetData(0, quadCount * 4 * sizeof(SpriteVertex), &vertices[0]);
+    vao->SetVertexBuffer(vertexStream->GetID(), offset, sizeof(SpriteVertex));
 
-    for (auto& [texture, samplerID] : textures) {
-        texture->Use(samplerID);
+    if (batchMode == SpriteBatchMode::TextureArray) {
+        AssetManager::GetShader("spriteArray")->Use();
+        TextureAtlas::GetPageArray()->Use(0);
+    }
+    else {
+        AssetManager::GetShader("sprite")->Use();
+        for (auto& [texture, samplerID] : textures) {
+            texture->Use(samplerID);
+        }
     }
 
     glDrawElements(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, nullptr);
 }
 
-void SpriteBatch::DrawSprite(Transform& transform, SpriteRenderer& spriteRenderer) {
-    if (currentVertex >= maxVertices) {
-        Flush();
-        Start();
-    }
-
-    auto& bl {vertices[currentVertex]};
-    auto& br {vertices[currentVertex + 1]};
-    auto& tl {vertices[currentVertex + 2]};
-    auto& tr {vertices[currentVertex + 3]};
+//+ Vertex kernels
+// Both kernels must produce the exact same vertices. The SIMD one keeps the same operations in the same order as 
+// glm's mat4 * vec4 ((c0 * x + c1 * y) + (c2 * z + c3 * w)) so the results are bit identical.
 
+void WriteSpriteQuad(SpriteVertex* out, const Transform& transform, const SpriteRenderer& spriteRenderer, int texIdx) {
     auto& sprite {spriteRenderer.sprite};
     glm::vec2 spriteSize {sprite->GetSize().x, sprite->GetSize().y};
     glm::vec2 pivotOffset = (spriteRenderer.pivot - glm::vec2{0.5f}) * glm::vec2{spriteSize.x, spriteSize.y};
@@ -109,58 +144,363 @@ void SpriteBatch::DrawSprite(Transform& transform, SpriteRenderer& spriteRendere
     glm::vec2 minUV {sprite->GetMinUV().x /*+ uvOffset*/, 1.0f - sprite->GetMaxUV().y /*- uvOffset*/};
     glm::vec2 maxUV {sprite->GetMaxUV().x /*- uvOffset*/, 1.0f - sprite->GetMinUV().y /*+ uvOffset*/};
 
-    int texIdx {0};
-    auto texIter {textures.find(sprite->GetTexture())};
-    if (texIter != textures.end()) {
-        texIdx = texIter->second;
-    }
-    else {
-        if (currentTexture >= maxTextureSlots) {
-            Flush();
-            Start();
-        }
-        texIdx = currentTexture;
-        textures.emplace(sprite->GetTexture(), currentTexture++);
-    }
-
     auto& spriteScale {transform.GetScale()};
     float scaleX {spriteScale.x / std::abs(spriteScale.x)};
     float scaleY {spriteScale.y / std::abs(spriteScale.y)};
 
-    bl.position = transform.GetModel() * glm::vec4{-0.5f * spriteSize.x - pivotOffset.x * scaleX, -0.5f * spriteSize.y - pivotOffset.y * scaleY, 0, 1};
+    float left {-0.5f * spriteSize.x - pivotOffset.x * scaleX};
+    float right {0.5f * spriteSize.x - pivotOffset.x * scaleX};
+    float bottom {-0.5f * spriteSize.y - pivotOffset.y * scaleY};
+    float top {0.5f * spriteSize.y - pivotOffset.y * scaleY};
+    glm::vec4 color {Color2Vec4(spriteRenderer.color)};
+
+    auto& bl {out[0]};
+    auto& br {out[1]};
+    auto& tl {out[2]};
+    auto& tr {out[3]};
+
+    bl.position = transform.GetModel() * glm::vec4{left, bottom, 0, 1};
     bl.uv = glm::vec2 {minUV.x, minUV.y};
-    bl.color = Color2Vec4(spriteRenderer.color);
+    bl.color = color;
     bl.texIndex = texIdx;
 
-    br.position = transform.GetModel() * glm::vec4{0.5f * spriteSize.x - pivotOffset.x * scaleX, -0.5f * spriteSize.y - pivotOffset.y * scaleY, 0, 1};
+    br.position = transform.GetModel() * glm::vec4{right, bottom, 0, 1};
     br.uv = glm::vec2 {maxUV.x, minUV.y};
-    br.color = Color2Vec4(spriteRenderer.color);
+    br.color = color;
     br.texIndex = texIdx;
 
-    tl.position = transform.GetModel() * glm::vec4{-0.5f * spriteSize.x - pivotOffset.x * scaleX, 0.5f * spriteSize.y - pivotOffset.y * scaleY, 0, 1};
+    tl.position = transform.GetModel() * glm::vec4{left, top, 0, 1};
     tl.uv = glm::vec2 {minUV.x, maxUV.y};
-    tl.color = Color2Vec4(spriteRenderer.color);
+    tl.color = color;
     tl.texIndex = texIdx;
 
-    tr.position = transform.GetModel() * glm::vec4{0.5f * spriteSize.x - pivotOffset.x * scaleX, 0.5f * spriteSize.y - pivotOffset.y * scaleY, 0, 1};
+    tr.position = transform.GetModel() * glm::vec4{right, top, 0, 1};
     tr.uv = glm::vec2 {maxUV.x, maxUV.y};
-    tr.color = Color2Vec4(spriteRenderer.color);
+    tr.color = color;
     tr.texIndex = texIdx;
+}
+
+#ifdef SPRITE_BATCH_SIMD
+static void WriteSpriteQuadSIMD(SpriteVertex* out, const Transform& transform, const SpriteRenderer& spriteRenderer, int texIdx) {
+    auto& sprite {spriteRenderer.sprite};
+    glm::vec2 spriteSize {sprite->GetSize().x, sprite->GetSize().y};
+    glm::vec2 pivotOffset = (spriteRenderer.pivot - glm::vec2{0.5f}) * glm::vec2{spriteSize.x, spriteSize.y};
+
+    glm::vec2 minUV {sprite->GetMinUV().x, 1.0f - sprite->GetMaxUV().y};
+    glm::vec2 maxUV {sprite->GetMaxUV().x, 1.0f - sprite->GetMinUV().y};
+
+    auto& spriteScale {transform.GetScale()};
+    float scaleX {spriteScale.x / std::abs(spriteScale.x)};
+    float scaleY {spriteScale.y / std::abs(spriteScale.y)};
+
+    float left {-0.5f * spriteSize.x - pivotOffset.x * scaleX};
+    float right {0.5f * spriteSize.x - pivotOffset.x * scaleX};
+    float bottom {-0.5f * spriteSize.y - pivotOffset.y * scaleY};
+    float top {0.5f * spriteSize.y - pivotOffset.y * scaleY};
+
+    auto& model {transform.GetModel()};
+    __m128 c0 {_mm_loadu_ps(&model[0][0])};
+    __m128 c1 {_mm_loadu_ps(&model[1][0])};
+    // z = 0 and w = 1 for every corner
+    __m128 zw {_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&model[2][0]), _mm_setzero_ps()), _mm_mul_ps(_mm_loadu_ps(&model[3][0]), _mm_set1_ps(1.0f)))};
+
+    __m128 leftX {_mm_mul_ps(c0, _mm_set1_ps(left))};
+    __m128 rightX {_mm_mul_ps(c0, _mm_set1_ps(right))};
+    __m128 bottomY {_mm_mul_ps(c1, _mm_set1_ps(bottom))};
+    __m128 topY {_mm_mul_ps(c1, _mm_set1_ps(top))};
+
+    _mm_storeu_ps(&out[0].position.x, _mm_add_ps(_mm_add_ps(leftX, bottomY), zw));
+    _mm_storeu_ps(&out[1].position.x, _mm_add_ps(_mm_add_ps(rightX, bottomY), zw));
+    _mm_storeu_ps(&out[2].position.x, _mm_add_ps(_mm_add_ps(leftX, topY), zw));
+    _mm_storeu_ps(&out[3].position.x, _mm_add_ps(_mm_add_ps(rightX, topY), zw));
+
+    // Same as Color2Vec4
+    const Color& color {spriteRenderer.color};
+    __m128 rgba {_mm_div_ps(_mm_set_ps(color.a, color.b, color.g, color.r), _mm_set1_ps(255.0f))};
+    for (int i {0}; i < 4; ++i) {
+        _mm_storeu_ps(&out[i].color.x, rgba);
+        out[i].texIndex = texIdx;
+    }
+
+    out[0].uv = glm::vec2 {minUV.x, minUV.y};
+    out[1].uv = glm::vec2 {maxUV.x, minUV.y};
+    out[2].uv = glm::vec2 {minUV.x, maxUV.y};
+    out[3].uv = glm::vec2 {maxUV.x, maxUV.y};
+}
+#else
+#define WriteSpriteQuadSIMD WriteSpriteQuad
+#endif // SPRITE_BATCH_SIMD
+
+uint32_t CompareSpriteQuadKernels(const SpriteDrawItem* items, uint32_t count) {
+    uint32_t mismatches {0};
+    for (uint32_t i {0}; i < count; ++i) {
+        const SpriteDrawItem& item {items[i]};
+        SpriteVertex expected[4];
+        SpriteVertex result[4];
+        WriteSpriteQuad(expected, *item.transform, *item.spriteRenderer, item.texIndex);
+        WriteSpriteQuadSIMD(result, *item.transform, *item.spriteRenderer, item.texIndex);
+        if (std::memcmp(expected, result, sizeof(expected)) != 0)
+            ++mismatches;
+    }
+    return mismatches;
+}
+
+void SpriteBatch::DrawSprite(Transform& transform, SpriteRenderer& spriteRenderer) {
+    if (currentVertex + 4 > vertexCapacity) {
+        Flush(FlushCause::BufferFull);
+        Start();
+    }
+
+    FlushCause flushCause;
+    int texIdx {AssignTexture(*spriteRenderer.sprite, flushCause)};
+    if (texIdx < 0) {
+        Flush(flushCause);
+        Start();
+        texIdx = AssignTexture(*spriteRenderer.sprite, flushCause);
+    }
+
+    // The vertices are written after any flush above, which gives the batch a new range of the stream
+    WriteSpriteQuad(&vertices[currentVertex], transform, spriteRenderer, texIdx);
 
     currentVertex += 4;
     ++quadCount;
 }
 
+// Below this many sprites per job the threading overhead is bigger than the work
+constexpr uint32_t minSpritesPerJob {512};
+
+void SpriteBatch::DrawSprites(SpriteDrawItem* items, uint32_t count) {
+    uint32_t first {0};
+    uint32_t firstVertex {currentVertex};
+    for (uint32_t i {0}; i < count; ++i) {
+        int texIdx {-1};
+        FlushCause flushCause {FlushCause::BufferFull};
+        if (currentVertex + 4 <= vertexCapacity)
+            texIdx = AssignTexture(*items[i].spriteRenderer->sprite, flushCause);
+
+        if (texIdx < 0) {
+            GenerateVertices(items + first, i - first, vertices + firstVertex);
+            Flush(flushCause);
+            Start();
+            first = i;
+            firstVertex = currentVertex;
+            texIdx = AssignTexture(*items[i].spriteRenderer->sprite, flushCause);
+        }
+
+        items[i].texIndex = texIdx;
+        currentVertex += 4;
+        ++quadCount;
+    }
+    GenerateVertices(items + first, count - first, vertices + firstVertex);
+}
+
+void SpriteBatch::GenerateVertices(const SpriteDrawItem* items, uint32_t count, SpriteVertex* out) {
+    // Read once, the debug GUI may toggle it while the jobs are running
+    bool validate {validateBulkSubmission};
+    JobSystem::ParallelFor(count, minSpritesPerJob, [items, out, validate](uint32_t begin, uint32_t end) {
+        for (uint32_t i {begin}; i < end; ++i) {
+            const SpriteDrawItem& item {items[i]};
+            WriteSpriteQuadSIMD(out + i * 4, *item.transform, *item.spriteRenderer, item.texIndex);
+
+            if (validate) {
+                SpriteVertex expected[4];
+                WriteSpriteQuad(expected, *item.transform, *item.spriteRenderer, item.texIndex);
+                if (std::memcmp(expected, out + i * 4, sizeof(expected)) != 0)
+                    ++bulkMismatches;
+            }
+        }
+    });
+}
+
+int SpriteBatch::AssignTexture(const Sprite& sprite, FlushCause& outFlushCause) {
+    SpriteBatchMode mode {useTextureArray && sprite.GetAtlasLayer() >= 0 ? SpriteBatchMode::TextureArray : SpriteBatchMode::TextureSlots};
+    if (mode != batchMode) {
+        // Keep the draw order by flushing what was batched with the other mode
+        if (quadCount > 0) {
+            outFlushCause = FlushCause::BatchChange;
+            return -1;
+        }
+        batchMode = mode;
+    }
+
+    if (batchMode == SpriteBatchMode::TextureArray)
+        return sprite.GetAtlasLayer();
+
+    auto texIter {textures.find(sprite.GetTexture())};
+    if (texIter != textures.end())
+        return texIter->second;
+
+    if (currentTexture >= maxTextureSlots) {
+        outFlushCause = FlushCause::TextureSlots;
+        return -1;
+    }
+
+    textures.emplace(sprite.GetTexture(), currentTexture);
+    return currentTexture++;
+}
+
+void SpriteBatch::ReserveVertices() {
+    uint32_t available;
+    vertices = static_cast<SpriteVertex*>(vertexStream->Reserve(4 * sizeof(SpriteVertex), &available));
+    vertexCapacity = std::min(available / static_cast<uint32_t>(sizeof(SpriteVertex)), maxVertices);
+}
+
+//+ Sprite Instance Batch: ==================================================================================
+SpriteInstance* SpriteInstanceBatch::instances {nullptr};
+uint32_t SpriteInstanceBatch::instanceCapacity {0};
+uint32_t SpriteInstanceBatch::instanceCount {0};
+
+bool SpriteInstanceBatch::useInstancing {false};
+
+std::vector<SpriteRect> SpriteInstanceBatch::rects;
+std::unordered_map<uint64_t, int> SpriteInstanceBatch::rectsLookup;
+uint32_t SpriteInstanceBatch::uploadedRects {0};
+Ref<StreamingBuffer> SpriteInstanceBatch::instanceStream;
+
+void SpriteInstanceBatch::Init() {
+    VertexLayout spriteInstanceLayout{
+        VertexElement{3, DataType::Float},              // Position
+        VertexElement{1, DataType::UInt, true},         // Scale
+        VertexElement{1, DataType::UInt, true},         // Pivot
+        VertexElement{1, DataType::UInt, true},         // Rotation - Layer
+        VertexElement{1, DataType::UInt, true},         // Rect ID
+        VertexElement{4, DataType::UByte, false, true}  // Color
+    };
+
+    auto vao {AssetManager::AddVertexArray("spriteInstanceBatch",
+                                           MakeRef<VertexArray>(nullptr, 0, spriteInstanceLayout, BufferUsage::Dynamic))};
+    vao->SetBindingDivisor(1);
+    vao->SetDrawMode(DrawMode::TriangleStrip);
+    instanceStream = MakeRef<StreamingBuffer>(maxInstances * static_cast<uint32_t>(sizeof(SpriteInstance)), 3, static_cast<uint32_t>(sizeof(SpriteInstance)));
+
+    AssetManager::AddBuffer("spriteRects", MakeRef<Buffer>(static_cast<uint32_t>(sizeof(SpriteRect)), nullptr, BufferUsage::Dynamic, BufferTarget::ShaderStorageBuffer));
+}
+
+void SpriteInstanceBatch::Start() {
+    instanceCount = 0;
+    ReserveInstances();
+}
+
+void SpriteInstanceBatch::Flush(FlushCause cause) {
+    if (instanceCount > 0) {
+        RenderStats::AddFlush(cause);
+        RenderStats::AddDrawCalls();
+        RenderStats::AddSpriteInstances(instanceCount);
+
+        // The rect table only grows, so only the new entries need to be uploaded
+        auto rectsBuffer {AssetManager::GetBuffer("spriteRects")};
+        if (uploadedRects < rects.size()) {
+            uint32_t requiredSize {static_cast<uint32_t>(rects.size() * sizeof(SpriteRect))};
+            if (rectsBuffer->GetSize() < requiredSize) {
+                rectsBuffer->Create(static_cast<uint32_t>(rects.capacity() * sizeof(SpriteRect)), nullptr, BufferUsage::Dynamic, BufferTarget::ShaderStorageBuffer);
+                uploadedRects = 0;
+            }
+            rectsBuffer->SetData(uploadedRects * sizeof(SpriteRect), (static_cast<uint32_t>(rects.size()) - uploadedRects) * sizeof(SpriteRect), &rects[uploadedRects]);
+            uploadedRects = static_cast<uint32_t>(rects.size());
+        }
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, rectsBindingIdx, rectsBuffer->GetID());
+
+        uint32_t offset {instanceStream->Commit(instanceCount * sizeof(SpriteInstance))};
+        instances = nullptr;
+        instanceCapacity = 0;
+
+        AssetManager::GetShader("spriteInstanced")->Use();
+        TextureAtlas::GetPageArray()->Use(0);
+        auto vao {AssetManager::GetVertexArray("spriteInstanceBatch")};
+        vao->Use();
+        vao->SetVertexBuffer(instanceStream->GetID(), offset, sizeof(SpriteInstance));
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+    }
+
+    // Sprites that could not be instanced
+    SpriteBatch::Flush(cause);
+}
+
+void SpriteInstanceBatch::DrawSprite(Transform& transform, SpriteRenderer& spriteRenderer) {
+    auto& sprite {spriteRenderer.sprite};
+    int layer {TextureAtlas::GetPageArray() ? sprite->GetAtlasLayer() : -1};
+
+    // Keep the draw order when switching between the instanced and the vertex batch
+    if (layer < 0) {
+        if (instanceCount > 0) {
+            Flush(FlushCause::BatchChange);
+            Start();
+            SpriteBatch::Start();
+        }
+        SpriteBatch::DrawSprite(transform, spriteRenderer);
+        return;
+    }
+    if (SpriteBatch::quadCount > 0) {
+        SpriteBatch::Flush(FlushCause::BatchChange);
+        SpriteBatch::Start();
+    }
+
+    if (instanceCount >= instanceCapacity) {
+        Flush(FlushCause::BufferFull);
+        Start();
+    }
+
+    // Sprites only rotate around the z axis
+    auto& rotation {transform.GetRotation()};
+    float angle {2.0f * std::atan2(rotation.z, rotation.w)};
+
+    SpriteInstance& instance {instances[instanceCount++]};
+    instance.position = transform.GetPosition();
+    instance.scale = glm::packHalf2x16(glm::vec2{transform.GetScale().x, transform.GetScale().y});
+    instance.pivot = glm::packHalf2x16(spriteRenderer.pivot);
+    instance.rotationLayer = (glm::packHalf2x16(glm::vec2{angle, 0.0f}) & 0xffff) | (static_cast<uint32_t>(layer) << 16);
+    instance.rectID = static_cast<uint32_t>(GetRectID(*sprite));
+    instance.color = spriteRenderer.color.c;
+}
+
+int SpriteInstanceBatch::GetRectID(Sprite& sprite) {
+    if (sprite.GetInstanceRectID() >= 0)
+        return sprite.GetInstanceRectID();
+
+    SpriteRect rect;
+    rect.uv = glm::vec4{sprite.GetMinUV().x, 1.0f - sprite.GetMaxUV().y, sprite.GetMaxUV().x, 1.0f - sprite.GetMinUV().y};
+    rect.size = glm::vec2{sprite.GetSize().x, sprite.GetSize().y};
+    rect.padding = glm::vec2{0.0f};
+
+    // Sprites sharing the same region (e.g. animation frames created multiple times) share the same entry
+    uint64_t key {FileSystem::Hash(&rect, sizeof(SpriteRect))};
+    auto rectIter {rectsLookup.find(key)};
+    if (rectIter != rectsLookup.end()) {
+        sprite.SetInstanceRectID(rectIter->second);
+        return rectIter->second;
+    }
+
+    int id {static_cast<int>(rects.size())};
+    rects.push_back(rect);
+    rectsLookup.emplace(key, id);
+    sprite.SetInstanceRectID(id);
+    return id;
+}
+
+void SpriteInstanceBatch::ReserveInstances() {
+    uint32_t available;
+    instances = static_cast<SpriteInstance*>(instanceStream->Reserve(sizeof(SpriteInstance), &available));
+    instanceCapacity = std::min(available / static_cast<uint32_t>(sizeof(SpriteInstance)), maxInstances);
+}
+
 //+ Text Batch: ==============================================================================================
-std::vector<TextVertex> TextBatch::vertices {maxCharacters};
+TextVertex* TextBatch::vertices {nullptr};
+uint32_t TextBatch::vertexCapacity {0};
 uint32_t TextBatch::currentVertex {0};
 
 uint32_t TextBatch::quadCount {0};
 
+Ref<StreamingBuffer> TextBatch::vertexStream;
+Ref<Shader> TextBatch::shader;
+Ref<TextureArray> TextBatch::atlas;
+const TextAppearance* TextBatch::sdfAppearance {nullptr};
+
 void TextBatch::Init() {
     VertexLayout textBatchLayout{
         VertexElement{4, DataType::Float}, // Position (2) - UV (2)
-        VertexElement{4, DataType::Float}  // Color
+        VertexElement{4, DataType::Float}, // Color
+        VertexElement{1, DataType::Float}  // Glyph page
     };
 
     uint32_t textIndices[maxIndices];
@@ -178,31 +518,58 @@ void TextBatch::Init() {
     }
 
     AssetManager::AddVertexArray("textBatch",
-                                 MakeRef<VertexArray>(nullptr, maxVertices, textBatchLayout, BufferUsage::Dynamic,
+                                 MakeRef<VertexArray>(nullptr, 0, textBatchLayout, BufferUsage::Dynamic,
                                                       textIndices, maxIndices, BufferUsage::Static));
+    // Text is flushed once per label, so each region holds several batches
+    vertexStream = MakeRef<StreamingBuffer>(8 * maxVertices * static_cast<uint32_t>(sizeof(TextVertex)), 3, static_cast<uint32_t>(sizeof(TextVertex)));
+}
+
+void TextBatch::SetMaterial(const Ref<Shader>& shader, const Ref<TextureArray>& atlas, const TextAppearance* sdfAppearance) {
+    TextBatch::shader = shader;
+    TextBatch::atlas = atlas;
+    TextBatch::sdfAppearance = sdfAppearance;
 }
 
 void TextBatch::Start() {
     currentVertex = 0;
     quadCount = 0;
+    ReserveVertices();
 }
 
-void TextBatch::Flush() {
+void TextBatch::Flush(FlushCause cause) {
     if (quadCount == 0)
         return;
 
-    auto vao {AssetManager::GetVertexArray("textBatch")};
-    vao->Use();
-    vao->GetVertexBuffer().SetData(0, quadCount * 4 * sizeof(SpriteVertex), &vertices[0]);
+    //! The draw call is counted when the render queue executes it
+    RenderStats::AddFlush(cause);
+    RenderStats::AddGlyphs(quadCount);
+
+    uint32_t offset {vertexStream->Commit(currentVertex * sizeof(TextVertex))};
+    vertices = nullptr;
+    vertexCapacity = 0;
+
+    //! The fence of a region is placed when the stream leaves it, possibly before the queue executes the draws reading
+    //! it. Fine as long as the text of a frame doesn't fill every region of the stream (regionCount * 8 full batches)
+    RenderCommandList& commands {RenderQueue::GetList()};
+    DrawCommand& command {commands.Record(commands.NextSequentialKey(RenderPass::UI), *shader, *AssetManager::GetVertexArray("textBatch"))};
+    command.vertexBuffer = vertexStream->GetID();
+    command.vertexOffset = offset;
+    command.vertexStride = sizeof(TextVertex);
+    command.textures[0] = atlas->GetID();
+    command.count = quadCount * 6;
+
+    if (sdfAppearance)
+        RecordTextInfoUniforms(commands, shader, *sdfAppearance);
+}
 
-    glDrawElements(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, nullptr);
+void TextBatch::Restart(FlushCause cause) {
+    Flush(cause);
+    Start();
 }
 
 void TextBatch::AddCharacter(const TextVertex& bl, const TextVertex& br, const TextVertex& tl, const TextVertex& tr) {
-    if (currentVertex >= maxVertices) {
-        Flush();
-        Start();
-    }
+    if (currentVertex + 4 > vertexCapacity)
+        Restart(FlushCause::BufferFull);
 
     vertices[currentVertex] = bl;
     vertices[currentVertex + 1] = br;
@@ -2,8 +2,10 @@
 #define __BATCH_H__
 
 #include "Common.hpp"
+#include "RenderStats.hpp"
 #include "Utils/Color.hpp"
 
+#include <atomic>
 #include <stdint.h>
 #include <glm/glm.hpp>
 #include <unordered_map>
@@ -19,6 +21,25 @@ struct SpriteVertex {
     int texIndex;
 };
 
+// Sprite submitted through SpriteBatch::DrawSprites
+struct SpriteDrawItem {
+    const struct Transform* transform;
+    const struct SpriteRenderer* spriteRenderer;
+    int texIndex; // Assigned by the batch
+};
+
+// Writes the 4 vertices (bl, br, tl, tr) of the sprite quad
+void WriteSpriteQuad(SpriteVertex* out, const struct Transform& transform, const struct SpriteRenderer& spriteRenderer, int texIdx);
+// Writes the quads of the items with both WriteSpriteQuad and the SIMD kernel of DrawSprites, returns how many of them differ
+uint32_t CompareSpriteQuadKernels(const SpriteDrawItem* items, uint32_t count);
+
+enum class SpriteBatchMode {
+    // One sampler per texture, the vertex texIndex selects the sampler
+    TextureSlots,
+    // Sprites packed in the TextureAtlas, the vertex texIndex selects the layer of the page array
+    TextureArray
+};
+
 class SpriteBatch {
 public:
     static constexpr uint32_t maxSprites  {10000};
@@ -28,27 +49,106 @@ public:
     static std::unordered_map<Ref<class Texture>, int> textures;
     static uint32_t currentTexture;
 
-    static std::vector<SpriteVertex> vertices;
+    // Points directly to the mapped memory of the vertex stream
+    static SpriteVertex* vertices;
+    static uint32_t vertexCapacity;
     static uint32_t currentVertex;
 
     static uint32_t quadCount;
 
+    // Use the atlas page array for packed sprites. Sprites not packed in the atlas still go through the texture slots
+    static bool useTextureArray;
+    // Submit the sprites in bulk with DrawSprites, generating their vertices in parallel with the SIMD kernel
+    static bool useBulkSubmission;
+    // Compare every quad generated by the bulk path against the scalar path, counting the differences in bulkMismatches.
+    // Read once per DrawSprites call, before the jobs are dispatched
+    static bool validateBulkSubmission;
+    static std::atomic<uint32_t> bulkMismatches;
+
 private:
     static int maxTextureSlots;
+    static SpriteBatchMode batchMode;
+    static Ref<class StreamingBuffer> vertexStream;
 
 public:
     static void Init(int maxTextureUnits);
     
     static void Start();
-    static void Flush();
+    static void Flush(FlushCause cause = FlushCause::EndOfPass);
 
     static void DrawSprite(struct Transform& transform, struct SpriteRenderer& spriteRenderer);
+    // Same result as calling DrawSprite for each item in order. The texture slots and flushes are resolved serially,
+    // then the vertices of each batch are generated across the JobSystem
+    static void DrawSprites(SpriteDrawItem* items, uint32_t count);
+
+    static const Ref<class StreamingBuffer>& GetVertexStream() { return vertexStream; }
+
+private:
+    static void ReserveVertices();
+    // Returns the texture index of the sprite in the current batch, or -1 if the batch must be flushed first (the reason
+    // is stored in outFlushCause)
+    static int AssignTexture(const class Sprite& sprite, FlushCause& outFlushCause);
+    static void GenerateVertices(const SpriteDrawItem* items, uint32_t count, SpriteVertex* out);
+};
+
+//+ Sprite Instance Batch: ==================================================================================
+// 32 bytes per sprite, the quad corners are generated in the vertex shader from gl_VertexID
+struct SpriteInstance {
+    glm::vec3 position;
+    uint32_t scale;         // half2
+    uint32_t pivot;         // half2
+    uint32_t rotationLayer; // half rotation in radians (low bits) | atlas layer (high bits)
+    uint32_t rectID;        // index into the uv rect table
+    uint32_t color;         // Color::c
+};
+
+// Entry of the uv rect table, std430 layout
+struct SpriteRect {
+    glm::vec4 uv;           // min uv (xy), max uv (zw)
+    glm::vec2 size;
+    glm::vec2 padding;
+};
+
+class SpriteInstanceBatch {
+public:
+    static constexpr uint32_t maxInstances    {10000};
+    static constexpr uint32_t rectsBindingIdx {2};
+
+    // Points directly to the mapped memory of the instance stream
+    static SpriteInstance* instances;
+    static uint32_t instanceCapacity;
+    static uint32_t instanceCount;
+
+    // Draw the sprites with this batch instead of SpriteBatch. Only sprites packed in the TextureAtlas are instanced, 
+    // the rest are forwarded to SpriteBatch
+    static bool useInstancing;
+
+private:
+    static std::vector<SpriteRect> rects;
+    static std::unordered_map<uint64_t, int> rectsLookup;
+    static uint32_t uploadedRects;
+    static Ref<class StreamingBuffer> instanceStream;
+
+public:
+    static void Init();
+
+    static void Start();
+    static void Flush(FlushCause cause = FlushCause::EndOfPass);
+
+    static void DrawSprite(struct Transform& transform, struct SpriteRenderer& spriteRenderer);
+
+    static const Ref<class StreamingBuffer>& GetInstanceStream() { return instanceStream; }
+
+private:
+    static int GetRectID(class Sprite& sprite);
+    static void ReserveInstances();
 };
 
 //+ Text Batch: ==============================================================================================
 struct TextVertex {
     glm::vec4 position_uv;
     glm::vec4 color;
+    float layer;            // glyph page
 };
 
 class TextBatch {
@@ -57,19 +157,35 @@ public:
     static constexpr uint32_t maxVertices   {maxCharacters * 4};
     static constexpr uint32_t maxIndices    {maxCharacters * 6};
 
-    static std::vector<TextVertex> vertices;
+    // Points directly to the mapped memory of the vertex stream
+    static TextVertex* vertices;
+    static uint32_t vertexCapacity;
     static uint32_t currentVertex;
 
     static uint32_t quadCount;
 
+private:
+    static Ref<class StreamingBuffer> vertexStream;
+    static Ref<class Shader> shader;
+    static Ref<class TextureArray> atlas;
+    static const struct TextAppearance* sdfAppearance;
+
 public:
     static void Init();
 
+    // Shader and atlas of the next draws, sdfAppearance (nullptr for raster fonts) must stay alive until the last Flush
+    static void SetMaterial(const Ref<class Shader>& shader, const Ref<class TextureArray>& atlas, const struct TextAppearance* sdfAppearance);
     static void Start();
-    static void Flush();
-    static void Restart();
+    // Records the draw of the characters added since Start in the render queue of the calling thread
+    static void Flush(FlushCause cause = FlushCause::EndOfPass);
+    static void Restart(FlushCause cause);
 
     static void AddCharacter(const TextVertex& bl, const TextVertex& br, const TextVertex& tl, const TextVertex& tr);
+
+    static const Ref<class StreamingBuffer>& GetVertexStream() { return vertexStream; }
+
+private:
+    static void ReserveVertices();
 };
 
 #endif // __BATCH_H__
\ No newline at end of file
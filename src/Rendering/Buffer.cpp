@@ -1,6 +1,9 @@
 #include "Buffer.hpp"
 
 #include "Core/Log.hpp"
+#include "Core/Time.hpp"
+#include "NullGL.hpp"
+#include "RenderStats.hpp"
 
 #include <glad/glad.h>
 
@@ -112,6 +115,7 @@ void Buffer::Create(uint32_t size, const void* data, BufferUsage usage, BufferTa
 }
 
 void Buffer::SetData(uint32_t offset, uint32_t size, const void* data) {
+    RenderStats::AddUploadedBytes(size);
     glNamedBufferSubData(id, offset, size, data); 
 }
 
@@ -148,3 +152,107 @@ void CopyBufferSubData(Buffer& src, Buffer& dest, uint32_t srcOffset, uint32_t d
     glCopyNamedBufferSubData(src.id, dest.id, srcOffset, destOffset, size);
 }
 
+//+ Streaming Buffer ================================================================================
+
+StreamingBuffer::StreamingBuffer() { }
+
+StreamingBuffer::StreamingBuffer(uint32_t regionSize, uint32_t regionCount, uint32_t stride) {
+    Create(regionSize, regionCount, stride);
+}
+
+StreamingBuffer::~StreamingBuffer() {
+    Destroy();
+}
+
+void StreamingBuffer::Create(uint32_t regionSize, uint32_t regionCount, uint32_t stride) {
+    Destroy();
+
+    // Regions must start at a multiple of the stride
+    this->stride = stride;
+    this->regionSize = (regionSize + stride - 1) / stride * stride;
+    this->regionCount = regionCount;
+    size = this->regionSize * regionCount;
+    target = BufferTarget::ArrayBuffer;
+    currentRegion = 0;
+    cursor = 0;
+    fences.assign(regionCount, nullptr);
+
+    GLbitfield flags {GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, size, nullptr, flags);
+    mappedData = static_cast<uint8_t*>(glMapNamedBufferRange(id, 0, size, flags));
+
+    LOG_DEBUG("Streaming buffer [{}] created ({} regions of {} bytes).", id, regionCount, this->regionSize);
+}
+
+void StreamingBuffer::Destroy() {
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (id != 0 && mappedData) {
+        glUnmapNamedBuffer(id);
+        mappedData = nullptr;
+    }
+
+    Buffer::Destroy();
+}
+
+void* StreamingBuffer::Reserve(uint32_t minSize, uint32_t* outAvailable) {
+    if (minSize > regionSize) {
+        LOG_ERROR("Streaming buffer [{}] can't reserve {} bytes, regions are only {} bytes.", id, minSize, regionSize);
+        *outAvailable = 0;
+        return nullptr;
+    }
+
+    cursor = (cursor + stride - 1) / stride * stride;
+    uint32_t regionEnd {(currentRegion + 1) * regionSize};
+    if (cursor + minSize > regionEnd) {
+        NextRegion();
+        regionEnd = (currentRegion + 1) * regionSize;
+    }
+
+    *outAvailable = regionEnd - cursor;
+    return mappedData + cursor;
+}
+
+uint32_t StreamingBuffer::Commit(uint32_t size) {
+    uint32_t offset {cursor};
+    cursor += size;
+    stats.uploadedBytes += size;
+    RenderStats::AddUploadedBytes(size);
+    if (NullGL::IsLoaded())
+        NullGL::OnMappedWrite(id, size);
+    return offset;
+}
+
+void StreamingBuffer::EndFrame() {
+    if (cursor > currentRegion * regionSize)
+        NextRegion();
+
+    lastFrameStats = stats;
+    stats = StreamingBufferStats{};
+}
+
+void StreamingBuffer::NextRegion() {
+    // Every draw reading the current region has already been issued
+    fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    currentRegion = (currentRegion + 1) % regionCount;
+    cursor = currentRegion * regionSize;
+
+    GLsync& fence {fences[currentRegion]};
+    if (fence) {
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++stats.fenceWaits;
+            uint64_t waitStart {Time::GetPerformanceCounter()};
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) { }
+            stats.fenceWaitTime += Time::GetMilisecondsSince(waitStart);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
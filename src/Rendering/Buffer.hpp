@@ -1,7 +1,11 @@
 #ifndef __BUFFER_H__
 #define __BUFFER_H__
 
+#include <stddef.h>
 #include <stdint.h>
+#include <vector>
+
+struct __GLsync;
 
 enum class DataType : uint32_t {
     Bool,
@@ -86,4 +90,72 @@ protected:
     BufferTarget target;
 };
 
+//+ Streaming Buffer ================================================================================
+
+struct StreamingBufferStats {
+    uint64_t uploadedBytes {0};
+    // Number of times the CPU had to wait for the GPU to release a region
+    uint32_t fenceWaits    {0};
+    // Time spent waiting in milliseconds
+    float fenceWaitTime    {0.0f};
+};
+
+/**
+ * @brief Persistently and coherently mapped buffer used as a ring of regions. Each region is guarded by a fence, 
+ * so writing only waits for the GPU when the region it is about to reuse may still be in use.
+ * Data is written directly in the mapped memory returned by Reserve and confirmed with Commit.
+ */
+class StreamingBuffer : public Buffer {
+public:
+    StreamingBuffer();
+    StreamingBuffer(uint32_t regionSize, uint32_t regionCount = 3, uint32_t stride = 1);
+    ~StreamingBuffer() override;
+    StreamingBuffer(StreamingBuffer&&) = delete;
+    StreamingBuffer& operator=(StreamingBuffer&&) = delete;
+
+    // Offsets returned by Commit are always multiples of stride (e.g. the vertex size)
+    void Create(uint32_t regionSize, uint32_t regionCount = 3, uint32_t stride = 1);
+    void Destroy();
+
+    /**
+     * @brief Returns a pointer to the mapped memory where at least minSize bytes can be written. 
+     * Moves to the next region (waiting for its fence if needed) when the current one has no space left, which is only
+     * a fallback for frames that write more than a region, EndFrame moves to the next one every frame.
+     * 
+     * @param outAvailable Bytes that can be written before reaching the end of the current region
+     */
+    void* Reserve(uint32_t minSize, uint32_t* outAvailable);
+    // Confirms that size bytes were written at the last reserved pointer and returns their offset from the start of the buffer
+    uint32_t Commit(uint32_t size);
+    // Fences the current region if anything was written to it and moves to the next one, so the data of a frame is never
+    // overwritten while the GPU may still read it. Must be called once every draw of the frame was issued. Also moves the
+    // counters of the frame to GetStats
+    void EndFrame();
+
+    uint32_t GetRegionSize() const { return regionSize; }
+    uint32_t GetRegionCount() const { return regionCount; }
+    // Counters of the last finished frame
+    const StreamingBufferStats& GetStats() const { return lastFrameStats; }
+
+    void SetData(uint32_t offset, uint32_t size, const void* data) = delete;
+    void* Map(BufferAccess access) = delete;
+    void Unmap() = delete;
+    void SetBufferTarget(BufferTarget) = delete;
+
+private:
+    void NextRegion();
+
+private:
+    uint8_t* mappedData    {nullptr};
+    uint32_t regionSize    {0};
+    uint32_t regionCount   {0};
+    uint32_t stride        {1};
+    uint32_t currentRegion {0};
+    uint32_t cursor        {0}; // Offset from the start of the buffer
+    std::vector<__GLsync*> fences;
+
+    StreamingBufferStats stats;
+    StreamingBufferStats lastFrameStats;
+};
+
 #endif // __BUFFER_H__
\ No newline at end of file
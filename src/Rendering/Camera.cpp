@@ -41,10 +41,13 @@ void Camera::SetVirtualSize(const glm::ivec2 size) {
 glm::vec2 Camera::ScreenToWorld2D(const glm::vec2& point) {
     //+ For camera origin (0, 0) at the center of the screen and screen origin at top-left corner:
     //+ Positive axes: camera/world (right, up), screen (right, down)
-    float widthFactor {float(virtualSize.x / scale) / float(renderer->screenSize.x)};
-    float heightFactor {float(virtualSize.y / scale) / float(renderer->screenSize.y)};
+    //+ The world may only cover part of the window (see Renderer::GetWorldViewport), the viewport y is from the bottom
+    const glm::ivec4& viewport {renderer->GetWorldViewport()};
+    float widthFactor {float(virtualSize.x / scale) / float(viewport.z)};
+    float heightFactor {float(virtualSize.y / scale) / float(viewport.w)};
 
-    glm::vec2 screenPos = point * glm::vec2{widthFactor, heightFactor};
+    glm::vec2 viewportPoint {point.x - viewport.x, point.y - (renderer->screenSize.y - viewport.y - viewport.w)};
+    glm::vec2 screenPos = viewportPoint * glm::vec2{widthFactor, heightFactor};
     glm::vec2 screenCenter {virtualSize.x / scale / 2.0f, virtualSize.y / scale / 2.0f};
 
     glm::vec2 worldPos {screenPos.x - screenCenter.x + position.x, screenCenter.y - screenPos.y + position.y};
@@ -70,6 +73,12 @@ bool Camera::IsPointInside(const glm::vec2& point) {
         && point.y >= -cameraExtends.y && point.y <= cameraExtends.y;
 }
 
+Bounds2D Camera::GetViewBounds() const {
+    glm::vec2 cameraExtends {virtualSize.x / scale / 2.0f, virtualSize.y / scale / 2.0f};
+    glm::vec2 center {position.x, position.y};
+    return Bounds2D{center - cameraExtends, center + cameraExtends};
+}
+
 glm::vec2 Camera::GetScreenVsVirtualSizeScaleRatio() const {
     return glm::vec2{(float)virtualSize.x / renderer->screenSize.x, (float)virtualSize.y / renderer->screenSize.y};
 }
@@ -150,4 +159,5 @@ void Camera::UpdateViewMatrix() {
 //* mat4 projection        - 64 (16N)     16
 //* mat4 view              - 64 (16N)     80
 //* mat4 projView          - 64 (16N)     144
-//*                        - 208          
\ No newline at end of file
+//* float time             - 4  (N)       208
+//*                        - 224 (padded)          
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "Common.hpp"
 #include "UI/Rect.hpp"
+#include "Utils/MathExtras.hpp"
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -19,6 +20,8 @@ public:
     glm::vec2 World2DToScreen(const glm::vec2& point);
     glm::vec2 World2DToVirtualScreen(const glm::vec2& point);
     bool IsPointInside(const glm::vec2& point);
+    // World space area seen by the camera
+    Bounds2D GetViewBounds() const;
 
     glm::vec2 GetScreenVsVirtualSizeScaleRatio() const;
 
@@ -37,8 +37,11 @@ void Framebuffer::Destroy() {
             glDeleteRenderbuffers(1, &rbo);
         }
 
+        renderBuffers.clear();
+
         LOG_DEBUG("Framebuffer [{}] deleted.", id);
         glDeleteFramebuffers(1, &id);
+        id = 0;
     }
 }
 
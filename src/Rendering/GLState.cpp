@@ -0,0 +1,145 @@
+#include "GLState.hpp"
+
+#include "RenderStats.hpp"
+
+#include <glad/glad.h>
+
+uint32_t GLState::program {unknownID};
+uint32_t GLState::vertexArray {unknownID};
+std::array<uint32_t, GLState::maxTextureUnits> GLState::textureUnits {};
+int8_t GLState::blendEnabled {unknownToggle};
+BlendMode GLState::blendFunc {BlendMode::None};
+int8_t GLState::cullFaceEnabled {unknownToggle};
+int8_t GLState::scissorTestEnabled {unknownToggle};
+glm::ivec4 GLState::scissor {0};
+bool GLState::isScissorKnown {false};
+
+GLStateStats GLState::frameStats;
+GLStateStats GLState::lastFrameStats;
+
+void GLState::UseProgram(uint32_t program) {
+    if (Track(GLState::program != program)) {
+        GLState::program = program;
+        RenderStats::AddShaderSwitch();
+        glUseProgram(program);
+    }
+}
+
+void GLState::BindVertexArray(uint32_t vertexArray) {
+    if (Track(GLState::vertexArray != vertexArray)) {
+        GLState::vertexArray = vertexArray;
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void GLState::BindTextureUnit(uint32_t unit, uint32_t texture) {
+    if (unit >= maxTextureUnits) {
+        Track(true);
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+
+    if (Track(textureUnits[unit] != texture)) {
+        textureUnits[unit] = texture;
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void GLState::SetBlend(BlendMode mode) {
+    int8_t enabled {static_cast<int8_t>(mode != BlendMode::None)};
+    if (Track(blendEnabled != enabled)) {
+        blendEnabled = enabled;
+        if (enabled)
+            glEnable(GL_BLEND);
+        else
+            glDisable(GL_BLEND);
+    }
+
+    //! Disabling blending keeps the last function, so going back to it doesn't need another call
+    if (mode == BlendMode::None)
+        return;
+
+    if (Track(blendFunc != mode)) {
+        blendFunc = mode;
+        switch (mode) {
+            case BlendMode::Alpha:
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            case BlendMode::AlphaOverwrite:
+                glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void GLState::SetCullFace(bool enabled) {
+    if (Track(cullFaceEnabled != static_cast<int8_t>(enabled))) {
+        cullFaceEnabled = static_cast<int8_t>(enabled);
+        if (enabled)
+            glEnable(GL_CULL_FACE);
+        else
+            glDisable(GL_CULL_FACE);
+    }
+}
+
+void GLState::SetScissorTest(bool enabled) {
+    if (Track(scissorTestEnabled != static_cast<int8_t>(enabled))) {
+        scissorTestEnabled = static_cast<int8_t>(enabled);
+        if (enabled)
+            glEnable(GL_SCISSOR_TEST);
+        else
+            glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void GLState::SetScissor(const glm::ivec4& scissor) {
+    if (Track(!isScissorKnown || GLState::scissor != scissor)) {
+        GLState::scissor = scissor;
+        isScissorKnown = true;
+        glScissor(scissor.x, scissor.y, scissor.z, scissor.w);
+    }
+}
+
+void GLState::OnProgramDeleted(uint32_t program) {
+    //! A deleted program stays in use until another one is, so it can't be assumed to be 0
+    if (GLState::program == program)
+        GLState::program = unknownID;
+}
+
+void GLState::OnVertexArrayDeleted(uint32_t vertexArray) {
+    if (GLState::vertexArray == vertexArray)
+        GLState::vertexArray = 0;
+}
+
+void GLState::OnTextureDeleted(uint32_t texture) {
+    for (uint32_t& unit : textureUnits) {
+        if (unit == texture)
+            unit = 0;
+    }
+}
+
+void GLState::Invalidate() {
+    program = unknownID;
+    vertexArray = unknownID;
+    textureUnits.fill(unknownID);
+    blendEnabled = unknownToggle;
+    blendFunc = BlendMode::None;
+    cullFaceEnabled = unknownToggle;
+    scissorTestEnabled = unknownToggle;
+    isScissorKnown = false;
+}
+
+void GLState::NewFrame() {
+    lastFrameStats = frameStats;
+    frameStats = GLStateStats{};
+}
+
+bool GLState::Track(bool changed) {
+    if (changed)
+        ++frameStats.issued;
+    else
+        ++frameStats.skipped;
+    return changed;
+}
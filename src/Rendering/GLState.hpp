@@ -0,0 +1,74 @@
+#ifndef __GLSTATE_H__
+#define __GLSTATE_H__
+
+#include <array>
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+enum class BlendMode : uint8_t {
+    None,
+    // SRC_ALPHA, ONE_MINUS_SRC_ALPHA for color and alpha
+    Alpha,
+    // SRC_ALPHA, ONE_MINUS_SRC_ALPHA for color, the source alpha is written as is (used by the UI)
+    AlphaOverwrite
+};
+
+struct GLStateStats {
+    uint32_t issued  {0}; // State changes that reached GL
+    uint32_t skipped {0}; // Redundant state changes filtered by the cache
+};
+
+/**
+ * @brief Shadow copy of the bindings and toggles changed the most during a frame (program, vertex array, texture units,
+ * blend, cull and scissor). Calls that wouldn't change the current value are skipped.
+ *
+ * Everything that changes these states should go through here, code that touches them directly (e.g. ImGui) must be
+ * followed by an Invalidate.
+ */
+class GLState {
+public:
+    static constexpr uint32_t maxTextureUnits {32};
+
+    static void UseProgram(uint32_t program);
+    static void BindVertexArray(uint32_t vertexArray);
+    static void BindTextureUnit(uint32_t unit, uint32_t texture);
+    static void SetBlend(BlendMode mode);
+    static void SetCullFace(bool enabled);
+    static void SetScissorTest(bool enabled);
+    static void SetScissor(const glm::ivec4& scissor); // x, y, width, height
+
+    //+ Deleting an object reverts the bindings that used it to 0
+    static void OnProgramDeleted(uint32_t program);
+    static void OnVertexArrayDeleted(uint32_t vertexArray);
+    static void OnTextureDeleted(uint32_t texture);
+
+    // Forgets every cached value, so the next change of each state is always issued
+    static void Invalidate();
+
+    // Starts counting a new frame, the counters of the previous one are returned by GetFrameStats
+    static void NewFrame();
+    static const GLStateStats& GetFrameStats() { return lastFrameStats; }
+
+private:
+    // Counts the change and returns whether it has to be issued
+    static bool Track(bool changed);
+
+private:
+    static constexpr uint32_t unknownID {UINT32_MAX};
+    static constexpr int8_t unknownToggle {-1};
+
+    static uint32_t program;
+    static uint32_t vertexArray;
+    static std::array<uint32_t, maxTextureUnits> textureUnits;
+    static int8_t blendEnabled;
+    static BlendMode blendFunc; // Last function set (None if unknown), kept while blending is disabled
+    static int8_t cullFaceEnabled;
+    static int8_t scissorTestEnabled;
+    static glm::ivec4 scissor;
+    static bool isScissorKnown;
+
+    static GLStateStats frameStats;
+    static GLStateStats lastFrameStats;
+};
+
+#endif // __GLSTATE_H__
@@ -0,0 +1,361 @@
+#include "NullGL.hpp"
+
+#include "Core/Log.hpp"
+
+#include <cstring>
+#include <glad/glad.h>
+#include <vector>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+bool NullGL::isLoaded {false};
+NullGLStats NullGL::lastFrameStats;
+
+static NullGLStats frameStats;
+static GLuint nextObjectID {0};
+// Memory returned when mapping buffers, by buffer id
+static std::unordered_map<GLuint, std::vector<uint8_t>> bufferStorage;
+
+//+ Helpers =========================================================================================
+
+// Function that ignores its arguments and returns a default value, for everything that doesn't need to be recorded
+template<class Function>
+struct NullFunction;
+
+template<class Ret, class... Args>
+struct NullFunction<Ret (APIENTRY*)(Args...)> {
+    static Ret APIENTRY Call(Args...) { return Ret(); }
+};
+
+template<class Function>
+static void SetNull(Function& function) {
+    function = &NullFunction<Function>::Call;
+}
+
+static void GenerateIDs(GLsizei n, GLuint* ids) {
+    for (GLsizei i {0}; i < n; ++i)
+        ids[i] = ++nextObjectID;
+}
+
+static uint64_t GetPixelSize(GLenum format, GLenum type) {
+    uint64_t components {4};
+    switch (format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+    }
+
+    switch (type) {
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+        case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return components * 4;
+        default: return components;
+    }
+}
+
+static void RecordBufferUpload(GLuint buffer, uint64_t size) {
+    frameStats.bufferBytes += size;
+    frameStats.bufferUploads[buffer] += size;
+}
+
+//+ Objects =========================================================================================
+
+static void APIENTRY CreateBuffers(GLsizei n, GLuint* buffers) { GenerateIDs(n, buffers); }
+static void APIENTRY CreateTextures(GLenum, GLsizei n, GLuint* textures) { GenerateIDs(n, textures); }
+static void APIENTRY GenTextures(GLsizei n, GLuint* textures) { GenerateIDs(n, textures); }
+static void APIENTRY CreateVertexArrays(GLsizei n, GLuint* arrays) { GenerateIDs(n, arrays); }
+static void APIENTRY CreateFramebuffers(GLsizei n, GLuint* framebuffers) { GenerateIDs(n, framebuffers); }
+static void APIENTRY CreateRenderbuffers(GLsizei n, GLuint* renderbuffers) { GenerateIDs(n, renderbuffers); }
+static void APIENTRY CreateQueries(GLenum, GLsizei n, GLuint* ids) { GenerateIDs(n, ids); }
+static GLuint APIENTRY CreateProgram() { return ++nextObjectID; }
+static GLuint APIENTRY CreateShader(GLenum) { return ++nextObjectID; }
+static GLsync APIENTRY FenceSync(GLenum, GLbitfield) { return reinterpret_cast<GLsync>(static_cast<uintptr_t>(++nextObjectID)); }
+
+static void APIENTRY DeleteBuffers(GLsizei n, const GLuint* buffers) {
+    for (GLsizei i {0}; i < n; ++i)
+        bufferStorage.erase(buffers[i]);
+}
+
+//+ Uploads =========================================================================================
+
+static void APIENTRY NamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum) {
+    bufferStorage[buffer].resize(size);
+    if (data)
+        RecordBufferUpload(buffer, size);
+}
+
+static void APIENTRY NamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield) {
+    bufferStorage[buffer].resize(size);
+    if (data)
+        RecordBufferUpload(buffer, size);
+}
+
+static void APIENTRY NamedBufferSubData(GLuint buffer, GLintptr, GLsizeiptr size, const void*) {
+    RecordBufferUpload(buffer, size);
+}
+
+static void* APIENTRY MapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr, GLbitfield) {
+    auto iter {bufferStorage.find(buffer)};
+    return iter != bufferStorage.end() ? iter->second.data() + offset : nullptr;
+}
+
+static void* APIENTRY MapNamedBuffer(GLuint buffer, GLenum) {
+    return MapNamedBufferRange(buffer, 0, 0, 0);
+}
+
+static GLboolean APIENTRY UnmapNamedBuffer(GLuint) { return GL_TRUE; }
+
+static void APIENTRY TextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    if (pixels)
+        frameStats.textureBytes += static_cast<uint64_t>(width) * height * GetPixelSize(format, type);
+}
+
+static void APIENTRY TextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels) {
+    if (pixels)
+        frameStats.textureBytes += static_cast<uint64_t>(width) * height * depth * GetPixelSize(format, type);
+}
+
+static void APIENTRY TexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    if (pixels)
+        frameStats.textureBytes += static_cast<uint64_t>(width) * height * GetPixelSize(format, type);
+}
+
+//+ Binds and state =================================================================================
+
+static void APIENTRY UseProgram(GLuint) { ++frameStats.programBinds; }
+static void APIENTRY BindTextureUnit(GLuint, GLuint) { ++frameStats.textureBinds; }
+static void APIENTRY BindTexture(GLenum, GLuint) { ++frameStats.textureBinds; }
+static void APIENTRY BindVertexArray(GLuint) { ++frameStats.stateChanges; }
+static void APIENTRY BindFramebuffer(GLenum, GLuint) { ++frameStats.stateChanges; }
+static void APIENTRY Enable(GLenum) { ++frameStats.stateChanges; }
+static void APIENTRY Disable(GLenum) { ++frameStats.stateChanges; }
+static void APIENTRY BlendFunc(GLenum, GLenum) { ++frameStats.stateChanges; }
+static void APIENTRY BlendFuncSeparate(GLenum, GLenum, GLenum, GLenum) { ++frameStats.stateChanges; }
+static void APIENTRY Scissor(GLint, GLint, GLsizei, GLsizei) { ++frameStats.stateChanges; }
+static void APIENTRY Viewport(GLint, GLint, GLsizei, GLsizei) { ++frameStats.stateChanges; }
+
+//+ Draws ===========================================================================================
+
+static void APIENTRY DrawArrays(GLenum, GLint, GLsizei count) {
+    ++frameStats.drawCalls;
+    frameStats.vertices += count;
+}
+
+static void APIENTRY DrawElements(GLenum, GLsizei count, GLenum, const void*) {
+    ++frameStats.drawCalls;
+    frameStats.vertices += count;
+}
+
+static void APIENTRY DrawArraysInstanced(GLenum, GLint, GLsizei count, GLsizei instanceCount) {
+    ++frameStats.drawCalls;
+    frameStats.vertices += static_cast<uint64_t>(count) * instanceCount;
+}
+
+static void APIENTRY MultiDrawArrays(GLenum, const GLint*, const GLsizei* count, GLsizei drawCount) {
+    //! A single call, but the driver still processes every draw
+    frameStats.drawCalls += drawCount;
+    for (GLsizei i {0}; i < drawCount; ++i)
+        frameStats.vertices += count[i];
+}
+
+//+ Queries =========================================================================================
+
+static const GLubyte* APIENTRY GetString(GLenum name) {
+    switch (name) {
+        case GL_VENDOR:   return reinterpret_cast<const GLubyte*>("OGLRoguelike");
+        case GL_RENDERER: return reinterpret_cast<const GLubyte*>("Null GL");
+        case GL_VERSION:  return reinterpret_cast<const GLubyte*>("4.5 Null");
+        default:          return reinterpret_cast<const GLubyte*>("");
+    }
+}
+
+static void APIENTRY GetIntegerv(GLenum name, GLint* data) {
+    switch (name) {
+        case GL_MAX_TEXTURE_IMAGE_UNITS: *data = 32; break;
+        case GL_MAX_TEXTURE_SIZE:        *data = 16384; break;
+        case GL_POLYGON_MODE:            data[0] = data[1] = GL_FILL; break;
+        default:                         *data = 0; break;
+    }
+}
+
+static void APIENTRY GetFloatv(GLenum name, GLfloat* data) {
+    *data = name == GL_MAX_TEXTURE_MAX_ANISOTROPY ? 16.0f : 0.0f;
+}
+
+static void APIENTRY GetShaderiv(GLuint, GLenum name, GLint* params) {
+    *params = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY GetProgramiv(GLuint, GLenum name, GLint* params) {
+    switch (name) {
+        case GL_LINK_STATUS: case GL_VALIDATE_STATUS: case GL_COMPLETION_STATUS_KHR: *params = GL_TRUE; break;
+        case GL_ACTIVE_UNIFORM_MAX_LENGTH: *params = 1; break;
+        default: *params = 0; break;
+    }
+}
+
+static void APIENTRY GetInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (length)
+        *length = 0;
+    if (bufSize > 0)
+        infoLog[0] = '\0';
+}
+
+static void APIENTRY GetProgramBinary(GLuint, GLsizei, GLsizei* length, GLenum*, void*) {
+    if (length)
+        *length = 0;
+}
+
+static void APIENTRY GetTextureImage(GLuint, GLint, GLenum, GLenum, GLsizei bufSize, void* pixels) {
+    std::memset(pixels, 0, bufSize);
+}
+
+static void APIENTRY GetQueryObjectiv(GLuint, GLenum, GLint* params) { *params = GL_TRUE; }
+static void APIENTRY GetQueryObjectui64v(GLuint, GLenum, GLuint64* params) { *params = 0; }
+static GLint APIENTRY GetUniformLocation(GLuint, const GLchar*) { return -1; }
+static GLenum APIENTRY CheckNamedFramebufferStatus(GLuint, GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+static GLenum APIENTRY ClientWaitSync(GLsync, GLbitfield, GLuint64) { return GL_ALREADY_SIGNALED; }
+
+//+ Null GL =========================================================================================
+
+void NullGL::Load() {
+    //+ Recorded
+    glad_glCreateBuffers = CreateBuffers;
+    glad_glCreateTextures = CreateTextures;
+    glad_glGenTextures = GenTextures;
+    glad_glCreateVertexArrays = CreateVertexArrays;
+    glad_glCreateFramebuffers = CreateFramebuffers;
+    glad_glCreateRenderbuffers = CreateRenderbuffers;
+    glad_glCreateQueries = CreateQueries;
+    glad_glCreateProgram = CreateProgram;
+    glad_glCreateShader = CreateShader;
+    glad_glFenceSync = FenceSync;
+    glad_glDeleteBuffers = DeleteBuffers;
+
+    glad_glNamedBufferData = NamedBufferData;
+    glad_glNamedBufferStorage = NamedBufferStorage;
+    glad_glNamedBufferSubData = NamedBufferSubData;
+    glad_glMapNamedBuffer = MapNamedBuffer;
+    glad_glMapNamedBufferRange = MapNamedBufferRange;
+    glad_glUnmapNamedBuffer = UnmapNamedBuffer;
+    glad_glTextureSubImage2D = TextureSubImage2D;
+    glad_glTextureSubImage3D = TextureSubImage3D;
+    glad_glTexSubImage2D = TexSubImage2D;
+
+    glad_glUseProgram = UseProgram;
+    glad_glBindTextureUnit = BindTextureUnit;
+    glad_glBindTexture = BindTexture;
+    glad_glBindVertexArray = BindVertexArray;
+    glad_glBindFramebuffer = BindFramebuffer;
+    glad_glEnable = Enable;
+    glad_glDisable = Disable;
+    glad_glBlendFunc = BlendFunc;
+    glad_glBlendFuncSeparate = BlendFuncSeparate;
+    glad_glScissor = Scissor;
+    glad_glViewport = Viewport;
+
+    glad_glDrawArrays = DrawArrays;
+    glad_glDrawElements = DrawElements;
+    glad_glDrawArraysInstanced = DrawArraysInstanced;
+    glad_glMultiDrawArrays = MultiDrawArrays;
+
+    glad_glGetString = GetString;
+    glad_glGetIntegerv = GetIntegerv;
+    glad_glGetFloatv = GetFloatv;
+    glad_glGetShaderiv = GetShaderiv;
+    glad_glGetProgramiv = GetProgramiv;
+    glad_glGetShaderInfoLog = GetInfoLog;
+    glad_glGetProgramInfoLog = GetInfoLog;
+    glad_glGetProgramBinary = GetProgramBinary;
+    glad_glGetTextureImage = GetTextureImage;
+    glad_glGetQueryObjectiv = GetQueryObjectiv;
+    glad_glGetQueryObjectui64v = GetQueryObjectui64v;
+    glad_glGetUniformLocation = GetUniformLocation;
+    glad_glCheckNamedFramebufferStatus = CheckNamedFramebufferStatus;
+    glad_glClientWaitSync = ClientWaitSync;
+
+    //+ Ignored
+    SetNull(glad_glActiveTexture);
+    SetNull(glad_glAttachShader);
+    SetNull(glad_glBeginQuery);
+    SetNull(glad_glBindBuffer);
+    SetNull(glad_glBindBufferBase);
+    SetNull(glad_glBlitNamedFramebuffer);
+    SetNull(glad_glClear);
+    SetNull(glad_glClearColor);
+    SetNull(glad_glClearNamedFramebufferfi);
+    SetNull(glad_glClearNamedFramebufferfv);
+    SetNull(glad_glClearNamedFramebufferiv);
+    SetNull(glad_glClearNamedFramebufferuiv);
+    SetNull(glad_glClearTexImage);
+    SetNull(glad_glClearTexSubImage);
+    SetNull(glad_glCompileShader);
+    SetNull(glad_glCopyImageSubData);
+    SetNull(glad_glCopyNamedBufferSubData);
+    SetNull(glad_glDebugMessageCallback);
+    SetNull(glad_glDebugMessageControl);
+    SetNull(glad_glDeleteFramebuffers);
+    SetNull(glad_glDeleteProgram);
+    SetNull(glad_glDeleteQueries);
+    SetNull(glad_glDeleteRenderbuffers);
+    SetNull(glad_glDeleteShader);
+    SetNull(glad_glDeleteSync);
+    SetNull(glad_glDeleteTextures);
+    SetNull(glad_glDeleteVertexArrays);
+    SetNull(glad_glDetachShader);
+    SetNull(glad_glEnableVertexArrayAttrib);
+    SetNull(glad_glEndQuery);
+    SetNull(glad_glGenerateTextureMipmap);
+    SetNull(glad_glGetActiveUniform);
+    SetNull(glad_glLinkProgram);
+    SetNull(glad_glNamedFramebufferRenderbuffer);
+    SetNull(glad_glNamedFramebufferTexture);
+    SetNull(glad_glNamedRenderbufferStorage);
+    SetNull(glad_glNamedRenderbufferStorageMultisample);
+    SetNull(glad_glPixelStorei);
+    SetNull(glad_glPolygonMode);
+    SetNull(glad_glProgramBinary);
+    SetNull(glad_glProgramParameteri);
+    SetNull(glad_glProgramUniform1f);
+    SetNull(glad_glProgramUniform1fv);
+    SetNull(glad_glProgramUniform1i);
+    SetNull(glad_glProgramUniform1iv);
+    SetNull(glad_glProgramUniform1ui);
+    SetNull(glad_glProgramUniform1uiv);
+    SetNull(glad_glProgramUniform2fv);
+    SetNull(glad_glProgramUniform2iv);
+    SetNull(glad_glProgramUniform3fv);
+    SetNull(glad_glProgramUniform3iv);
+    SetNull(glad_glProgramUniform4fv);
+    SetNull(glad_glProgramUniform4iv);
+    SetNull(glad_glProgramUniformMatrix2fv);
+    SetNull(glad_glProgramUniformMatrix3fv);
+    SetNull(glad_glProgramUniformMatrix4fv);
+    SetNull(glad_glShaderSource);
+    SetNull(glad_glTexParameteri);
+    SetNull(glad_glTexStorage2D);
+    SetNull(glad_glTextureBuffer);
+    SetNull(glad_glTextureParameterf);
+    SetNull(glad_glTextureParameteri);
+    SetNull(glad_glTextureStorage2D);
+    SetNull(glad_glTextureStorage3D);
+    SetNull(glad_glVertexArrayAttribBinding);
+    SetNull(glad_glVertexArrayAttribFormat);
+    SetNull(glad_glVertexArrayAttribIFormat);
+    SetNull(glad_glVertexArrayBindingDivisor);
+    SetNull(glad_glVertexArrayElementBuffer);
+    SetNull(glad_glVertexArrayVertexBuffer);
+
+    isLoaded = true;
+    LOG_INFO("Null GL backend loaded, nothing will be drawn.");
+}
+
+void NullGL::OnMappedWrite(uint32_t buffer, uint64_t size) {
+    RecordBufferUpload(buffer, size);
+}
+
+void NullGL::NewFrame() {
+    lastFrameStats = std::move(frameStats);
+    frameStats = NullGLStats{};
+}
@@ -0,0 +1,45 @@
+#ifndef __NULLGL_H__
+#define __NULLGL_H__
+
+#include <stdint.h>
+#include <unordered_map>
+
+struct NullGLStats {
+    uint32_t drawCalls     {0};
+    uint64_t vertices      {0}; // Vertices (or indices) submitted, multiplied by the instances
+    uint64_t bufferBytes   {0}; // Buffer data uploaded, including writes to mapped buffers reported with OnMappedWrite
+    uint64_t textureBytes  {0}; // Texture data uploaded
+    uint32_t programBinds  {0};
+    uint32_t textureBinds  {0};
+    uint32_t stateChanges  {0}; // Enable/disable, blend, scissor, viewport, vertex array and framebuffer changes
+    std::unordered_map<uint32_t, uint64_t> bufferUploads; // Bytes uploaded by buffer id
+
+    uint64_t GetUploadedBytes() const { return bufferBytes + textureBytes; }
+};
+
+/**
+ * @brief GL implementation that doesn't draw anything, for runs without a GPU (e.g. CI).
+ *
+ * Load replaces the glad function pointers with no-ops that record what the engine asked for (draw calls, uploads, binds
+ * and state changes). Queries return values that keep the engine running: shaders always compile and link, framebuffers
+ * are complete, fences are signaled and mapped buffers point to memory kept by the backend.
+ */
+class NullGL {
+public:
+    // Must be called instead of gladLoadGLLoader, there is no way back to the real driver
+    static void Load();
+    static bool IsLoaded() { return isLoaded; }
+
+    // Writes to persistently mapped buffers don't go through GL, their owners report them here
+    static void OnMappedWrite(uint32_t buffer, uint64_t size);
+
+    // Starts counting a new frame, the counters of the previous one are returned by GetFrameStats
+    static void NewFrame();
+    static const NullGLStats& GetFrameStats() { return lastFrameStats; }
+
+private:
+    static bool isLoaded;
+    static NullGLStats lastFrameStats;
+};
+
+#endif // __NULLGL_H__
@@ -0,0 +1,87 @@
+#include "RenderBackend.hpp"
+
+#include "GLState.hpp"
+#include "RenderStats.hpp"
+
+#include <cstring>
+#include <glad/glad.h>
+
+template<class T>
+static T ReadUniform(const uint8_t* data, const UniformCommand& uniform) {
+    T value;
+    std::memcpy(&value, data + uniform.dataOffset, sizeof(T));
+    return value;
+}
+
+void GLRenderBackend::Execute(const DrawCommand& command, const UniformCommand* uniforms, const uint8_t* uniformData) {
+    ApplyState(command.state);
+
+    command.shader->Use();
+    for (uint32_t i {0}; i < command.uniformCount; ++i)
+        SetUniform(*command.shader, uniforms[i], uniformData);
+
+    for (int unit {0}; unit < DrawCommand::maxTextures; ++unit) {
+        if (command.textures[unit] != 0)
+            GLState::BindTextureUnit(unit, command.textures[unit]);
+    }
+
+    GLState::BindVertexArray(command.vertexArray);
+    if (command.vertexBuffer != 0)
+        glVertexArrayVertexBuffer(command.vertexArray, 0, command.vertexBuffer, command.vertexOffset, command.vertexStride);
+
+    RenderStats::AddDrawCalls();
+    if (command.indexed) {
+        glDrawElements(ToOpenGL(command.drawMode), command.count, GL_UNSIGNED_INT,
+                       reinterpret_cast<const void*>(static_cast<uintptr_t>(command.first) * sizeof(uint32_t)));
+    }
+    else {
+        glDrawArrays(ToOpenGL(command.drawMode), command.first, command.count);
+    }
+}
+
+void GLRenderBackend::Finish() {
+    ApplyState(RenderState{});
+}
+
+void GLRenderBackend::ApplyState(const RenderState& state) {
+    GLState::SetBlend(state.blend);
+    GLState::SetCullFace(state.cullFace);
+    GLState::SetScissorTest(state.scissorTest);
+    if (state.scissorTest)
+        GLState::SetScissor(state.scissor);
+}
+
+void GLRenderBackend::SetUniform(const Shader& shader, const UniformCommand& uniform, const uint8_t* data) {
+    //! Goes through the shader so the values it caches stay in sync
+    switch (uniform.type) {
+        case UniformType::Int:   shader.SetInt(uniform.uniform, ReadUniform<int>(data, uniform)); break;
+        case UniformType::UInt:  shader.SetUInt(uniform.uniform, ReadUniform<uint32_t>(data, uniform)); break;
+        case UniformType::Float: shader.SetFloat(uniform.uniform, ReadUniform<float>(data, uniform)); break;
+        case UniformType::IVec2: shader.SetIVec2(uniform.uniform, ReadUniform<glm::ivec2>(data, uniform)); break;
+        case UniformType::Vec2:  shader.SetVec2(uniform.uniform, ReadUniform<glm::vec2>(data, uniform)); break;
+        case UniformType::Vec3:  shader.SetVec3(uniform.uniform, ReadUniform<glm::vec3>(data, uniform)); break;
+        case UniformType::Vec4:  shader.SetVec4(uniform.uniform, ReadUniform<glm::vec4>(data, uniform)); break;
+        case UniformType::Mat4:  shader.SetMatrix4(uniform.uniform, ReadUniform<glm::mat4>(data, uniform)); break;
+    }
+}
+
+//+ Recording Backend ===============================================================================
+
+void RecordingRenderBackend::Execute(const DrawCommand& command, const UniformCommand* uniforms, const uint8_t* uniformData) {
+    DrawCommand& recorded {commands.emplace_back(command)};
+    recorded.firstUniform = static_cast<uint32_t>(this->uniforms.size());
+    //+ The values are copied since the list they come from is cleared after executing it
+    for (uint32_t i {0}; i < command.uniformCount; ++i) {
+        UniformCommand& uniform {this->uniforms.emplace_back(uniforms[i])};
+        uniform.dataOffset = static_cast<uint32_t>(this->uniformData.size());
+        const uint8_t* value {uniformData + uniforms[i].dataOffset};
+        this->uniformData.insert(this->uniformData.end(), value, value + GetUniformSize(uniform.type));
+    }
+}
+
+void RecordingRenderBackend::Clear() {
+    commands.clear();
+    uniforms.clear();
+    uniformData.clear();
+    finishedLists = 0;
+}
@@ -0,0 +1,53 @@
+#ifndef __RENDERBACKEND_H__
+#define __RENDERBACKEND_H__
+
+#include "RenderCommands.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Turns recorded draw commands into API calls. Everything is executed on the thread that owns the context.
+ */
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // uniforms points to the command.uniformCount uniforms of the command, their values are read from uniformData
+    virtual void Execute(const DrawCommand& command, const UniformCommand* uniforms, const uint8_t* uniformData) = 0;
+    // Called after the last command of a list, should leave the context as it was before the first one
+    virtual void Finish() { }
+};
+
+class GLRenderBackend : public RenderBackend {
+public:
+    void Execute(const DrawCommand& command, const UniformCommand* uniforms, const uint8_t* uniformData) override;
+    void Finish() override;
+
+private:
+    void ApplyState(const RenderState& state);
+    void SetUniform(const Shader& shader, const UniformCommand& uniform, const uint8_t* data);
+};
+
+// Keeps a copy of what it is asked to execute instead of drawing it, so the recorded output can be checked without a GPU
+class RecordingRenderBackend : public RenderBackend {
+public:
+    void Execute(const DrawCommand& command, const UniformCommand* uniforms, const uint8_t* uniformData) override;
+    void Finish() override { ++finishedLists; }
+    void Clear();
+
+    // Commands in execution order, their firstUniform indexes GetUniforms
+    const std::vector<DrawCommand>& GetCommands() const { return commands; }
+    // Uniforms of the commands, their dataOffset indexes GetUniformData
+    const std::vector<UniformCommand>& GetUniforms() const { return uniforms; }
+    const std::vector<uint8_t>& GetUniformData() const { return uniformData; }
+    uint32_t GetFinishedLists() const { return finishedLists; }
+
+private:
+    std::vector<DrawCommand> commands;
+    std::vector<UniformCommand> uniforms;
+    std::vector<uint8_t> uniformData;
+    uint32_t finishedLists {0};
+};
+
+#endif // __RENDERBACKEND_H__
@@ -0,0 +1,96 @@
+#include "RenderCommands.hpp"
+
+#include "RenderBackend.hpp"
+#include "RenderStats.hpp"
+
+#include <algorithm>
+
+//+ Command List ====================================================================================
+
+DrawCommand& RenderCommandList::Record(uint64_t sortKey, const Shader& shader, const VertexArray& vertexArray) {
+    DrawCommand& command {commands.emplace_back()};
+    command.sortKey = sortKey;
+    command.shader = &shader;
+    command.vertexArray = vertexArray.GetID();
+    command.drawMode = vertexArray.GetDrawMode();
+    command.indexed = vertexArray.GetIndicesCount() != 0;
+    command.count = command.indexed ? vertexArray.GetIndicesCount() : vertexArray.GetVerticesCount();
+    command.state = state;
+    command.firstUniform = static_cast<uint32_t>(uniforms.size());
+    return command;
+}
+
+void RenderCommandList::Clear() {
+    commands.clear();
+    uniforms.clear();
+    uniformData.clear();
+    state = RenderState{};
+    sequence = 0;
+}
+
+//+ Render Queue ====================================================================================
+
+std::vector<Owned<RenderCommandList>> RenderQueue::lists;
+std::mutex RenderQueue::listsMutex;
+RenderCommandList RenderQueue::merged;
+RenderCommandList RenderQueue::capture;
+bool RenderQueue::captureNext {false};
+uint32_t RenderQueue::executedCommands {0};
+
+RenderCommandList& RenderQueue::GetList() {
+    thread_local RenderCommandList* threadList {nullptr};
+    if (!threadList) {
+        std::lock_guard<std::mutex> lock {listsMutex};
+        threadList = lists.emplace_back(MakeOwned<RenderCommandList>()).get();
+    }
+    return *threadList;
+}
+
+void RenderQueue::Execute(RenderBackend& backend) {
+    //+ Merge every list in a single one (uniforms are rebased, the commands keep the order of the lists)
+    merged.Clear();
+    {
+        std::lock_guard<std::mutex> lock {listsMutex};
+        for (auto& list : lists) {
+            uint32_t uniformBase {static_cast<uint32_t>(merged.uniforms.size())};
+            uint32_t dataBase {static_cast<uint32_t>(merged.uniformData.size())};
+            for (const DrawCommand& command : list->commands) {
+                merged.commands.push_back(command);
+                merged.commands.back().firstUniform += uniformBase;
+            }
+            for (const UniformCommand& uniform : list->uniforms) {
+                merged.uniforms.push_back(uniform);
+                merged.uniforms.back().dataOffset += dataBase;
+            }
+            merged.uniformData.insert(merged.uniformData.end(), list->uniformData.begin(), list->uniformData.end());
+            list->Clear();
+        }
+    }
+
+    std::stable_sort(merged.commands.begin(), merged.commands.end(), [](const DrawCommand& a, const DrawCommand& b) {
+        return a.sortKey < b.sortKey;
+    });
+
+    ExecuteList(merged, backend);
+    RenderStats::AddUICommands(executedCommands);
+
+    if (captureNext) {
+        captureNext = false;
+        capture.commands = merged.commands;
+        capture.uniforms = merged.uniforms;
+        capture.uniformData = merged.uniformData;
+    }
+}
+
+void RenderQueue::ReplayCapture(RenderBackend& backend) {
+    ExecuteList(capture, backend);
+}
+
+void RenderQueue::ExecuteList(const RenderCommandList& list, RenderBackend& backend) {
+    for (const DrawCommand& command : list.commands) {
+        const UniformCommand* uniforms {command.uniformCount > 0 ? &list.uniforms[command.firstUniform] : nullptr};
+        backend.Execute(command, uniforms, list.uniformData.data());
+    }
+    backend.Finish();
+    executedCommands = static_cast<uint32_t>(list.commands.size());
+}
@@ -0,0 +1,183 @@
+#ifndef __RENDERCOMMANDS_H__
+#define __RENDERCOMMANDS_H__
+
+#include "Common.hpp"
+#include "GLState.hpp"
+#include "Shader.hpp"
+#include "VertexArray.hpp"
+
+#include <cstring>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class RenderBackend;
+
+//+ Commands ========================================================================================
+
+// Passes occupy the top byte of the sort keys, so everything of a pass is executed before the next one
+enum class RenderPass : uint8_t {
+    World = 0,
+    UI    = 128
+};
+
+struct RenderState {
+    BlendMode blend  {BlendMode::None};
+    bool cullFace    {false};
+    bool scissorTest {false};
+    glm::ivec4 scissor {0}; // x, y, width, height
+};
+
+enum class UniformType : uint8_t {
+    Int,
+    UInt,
+    Float,
+    IVec2,
+    Vec2,
+    Vec3,
+    Vec4,
+    Mat4
+};
+
+template<class T> struct UniformTypeOf;
+template<> struct UniformTypeOf<int>       { static constexpr UniformType value {UniformType::Int}; };
+template<> struct UniformTypeOf<uint32_t>  { static constexpr UniformType value {UniformType::UInt}; };
+template<> struct UniformTypeOf<float>     { static constexpr UniformType value {UniformType::Float}; };
+template<> struct UniformTypeOf<glm::ivec2>{ static constexpr UniformType value {UniformType::IVec2}; };
+template<> struct UniformTypeOf<glm::vec2> { static constexpr UniformType value {UniformType::Vec2}; };
+template<> struct UniformTypeOf<glm::vec3> { static constexpr UniformType value {UniformType::Vec3}; };
+template<> struct UniformTypeOf<glm::vec4> { static constexpr UniformType value {UniformType::Vec4}; };
+template<> struct UniformTypeOf<glm::mat4> { static constexpr UniformType value {UniformType::Mat4}; };
+
+// Bytes taken by a value of the type in the uniform data
+inline uint32_t GetUniformSize(UniformType type) {
+    switch (type) {
+        case UniformType::Int:   return sizeof(int);
+        case UniformType::UInt:  return sizeof(uint32_t);
+        case UniformType::Float: return sizeof(float);
+        case UniformType::IVec2: return sizeof(glm::ivec2);
+        case UniformType::Vec2:  return sizeof(glm::vec2);
+        case UniformType::Vec3:  return sizeof(glm::vec3);
+        case UniformType::Vec4:  return sizeof(glm::vec4);
+        case UniformType::Mat4:  return sizeof(glm::mat4);
+    }
+    return 0;
+}
+
+// Value of a uniform for one draw, the value itself is stored in the uniform data of the list
+struct UniformCommand {
+    UniformHandle uniform;
+    UniformType type;
+    uint32_t dataOffset;
+};
+
+/**
+ * @brief Everything needed to issue one draw, made of plain values so it can be recorded on any thread, stored,
+ * compared and replayed without touching the GL context. The shader is referenced directly so its uniform handles
+ * and cached values stay valid, even across hot reloads.
+ */
+struct DrawCommand {
+    static constexpr int maxTextures {2};
+
+    uint64_t sortKey       {0};
+    const Shader* shader   {nullptr};
+    uint32_t vertexArray   {0};
+    // A vertex buffer different than 0 replaces the one of the vertex array (e.g. a region of a StreamingBuffer)
+    uint32_t vertexBuffer  {0};
+    uint32_t vertexOffset  {0};
+    uint32_t vertexStride  {0};
+    uint32_t textures[maxTextures] {0, 0}; // Texture bound to each unit, 0 leaves the unit untouched
+    DrawMode drawMode      {DrawMode::Triangles};
+    bool indexed           {false};
+    uint32_t first         {0}; // First vertex, or first index when indexed
+    uint32_t count         {0};
+    RenderState state;
+    uint32_t firstUniform  {0};
+    uint32_t uniformCount  {0};
+};
+
+//+ Command List ====================================================================================
+
+/**
+ * @brief Draws recorded by a single thread. Uniforms set after Record belong to the last recorded draw.
+ */
+class RenderCommandList {
+public:
+    // Adds a draw of the whole vertex array using the current state of the list, the rest of the command can be
+    // filled through the returned reference
+    DrawCommand& Record(uint64_t sortKey, const Shader& shader, const VertexArray& vertexArray);
+
+    template<class T>
+    void SetUniform(UniformHandle handle, const T& value) {
+        if (!handle.IsValid() || commands.empty())
+            return;
+
+        UniformCommand uniform {handle, UniformTypeOf<T>::value, static_cast<uint32_t>(uniformData.size())};
+        uniformData.resize(uniformData.size() + sizeof(T));
+        std::memcpy(&uniformData[uniform.dataOffset], &value, sizeof(T));
+        uniforms.push_back(uniform);
+        ++commands.back().uniformCount;
+    }
+
+    // State applied to the draws recorded from now on
+    RenderState& GetState() { return state; }
+    void SetState(const RenderState& state) { this->state = state; }
+
+    // Keys that keep the recording order inside of the pass
+    uint64_t NextSequentialKey(RenderPass pass) { return (static_cast<uint64_t>(pass) << 56) | (sequence++ & 0x00ffffffffffffff); }
+
+    void Clear();
+    bool IsEmpty() const { return commands.empty(); }
+
+    const std::vector<DrawCommand>& GetCommands() const { return commands; }
+    const std::vector<UniformCommand>& GetUniforms() const { return uniforms; }
+    const std::vector<uint8_t>& GetUniformData() const { return uniformData; }
+
+private:
+    std::vector<DrawCommand> commands;
+    std::vector<UniformCommand> uniforms;
+    std::vector<uint8_t> uniformData;
+    RenderState state;
+    uint64_t sequence {0};
+
+    friend class RenderQueue;
+};
+
+//+ Render Queue ====================================================================================
+
+/**
+ * @brief Collects the command lists of every recording thread, then merges them, sorts them by key and executes
+ * them on the main thread through a RenderBackend.
+ */
+class RenderQueue {
+public:
+    // List of the calling thread, created the first time a thread asks for it
+    static RenderCommandList& GetList();
+
+    // Executes and clears everything recorded so far, draws with equal keys keep their recording order
+    static void Execute(RenderBackend& backend);
+
+    // The next Execute keeps a copy of its sorted commands so they can be inspected or replayed
+    static void CaptureNextExecute() { captureNext = true; }
+    static const RenderCommandList& GetCapture() { return capture; }
+    //! Resources referenced by the capture (e.g. streaming buffer regions) may have changed since it was recorded
+    static void ReplayCapture(RenderBackend& backend);
+
+    // Draws executed by the last Execute
+    static uint32_t GetExecutedCommands() { return executedCommands; }
+
+private:
+    static void ExecuteList(const RenderCommandList& list, RenderBackend& backend);
+
+private:
+    static std::vector<Owned<RenderCommandList>> lists;
+    static std::mutex listsMutex;
+    static RenderCommandList merged;
+    static RenderCommandList capture;
+    static bool captureNext;
+    static uint32_t executedCommands;
+};
+
+#endif // __RENDERCOMMANDS_H__
@@ -0,0 +1,133 @@
+#include "RenderStats.hpp"
+
+#include <algorithm>
+#include <fmt/core.h>
+#include <imgui.h>
+
+RenderStatsFrame RenderStats::current;
+std::array<RenderStatsFrame, RenderStats::historySize> RenderStats::history {};
+uint32_t RenderStats::nextFrame {0};
+uint32_t RenderStats::frameCount {0};
+
+uint32_t RenderStatsFrame::GetTotalFlushes() const {
+    uint32_t total {0};
+    for (uint32_t count : flushes)
+        total += count;
+    return total;
+}
+
+void RenderStats::AddCulled(uint32_t sprites, uint32_t chunks, uint32_t tiles) {
+    current.culledSprites += sprites;
+    current.culledChunks += chunks;
+    current.culledTiles += tiles;
+}
+
+void RenderStats::EndFrame(float frameTime) {
+    current.frameTime = frameTime;
+    history[nextFrame] = current;
+    nextFrame = (nextFrame + 1) % historySize;
+    frameCount = std::min(frameCount + 1, historySize);
+    current = RenderStatsFrame{};
+}
+
+const RenderStatsFrame& RenderStats::GetFrame(uint32_t framesAgo) {
+    return history[(nextFrame + historySize - 1 - framesAgo) % historySize];
+}
+
+RenderStatsFrame RenderStats::GetAverage(uint32_t frames) {
+    RenderStatsFrame average;
+    frames = std::min(frames, frameCount);
+    if (frames == 0)
+        return average;
+
+    // Summed in wider types so long histories don't overflow
+    double frameTime {0.0};
+    std::array<uint64_t, 11> sums {};
+    std::array<uint64_t, static_cast<size_t>(FlushCause::Count)> flushes {};
+    for (uint32_t i {0}; i < frames; ++i) {
+        const RenderStatsFrame& frame {GetFrame(i)};
+        frameTime += frame.frameTime;
+        sums[0] += frame.drawCalls;
+        sums[1] += frame.spriteQuads;
+        sums[2] += frame.spriteInstances;
+        sums[3] += frame.tiles;
+        sums[4] += frame.glyphs;
+        sums[5] += frame.uiCommands;
+        sums[6] += frame.uploadedBytes;
+        sums[7] += frame.shaderSwitches;
+        sums[8] += frame.culledSprites;
+        sums[9] += frame.culledChunks;
+        sums[10] += frame.culledTiles;
+        for (size_t cause {0}; cause < flushes.size(); ++cause)
+            flushes[cause] += frame.flushes[cause];
+    }
+
+    average.frameTime = static_cast<float>(frameTime / frames);
+    average.drawCalls = static_cast<uint32_t>(sums[0] / frames);
+    average.spriteQuads = static_cast<uint32_t>(sums[1] / frames);
+    average.spriteInstances = static_cast<uint32_t>(sums[2] / frames);
+    average.tiles = static_cast<uint32_t>(sums[3] / frames);
+    average.glyphs = static_cast<uint32_t>(sums[4] / frames);
+    average.uiCommands = static_cast<uint32_t>(sums[5] / frames);
+    average.uploadedBytes = sums[6] / frames;
+    average.shaderSwitches = static_cast<uint32_t>(sums[7] / frames);
+    average.culledSprites = static_cast<uint32_t>(sums[8] / frames);
+    average.culledChunks = static_cast<uint32_t>(sums[9] / frames);
+    average.culledTiles = static_cast<uint32_t>(sums[10] / frames);
+    for (size_t cause {0}; cause < flushes.size(); ++cause)
+        average.flushes[cause] = static_cast<uint32_t>(flushes[cause] / frames);
+    return average;
+}
+
+void RenderStats::ClearHistory() {
+    nextFrame = 0;
+    frameCount = 0;
+}
+
+void RenderStats::DebugGUI() {
+    ImGui::Begin("Render Stats");
+    if (frameCount == 0) {
+        ImGui::Text("No frames rendered yet");
+        ImGui::End();
+        return;
+    }
+
+    const RenderStatsFrame& last {GetLastFrame()};
+    RenderStatsFrame average {GetAverage(historySize)};
+    ImGui::Text("Frame: %.2f ms (avg %.2f ms over %u frames)", last.frameTime, average.frameTime, frameCount);
+    ImGui::Text("Draw calls: %u (avg %u)", last.drawCalls, average.drawCalls);
+    ImGui::Text("Flushes: %u buffer full, %u texture slots, %u batch change, %u end of pass",
+                last.GetFlushes(FlushCause::BufferFull), last.GetFlushes(FlushCause::TextureSlots),
+                last.GetFlushes(FlushCause::BatchChange), last.GetFlushes(FlushCause::EndOfPass));
+    ImGui::Text("Sprites: %u quads, %u instances", last.spriteQuads, last.spriteInstances);
+    ImGui::Text("Tiles: %u, Glyphs: %u, UI commands: %u", last.tiles, last.glyphs, last.uiCommands);
+    ImGui::Text("Uploaded: %.1f KB (avg %.1f KB)", last.uploadedBytes / 1024.0f, average.uploadedBytes / 1024.0f);
+    ImGui::Text("Shader switches: %u", last.shaderSwitches);
+    ImGui::Text("Culled: %u sprites, %u static chunks, %u tiles", last.culledSprites, last.culledChunks, last.culledTiles);
+    ImGui::Separator();
+
+    //+ History graphs, oldest frame on the left
+    struct Graph {
+        const char* label;
+        float (*value)(const RenderStatsFrame&);
+    };
+    static const Graph graphs[] {
+        {"Frame (ms)", [](const RenderStatsFrame& frame) { return frame.frameTime; }},
+        {"Draw calls", [](const RenderStatsFrame& frame) { return static_cast<float>(frame.drawCalls); }},
+        {"Flushes",    [](const RenderStatsFrame& frame) { return static_cast<float>(frame.GetTotalFlushes()); }},
+        {"Upload (KB)",[](const RenderStatsFrame& frame) { return frame.uploadedBytes / 1024.0f; }}
+    };
+    for (const Graph& graph : graphs) {
+        float maxValue {0.0f};
+        for (uint32_t i {0}; i < frameCount; ++i)
+            maxValue = std::max(maxValue, graph.value(GetFrame(i)));
+
+        auto getter {[](void* data, int idx) {
+            auto value {static_cast<const Graph*>(data)->value};
+            return value(GetFrame(frameCount - 1 - static_cast<uint32_t>(idx)));
+        }};
+        ImGui::PlotLines(graph.label, getter, const_cast<Graph*>(&graph), static_cast<int>(frameCount), 0,
+                         fmt::format("{:.1f}", graph.value(last)).c_str(), 0.0f, maxValue * 1.1f + 1.0f, ImVec2{0, 50});
+    }
+    ImGui::End();
+}
@@ -0,0 +1,83 @@
+#ifndef __RENDERSTATS_H__
+#define __RENDERSTATS_H__
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// Why a batch was drawn before the end of its pass
+enum class FlushCause : uint8_t {
+    // Its vertex or instance stream region was full
+    BufferFull,
+    // Every texture slot was in use
+    TextureSlots,
+    // The next draw needed another batch, mode or material (flushed to keep the draw order)
+    BatchChange,
+    // Explicit flush once everything was submitted
+    EndOfPass,
+    Count
+};
+
+struct RenderStatsFrame {
+    float frameTime         {0.0f}; // Milliseconds
+    uint32_t drawCalls      {0};
+    std::array<uint32_t, static_cast<size_t>(FlushCause::Count)> flushes {};
+    uint32_t spriteQuads    {0};    // Including the static sprites
+    uint32_t spriteInstances{0};
+    uint32_t tiles          {0};
+    uint32_t glyphs         {0};
+    uint32_t uiCommands     {0};
+    uint64_t uploadedBytes  {0};    // Buffer data, streaming buffer writes and texture uploads
+    uint32_t shaderSwitches {0};
+    uint32_t culledSprites  {0};
+    uint32_t culledChunks   {0};
+    uint32_t culledTiles    {0};
+
+    uint32_t GetFlushes(FlushCause cause) const { return flushes[static_cast<size_t>(cause)]; }
+    uint32_t GetTotalFlushes() const;
+};
+
+/**
+ * @brief Counters of what each frame rendered, filled by the batches, the tilemap pass and the UI. The last historySize
+ * frames are kept so they can be graphed or averaged (e.g. by benchmarks).
+ *
+ * //! Only counts what happens in the render thread
+ */
+class RenderStats {
+public:
+    static constexpr uint32_t historySize {240};
+
+    static void AddDrawCalls(uint32_t count = 1) { current.drawCalls += count; }
+    static void AddFlush(FlushCause cause) { ++current.flushes[static_cast<size_t>(cause)]; }
+    static void AddSpriteQuads(uint32_t count) { current.spriteQuads += count; }
+    static void AddSpriteInstances(uint32_t count) { current.spriteInstances += count; }
+    static void AddTiles(uint32_t count) { current.tiles += count; }
+    static void AddGlyphs(uint32_t count) { current.glyphs += count; }
+    static void AddUICommands(uint32_t count) { current.uiCommands += count; }
+    static void AddUploadedBytes(uint64_t size) { current.uploadedBytes += size; }
+    static void AddShaderSwitch() { ++current.shaderSwitches; }
+    static void AddCulled(uint32_t sprites, uint32_t chunks, uint32_t tiles);
+
+    // Stores the counters of the frame in the history and starts a new one
+    static void EndFrame(float frameTime);
+
+    // framesAgo = 0 is the last finished frame. Must be less than GetFrameCount
+    static const RenderStatsFrame& GetFrame(uint32_t framesAgo);
+    static const RenderStatsFrame& GetLastFrame() { return GetFrame(0); }
+    // Frames in the history, up to historySize
+    static uint32_t GetFrameCount() { return frameCount; }
+    // Average of the last frames (or of every frame in the history if there are less)
+    static RenderStatsFrame GetAverage(uint32_t frames);
+    static void ClearHistory();
+
+    // ImGui window with the last frame counters and graphs of the history
+    static void DebugGUI();
+
+private:
+    static RenderStatsFrame current;
+    static std::array<RenderStatsFrame, historySize> history;
+    static uint32_t nextFrame;
+    static uint32_t frameCount;
+};
+
+#endif // __RENDERSTATS_H__
@@ -1,5 +1,6 @@
 #include "Renderer.hpp"
 
+#include "Batch.hpp"
 #include "Camera.hpp"
 #include "Core/AssetManager.hpp"
 #include "Core/Engine.hpp"
@@ -7,8 +8,14 @@
 #include "Core/Log.hpp"
 #include "Core/Time.hpp"
 #include "Core/Scene.hpp"
+#include "GLState.hpp"
+#include "NullGL.hpp"
+#include "RenderCommands.hpp"
+#include "RenderStats.hpp"
 #include "Shader.hpp"
+#include "UI/Label.hpp"
 #include "UI/Panel.hpp"
+#include "UI/Text/FontFace.hpp"
 #include "UI/Text/TextRenderer.hpp"
 #include "UI/UIStack.hpp"
 #include "VertexArray.hpp"
@@ -25,13 +32,87 @@
 #include <imgui_impl_sdl.h>
 #endif  // IMGUI
 
-Renderer::Renderer(Engine* engine, glm::ivec2 screenSize, const std::string& windowTitle, bool fullscreen) 
-    : _screenSize{screenSize}, /*_virtualScreenSize{640, 360},*/ fullscreen{fullscreen}, engine{engine} {
+Renderer::Renderer(Engine* engine, glm::ivec2 screenSize, const std::string& windowTitle, bool fullscreen, bool headless) 
+    : _screenSize{screenSize}, /*_virtualScreenSize{640, 360},*/ fullscreen{fullscreen}, engine{engine}, headless{headless} {
     
+    if (headless) {
+        //+ No window nor context, every GL call goes to the null backend which only counts them
+        if (SDL_Init(SDL_INIT_EVENTS) != 0) {
+            LOG_CRITICAL("Could not initialize SDL: {}.", SDL_GetError());
+            engine->Shutdown();
+            return;
+        }
+        NullGL::Load();
+        Shader::EnableBinaryCache(false);
+    }
+    else if (!CreateWindowAndContext(windowTitle)) {
+        return;
+    }
+
+    glViewport(0, 0, _screenSize.x, _screenSize.y);
+    worldViewport = glm::ivec4{0, 0, _screenSize.x, _screenSize.y};
+
+#ifdef IMGUI
+    // ImGui
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    io = &ImGui::GetIO();
+    (void)io;
+    // io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+    // io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+
+    // io->IniFilename = nullptr; // Disables ini saving file (layout file)
+
+    ImGui::StyleColorsDark();
+
+    if (headless) {
+        //! Without the platform and renderer bindings ImGui still needs the display size and a built font atlas
+        io->IniFilename = nullptr;
+        io->DisplaySize = ImVec2{static_cast<float>(_screenSize.x), static_cast<float>(_screenSize.y)};
+        unsigned char* fontPixels;
+        int fontWidth, fontHeight;
+        io->Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+    }
+    else {
+        // Platform bindings
+        ImGui_ImplSDL2_InitForOpenGL(window, context);
+        ImGui_ImplOpenGL3_Init("#version 130");
+    }
+#endif  // IMGUI
+
+    LOG_INFO(GetGraphicsInfo());
+
+    LoadData();
+
+    //+ Events
+    engine->OnWindowSizeChanged.Subscribe("WindowSizeChanged", &Renderer::OnWindowSizeChanged, this);
+}
+
+Renderer::~Renderer() {
+    //+ Events
+    engine->OnWindowSizeChanged.Unsubscribe("WindowSizeChanged", this);
+
+#ifdef IMGUI
+    if (!headless) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplSDL2_Shutdown();
+    }
+    ImGui::DestroyContext();
+#endif  // IMGUI
+
+    // SDL
+    if (context)
+        SDL_GL_DeleteContext(context);
+    if (window)
+        SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+bool Renderer::CreateWindowAndContext(const std::string& windowTitle) {
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         LOG_CRITICAL("Could not initialize SDL: {}.", SDL_GetError());
         engine->Shutdown();
-        return;
+        return false;
     }
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
@@ -65,7 +146,7 @@ Renderer::Renderer(Engine* engine, glm::ivec2 screenSize, const std::string& win
     if (!window) {
         LOG_CRITICAL("Failed to create Window: {}.", SDL_GetError());
         engine->Shutdown();
-        return;
+        return false;
     }
 
     // // Set window icon (needs SLD_image)
@@ -81,61 +162,20 @@ Renderer::Renderer(Engine* engine, glm::ivec2 screenSize, const std::string& win
     if (!context) {
         LOG_CRITICAL("Failed to create OpenGL Context: {}.", SDL_GetError());
         engine->Shutdown();
-        return;
+        return false;
     }
 
     if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
         LOG_CRITICAL("Failed to initialize GLAD.");
         engine->Shutdown();
-        return;
+        return false;
     }
 
-    glViewport(0, 0, _screenSize.x, _screenSize.y);
-
-#ifdef IMGUI
-    // ImGui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    io = &ImGui::GetIO();
-    (void)io;
-    // io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
-    // io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
-
-    // io->IniFilename = nullptr; // Disables ini saving file (layout file)
-
-    ImGui::StyleColorsDark();
-
-    // Platform bindings
-    ImGui_ImplSDL2_InitForOpenGL(window, context);
-    ImGui_ImplOpenGL3_Init("#version 130");
-#endif  // IMGUI
-
-    LOG_INFO(GetGraphicsInfo());
-
-    LoadData();
-
-    //+ Events
-    engine->OnWindowSizeChanged.Subscribe("WindowSizeChanged", &Renderer::OnWindowSizeChanged, this);
-}
-
-Renderer::~Renderer() {
-    //+ Events
-    engine->OnWindowSizeChanged.Unsubscribe("WindowSizeChanged", this);
-
-#ifdef IMGUI
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplSDL2_Shutdown();
-    ImGui::DestroyContext();
-#endif  // IMGUI
-
-    // SDL
-    SDL_GL_DeleteContext(context);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    return true;
 }
 
 void Renderer::LoadData() {
-    auto globalsUBO {AssetManager::AddBuffer("Globals", MakeRef<UniformBuffer>(208, 0))};
+    auto globalsUBO {AssetManager::AddBuffer("Globals", MakeRef<UniformBuffer>(224, 0))};
     globalsUBO->SetData(0, 8, glm::value_ptr(_screenSize));
     // globalsUBO->SetData(8, 8, glm::value_ptr(_virtualScreenSize));
 
@@ -201,18 +241,45 @@ void Renderer::Draw() {
     // glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     // glClear(GL_COLOR_BUFFER_BIT);
     float clearColor[] { 0.1f, 0.1f, 0.1f, 1.0f };
-    defaultFBO.ClearColor(clearColor);
+    GLState::NewFrame();
+    GlyphCache::NewFrame();
 
 #ifdef IMGUI
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplSDL2_NewFrame();
+    if (!headless) {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplSDL2_NewFrame();
+    }
+    else {
+        io->DeltaTime = Time::deltaTime > 0.0f ? Time::deltaTime : 1.0f / 60.0f;
+    }
     ImGui::NewFrame();
 #endif  // IMGUI
 
+    //! Global time used by shader side animations (e.g. animated tiles)
+    AssetManager::GetBuffer("Globals")->SetData(208, sizeof(float), &Time::time);
+
+    //+ The world is rasterized at the virtual size (pixel art doesn't gain anything from more fragments)
+    if (useVirtualTarget) {
+        glm::ivec2 virtualSize {Camera::GetMainCamera().GetVirtualSize()};
+        UpdateVirtualTarget(virtualSize);
+        virtualTarget.ClearColor(clearColor);
+        virtualTarget.Bind();
+        glViewport(0, 0, virtualSize.x, virtualSize.y);
+    }
+    else {
+        defaultFBO.ClearColor(clearColor);
+        worldViewport = glm::ivec4{0, 0, _screenSize.x, _screenSize.y};
+    }
+
     //+ Render anything in here ===============================================
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    //! The scene still draws immediately, only the UI pass goes through the render queue (the sprite batches bind more
+    //! textures than a DrawCommand holds and the world is resolved into the virtual target before the UI)
     engine->GetActiveScene()->Render();
 
+    if (useVirtualTarget)
+        PresentVirtualTarget();
+
     // glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     //! Render grid
     auto& grid2dVAO {AssetManager::GetVertexArray("screenQuad")};
@@ -221,27 +288,24 @@ void Renderer::Draw() {
     // grid2dShader->SetInt("tileSize", 16);
     grid2dShader->SetIVec2("tileSize", glm::ivec2{16});
     grid2dShader->SetVec3("cameraPos", Camera::GetMainCamera().GetPosition());
-    glEnable(GL_BLEND);
-    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+    grid2dShader->SetIVec4("viewport", worldViewport);
+    glViewport(worldViewport.x, worldViewport.y, worldViewport.z, worldViewport.w);
+    GLState::SetBlend(BlendMode::AlphaOverwrite);
     grid2dVAO->Use();
     grid2dVAO->Draw();
-    glDisable(GL_BLEND);
+    GLState::SetBlend(BlendMode::None);
+    glViewport(0, 0, _screenSize.x, _screenSize.y);
 
     //! Render UI
     //+ Sprites used in UI will ignore the sprite pivot, widget pivot should be used instead!
-    glEnable(GL_BLEND);
-    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
-    // TODO: If different gui elements need different shaders, use the shader in there and remove it from here (and optimize)
-    auto uiShader{AssetManager::GetShader("gui")};
-    uiShader->Use();
-    auto vao{AssetManager::GetVertexArray("gui")};
-    vao->Use();
+    //+ Widgets record their draws in the render queue, executed right after
+    RenderQueue::GetList().GetState().blend = BlendMode::AlphaOverwrite;
     // for (auto& panel : engine->GetUIStack()->panels) {
     //     if (panel->IsVisible())
     //         panel->RenderWidgets();
     // }
     engine->GetUIStack()->Render();
-    glDisable(GL_BLEND);
+    RenderQueue::Execute(renderBackend);
 
     //+ =======================================================================
 #ifdef IMGUI
@@ -267,6 +331,63 @@ void Renderer::Draw() {
     ImGui::End();
     // ============================================
 
+    // Render Settings: ===========================
+    ImGui::Begin("Render Settings");
+    ImGui::Checkbox("Sprite texture array", &SpriteBatch::useTextureArray);
+    ImGui::Checkbox("Sprite instancing", &SpriteInstanceBatch::useInstancing);
+    ImGui::Checkbox("Bulk sprite submission", &SpriteBatch::useBulkSubmission);
+    ImGui::Checkbox("Cached label text meshes", &Label::useTextMeshes);
+    if (SpriteBatch::useBulkSubmission) {
+        ImGui::Checkbox("Validate against scalar path", &SpriteBatch::validateBulkSubmission);
+        ImGui::SameLine();
+        ImGui::Text("(%u mismatches)", SpriteBatch::bulkMismatches.load());
+    }
+    ImGui::Checkbox("Virtual resolution target", &useVirtualTarget);
+    if (useVirtualTarget) {
+        int mode {static_cast<int>(upscaleMode)};
+        if (ImGui::Combo("Upscale", &mode, "Stretch\0Integer\0Sharp bilinear\0"))
+            upscaleMode = static_cast<UpscaleMode>(mode);
+        ImGui::Text("World: %dx%d fragments shown at %dx%d", virtualTargetColor.GetWidth(), virtualTargetColor.GetHeight(),
+                    worldViewport.z, worldViewport.w);
+    }
+    ImGui::Checkbox("Camera culling", &Scene::useCulling);
+    auto& cullInfo {engine->GetActiveScene()->GetCullInfo()};
+    ImGui::Text("Sprites: %u submitted, %u culled", cullInfo.spritesSubmitted, cullInfo.spritesCulled);
+    ImGui::Text("Static chunks: %u drawn, %u culled", cullInfo.staticChunksDrawn, cullInfo.staticChunksCulled);
+    ImGui::Text("Tiles: %u submitted, %u culled", cullInfo.tilesSubmitted, cullInfo.tilesCulled);
+    ImGui::Separator();
+    auto& staticSprites {engine->GetActiveScene()->GetStaticSprites()};
+    ImGui::Text("Static sprites: %u in %u chunks (%u rebuilt)", staticSprites.GetSpriteCount(), staticSprites.GetChunkCount(), staticSprites.GetRebuiltChunks());
+    ImGui::Separator();
+    ImGui::Text("Streaming buffers (last frame):");
+    for (auto& [name, stream] : {std::make_pair("Sprites", SpriteBatch::GetVertexStream()),
+                                 std::make_pair("Instances", SpriteInstanceBatch::GetInstanceStream()),
+                                 std::make_pair("Text", TextBatch::GetVertexStream())}) {
+        auto& stats {stream->GetStats()};
+        ImGui::Text("%s: %.1f KB uploaded, %u fence waits (%.3f ms)", name, stats.uploadedBytes / 1024.0f, stats.fenceWaits, stats.fenceWaitTime);
+    }
+    auto& glyphStats {GlyphCache::GetStats()};
+    ImGui::Text("Glyph cache: %u glyphs in %u shelves, %u rasterized, %u evicted (%u shelves), %u failed", glyphStats.cachedGlyphs,
+                glyphStats.shelves, glyphStats.rasterizedGlyphs, glyphStats.evictedGlyphs, glyphStats.evictedShelves, glyphStats.failedGlyphs);
+    auto& fontCacheStats {FontFace::GetCacheStats()};
+    ImGui::Text("Font cache: %u fonts cached, %u glyphs read, %u rasterized", fontCacheStats.cachedFonts,
+                fontCacheStats.cachedGlyphs, fontCacheStats.rasterizedGlyphs);
+    ImGui::Separator();
+    ImGui::Text("Render queue: %u commands executed", RenderQueue::GetExecutedCommands());
+    auto& stateStats {GLState::GetFrameStats()};
+    ImGui::Text("GL state changes: %u issued, %u skipped", stateStats.issued, stateStats.skipped);
+    ImGui::Text("Uniform uploads: %u issued, %u skipped", Shader::GetUploadedUniforms(), Shader::GetSkippedUniforms());
+    if (ImGui::Button("Capture UI frame"))
+        RenderQueue::CaptureNextExecute();
+    ImGui::SameLine();
+    ImGui::Text("(%zu commands captured)", RenderQueue::GetCapture().GetCommands().size());
+    static bool replayCapture {false};
+    ImGui::Checkbox("Replay capture over the UI", &replayCapture);
+    ImGui::End();
+    // ============================================
+
+    RenderStats::DebugGUI();
+
     engine->GetActiveScene()->DebugGUI();
 
     for (auto& go : engine->GetActiveScene()->gameobjects) {
@@ -275,12 +396,27 @@ void Renderer::Draw() {
         }
     }
 
+    if (replayCapture)
+        RenderQueue::ReplayCapture(renderBackend);
+
     ImGui::Render();
     // glViewport(0, 0, (int)io->DisplaySize.x, (int)io->DisplaySize.y);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (!headless)
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    //! ImGui binds and toggles state on its own
+    GLState::Invalidate();
 #endif  // IMGUI
 
-    SDL_GL_SwapWindow(window);
+    //! Fence what the streaming buffers got this frame, the next one writes to their following regions. Their counters
+    //! are stored here too, so headless runs (without the debug window) get per frame values
+    for (auto& stream : {SpriteBatch::GetVertexStream(), SpriteInstanceBatch::GetInstanceStream(), TextBatch::GetVertexStream()})
+        stream->EndFrame();
+
+    Shader::EndFrame();
+    RenderStats::EndFrame(Time::deltaTime * 1000.0f);
+
+    if (!headless)
+        SDL_GL_SwapWindow(window);
 }
 
 void Renderer::SetViewport(int x, int y, int width, int height) {
@@ -297,6 +433,58 @@ void Renderer::SetScreenSize(int width, int height) {
 //     AssetManager::GetBuffer("Globals")->SetData(16, 8, glm::value_ptr(_virtualScreenSize));
 // }
 
+void Renderer::UpdateVirtualTarget(const glm::ivec2& virtualSize) {
+    if (!virtualTargetColor.IsNull() && virtualTargetColor.GetWidth() == virtualSize.x && virtualTargetColor.GetHeight() == virtualSize.y)
+        return;
+
+    virtualTargetColor.Generate(virtualSize.x, virtualSize.y, nullptr, TextureFormat::RGBA8, TextureFormat::RGBA);
+    virtualTargetColor.SetMinFilter(TextureParameter::Nearest).SetMagFilter(TextureParameter::Nearest)
+        .SetWrapS(TextureParameter::ClampToEdge).SetWrapT(TextureParameter::ClampToEdge);
+
+    virtualTarget.Create();
+    virtualTarget.AddColorTexture(0, &virtualTargetColor, 0);
+    if (!virtualTarget.CheckStatus()) {
+        LOG_WARN("Failed to create the virtual resolution target, drawing the world at the window size.");
+        useVirtualTarget = false;
+    }
+}
+
+void Renderer::PresentVirtualTarget() {
+    virtualTarget.Unbind();
+
+    glm::ivec2 virtualSize {virtualTargetColor.GetWidth(), virtualTargetColor.GetHeight()};
+    int integerScale {glm::min(_screenSize.x / virtualSize.x, _screenSize.y / virtualSize.y)};
+    //! Windows smaller than the virtual size can't be scaled by an integer, they are stretched instead
+    if (upscaleMode == UpscaleMode::Integer && integerScale >= 1) {
+        glm::ivec2 size {virtualSize * integerScale};
+        worldViewport = glm::ivec4{(_screenSize - size) / 2, size};
+    }
+    else {
+        worldViewport = glm::ivec4{0, 0, _screenSize.x, _screenSize.y};
+    }
+
+    float letterboxColor[] { 0.0f, 0.0f, 0.0f, 1.0f };
+    defaultFBO.ClearColor(letterboxColor);
+
+    //+ Sharp bilinear needs the texels interpolated, nearest for the rest
+    TextureParameter filter {upscaleMode == UpscaleMode::SharpBilinear ? TextureParameter::Linear : TextureParameter::Nearest};
+    if (virtualTargetColor.GetMagFiler() != filter)
+        virtualTargetColor.SetMinFilter(filter).SetMagFilter(filter);
+
+    auto& shader {AssetManager::GetShader(upscaleMode == UpscaleMode::SharpBilinear ? "upscaleSharpBilinear" : "upscale")};
+    shader->Use();
+    shader->SetInt("scene", 0);
+    shader->SetVec2("outputSize", glm::vec2{worldViewport.z, worldViewport.w});
+    virtualTargetColor.Use(0);
+
+    glViewport(worldViewport.x, worldViewport.y, worldViewport.z, worldViewport.w);
+    GLState::SetBlend(BlendMode::None);
+    auto& screenQuad {AssetManager::GetVertexArray("screenQuad")};
+    screenQuad->Use();
+    screenQuad->Draw();
+    glViewport(0, 0, _screenSize.x, _screenSize.y);
+}
+
 std::string Renderer::GetGraphicsInfo() {
     int textureUnits;
     glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
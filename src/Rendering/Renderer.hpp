@@ -10,12 +10,25 @@
 #include "Buffer.hpp"
 #include "Common.hpp"
 #include "FrameBuffer.hpp"
+#include "RenderBackend.hpp"
 #include "Sprite.hpp"
+#include "Texture.hpp"
 #include "UniformBuffer.hpp"
 
+// How the virtual resolution target is shown in the window
+enum class UpscaleMode : uint8_t {
+    // Fills the window, nearest filtering (texels may differ in size by one pixel)
+    Stretch,
+    // Largest integer scale that fits, the rest of the window is left black
+    Integer,
+    // Fills the window, texels are scaled by the largest integer that fits and only their edges are interpolated
+    SharpBilinear
+};
+
 class Renderer {
 public:
-    Renderer(class Engine* engine, glm::ivec2 screenSize, const std::string& windowTitle, bool fullscreen = false);
+    // A headless renderer has no window nor context, it loads the null GL backend instead (see NullGL)
+    Renderer(class Engine* engine, glm::ivec2 screenSize, const std::string& windowTitle, bool fullscreen = false, bool headless = false);
     ~Renderer();
 
     void LoadData();
@@ -27,6 +40,11 @@ public:
     // Utils
     std::string GetGraphicsInfo();
 
+    // Window area the world is shown in (x, y from the bottom-left corner, width, height)
+    const glm::ivec4& GetWorldViewport() const { return worldViewport; }
+
+    bool IsHeadless() const { return headless; }
+
     //! Temp
     SDL_Window* GetWindow() const { return window; }
 
@@ -41,19 +59,38 @@ public:
     //! Temp
     bool fullscreen;
 
+    // The world is drawn at the camera virtual size and then upscaled, the UI is drawn at the window size
+    bool useVirtualTarget   {true};
+    UpscaleMode upscaleMode {UpscaleMode::Integer};
+
+private:
+    bool CreateWindowAndContext(const std::string& windowTitle);
+    // Recreates the target when the virtual size changed
+    void UpdateVirtualTarget(const glm::ivec2& virtualSize);
+    // Draws the target into the default framebuffer following upscaleMode
+    void PresentVirtualTarget();
+
 private:
     glm::ivec2 _screenSize;
     // glm::ivec2 _virtualScreenSize;
 
-    SDL_Window* window;
-    SDL_GLContext context;
+    SDL_Window* window    {nullptr};
+    SDL_GLContext context {nullptr};
 
     class Engine* engine;
+    bool headless;
 
 #ifdef IMGUI
     struct ImGuiIO* io;
 #endif  // IMGUI
 
+    GLRenderBackend renderBackend;
+
+    //+ Virtual resolution target
+    Framebuffer virtualTarget;
+    Texture virtualTargetColor;
+    glm::ivec4 worldViewport {0};
+
     //! Debug
     Framebuffer defaultFBO;
 };
@@ -67,4 +104,5 @@ private:
 //* mat4 projection         - 64 (16N)     16
 //* mat4 view               - 64 (16N)     80
 //* mat4 projView           - 64 (16N)     144
-//*                         - 208          208
\ No newline at end of file
+//* float time              - 4  (N)       208
+//*                         - 224 (padded) 224
\ No newline at end of file
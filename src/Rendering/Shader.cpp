@@ -1,34 +1,71 @@
 #include "Shader.hpp"
 
 #include "Core/Log.hpp"
+#include "Core/Time.hpp"
+#include "GLState.hpp"
+#include "Utils/FileSystem.hpp"
 
+#include <cstring>
 #include <fstream>
 #include <glad/glad.h>
+#include <SDL.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <sstream>
 
-// TODO: Move this to a file system class
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <time.h>
-#ifndef WIN32
-#include <unistd.h>
-#endif
-#ifdef WIN32 
-#define stat _stat
+bool Shader::useBinaryCache {true};
+std::string Shader::cacheDirectory {"cache/shaders"};
+ShaderCacheStats Shader::cacheStats;
+
+// Binary layout of the cached files: header followed by the program binary returned by glGetProgramBinary
+struct ShaderCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t binarySize;
+    uint64_t sourceHash; // Source and driver strings
+    float compileTime;   // Time it took to compile and link the program from source, to report the time saved
+    uint32_t padding {0};
+};
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
 #endif
 
+// GL_KHR_parallel_shader_compile, queried at runtime since it's an optional extension
+typedef void (APIENTRY* MaxShaderCompilerThreadsFunc)(GLuint count);
+
+constexpr uint32_t shaderCacheMagic   {0x474F5250}; // "PROG"
+constexpr uint32_t shaderCacheVersion {1};
+
+// Binaries are only valid for the exact driver that created them
+static uint64_t GetDriverHash() {
+    static uint64_t driverHash {0};
+    if (driverHash == 0) {
+        uint64_t hash {FileSystem::fnvOffsetBasis};
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            const char* value {reinterpret_cast<const char*>(glGetString(name))};
+            hash = FileSystem::Hash(std::string{value ? value : ""}, hash);
+        }
+        driverHash = hash;
+    }
+    return driverHash;
+}
+
 Shader::Shader() {}
 
-Shader::Shader(const std::string& shaderPath) {
-    Load(shaderPath);
+Shader::Shader(const std::string& shaderPath, const std::vector<std::string>& defines) {
+    Load(shaderPath, defines);
 }
 
 
 // TODO: Make it so the shader is first destroyed before getting "other"s values. (Also with textures...)
 Shader::Shader(Shader&& other) 
-    : id{other.id}, path{std::move(other.path)}, lastModifiedTime{other.lastModifiedTime}, uniforms{std::move(other.uniforms)} {
+    : id{other.id}, path{std::move(other.path)}, lastModifiedTime{other.lastModifiedTime}, defines{std::move(other.defines)},
+      includedFiles{std::move(other.includedFiles)}, pendingLoad{std::move(other.pendingLoad)}, uniforms{std::move(other.uniforms)},
+      uniformSlots{std::move(other.uniformSlots)}, uniformHandles{std::move(other.uniformHandles)},
+      shadowValues{std::move(other.shadowValues)} {
     other.id = 0;
+    other.pendingLoad = PendingLoad{};
 }
 
 Shader::~Shader() {
@@ -41,67 +78,259 @@ Shader& Shader::operator=(Shader&& other) {
     other.id = 0;
     path = std::move(other.path);
     lastModifiedTime = other.lastModifiedTime;
+    defines = std::move(other.defines);
+    includedFiles = std::move(other.includedFiles);
+    pendingLoad = std::move(other.pendingLoad);
+    other.pendingLoad = PendingLoad{};
     uniforms = std::move(other.uniforms);
+    uniformSlots = std::move(other.uniformSlots);
+    uniformHandles = std::move(other.uniformHandles);
+    shadowValues = std::move(other.shadowValues);
     return *this;
 }
 
-bool Shader::Load(const std::string& shaderPath) {
+bool Shader::Load(const std::string& shaderPath, const std::vector<std::string>& defines) {
+    return BeginLoad(shaderPath, defines) && FinishLoad();
+}
+
+bool Shader::BeginLoad(const std::string& shaderPath, const std::vector<std::string>& defines) {
     Unload();
 
     path = shaderPath;
+    this->defines = defines;
+    includedFiles.clear();
     std::unordered_map<GLenum, std::string> shaderSources;
     std::ifstream file{shaderPath, std::ios::in, std::ios::binary};
-    if (file.is_open()) {
-        // Check last modified date
-        // TODO: Move to file system
-        struct stat result;
-        if (stat(path.c_str(), &result) == 0) {
-            lastModifiedTime = result.st_mtime;
-        }
+    if (!file.is_open()) {
+        LOG_WARN("Could not find/open file {}.", shaderPath);
+        return false;
+    }
+
+    // Check last modified date
+    lastModifiedTime = FileSystem::GetLastModifiedTime(path);
 
-        // Read file
-        std::stringstream stream;
-        stream << file.rdbuf();
-        file.close();
-        std::string source{stream.str()};
+    // Read file
+    std::stringstream stream;
+    stream << file.rdbuf();
+    file.close();
+    std::string source{stream.str()};
+
+    if (!GetShadersSource(source, shaderSources)) {
+        LOG_WARN("Failed to load shaders from file {}.", shaderPath)
+        return false;
+    }
 
-        if (!GetShadersSource(source, shaderSources)) {
-            LOG_WARN("Failed to load shaders from file {}.", shaderPath)
+    //+ Preprocess every stage, the cache is keyed by the final sources so includes and defines invalidate it too
+    uint64_t loadStart {Time::GetPerformanceCounter()};
+    uint64_t sourceHash {GetDriverHash()};
+    for (auto& [type, stageSource] : shaderSources) {
+        if (!PreprocessSource(stageSource)) {
+            LOG_WARN("Failed to preprocess the {} shader. ({})", GetOpenGLShaderName(type), shaderPath);
             return false;
         }
+        sourceHash = FileSystem::Hash(&type, sizeof(type), sourceHash);
+        sourceHash = FileSystem::Hash(stageSource, sourceHash);
+    }
 
-        std::vector<uint32_t> shaders(shaderSources.size());
-        size_t index{0};
-        for (auto& [type, source] : shaderSources) {
-            uint32_t shaderID;
-            if (!CompileShaderFromString(source, type, &shaderID))
-                return false;
-            shaders[index++] = shaderID;
+    std::string cachePath;
+    if (useBinaryCache) {
+        //! Each variant has its own file, otherwise they would keep overwriting each other's binary
+        uint64_t variantHash {FileSystem::Hash(shaderPath)};
+        for (const std::string& define : defines)
+            variantHash = FileSystem::Hash("|" + define, variantHash);
+        cachePath = fmt::format("{}/{}.bin", cacheDirectory, FileSystem::HashToString(variantHash));
+        if (LoadFromCache(cachePath, sourceHash)) {
+            cacheStats.cacheLoadTime += Time::GetMilisecondsSince(loadStart);
+            RetrieveUniformsData();
+            LOG_DEBUG("Shader [{}] created from cache ({}).", id, shaderPath);
+            return true;
         }
+    }
 
-        id = glCreateProgram();
-        for (int i{0}; i < shaders.size(); ++i)
-            glAttachShader(id, shaders[i]);
-        glLinkProgram(id);
+    //+ Issue the compilation and link, their status is checked by FinishLoad so they don't block here
+    IsParallelCompileSupported(); // Sets up the compiler threads the first time
+    pendingLoad.cachePath = std::move(cachePath);
+    pendingLoad.sourceHash = sourceHash;
+    pendingLoad.startCounter = loadStart;
+    for (auto& [type, stageSource] : shaderSources) {
+        uint32_t stage {glCreateShader(type)};
+        const char* code{stageSource.c_str()};
+        glShaderSource(stage, 1, &code, nullptr);
+        glCompileShader(stage);
+        pendingLoad.stages.push_back(stage);
+        pendingLoad.stageTypes.push_back(type);
+    }
 
-        if (!IsValidProgram()) {
-            id = 0;
+    pendingLoad.program = glCreateProgram();
+    for (uint32_t stage : pendingLoad.stages)
+        glAttachShader(pendingLoad.program, stage);
+    if (useBinaryCache)
+        glProgramParameteri(pendingLoad.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(pendingLoad.program);
+
+    return true;
+}
+
+bool Shader::FinishLoad() {
+    if (!IsLoadPending())
+        return id != 0;
+
+    for (size_t i {0}; i < pendingLoad.stages.size(); ++i) {
+        if (!IsCompiled(pendingLoad.stages[i])) {
+            LOG_WARN("Failed to compile shader of type: {}. ({})", GetOpenGLShaderName(pendingLoad.stageTypes[i]), path);
+            CancelPendingLoad();
             return false;
         }
+    }
 
-        for (auto shader : shaders) {
-            glDetachShader(id, shader);
-            glDeleteShader(shader);
-        }
-    } else {
-        LOG_WARN("Could not find/open file {}.", shaderPath);
+    id = pendingLoad.program;
+    pendingLoad.program = 0;
+    if (!IsValidProgram()) {
+        pendingLoad.program = id;
+        id = 0;
+        CancelPendingLoad();
         return false;
     }
 
+    for (uint32_t stage : pendingLoad.stages) {
+        glDetachShader(id, stage);
+        glDeleteShader(stage);
+    }
+
+    //! With parallel compilation this is the time since the compilation started, overlapped with the other shaders
+    float compileTime {Time::GetMilisecondsSince(pendingLoad.startCounter)};
+    ++cacheStats.compiledPrograms;
+    cacheStats.compileTime += compileTime;
+    if (useBinaryCache)
+        SaveToCache(pendingLoad.cachePath, pendingLoad.sourceHash, compileTime);
+    pendingLoad = PendingLoad{};
+
     RetrieveUniformsData();
 
-    LOG_DEBUG("Shader [{}] created ({}).", id, shaderPath);
+    LOG_DEBUG("Shader [{}] created ({}).", id, path);
+
+    return true;
+}
+
+bool Shader::IsLoadComplete() const {
+    if (!IsLoadPending())
+        return true;
+    if (!IsParallelCompileSupported())
+        return true;
+
+    int completed {GL_FALSE};
+    glGetProgramiv(pendingLoad.program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+void Shader::CancelPendingLoad() {
+    for (uint32_t stage : pendingLoad.stages)
+        glDeleteShader(stage);
+    if (pendingLoad.program != 0)
+        glDeleteProgram(pendingLoad.program);
+    pendingLoad = PendingLoad{};
+}
+
+bool Shader::IsParallelCompileSupported() {
+    static int supported {-1};
+    if (supported < 0) {
+        supported = SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile") == SDL_TRUE;
+        if (supported) {
+            auto maxShaderCompilerThreads {reinterpret_cast<MaxShaderCompilerThreadsFunc>(SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR"))};
+            if (maxShaderCompilerThreads)
+                maxShaderCompilerThreads(0xFFFFFFFF); // Implementation defined number of threads
+            else
+                supported = 0;
+        }
+    }
+    return supported == 1;
+}
+
+//+ Preprocessor ==============================================================
+
+bool Shader::PreprocessSource(std::string& source) {
+    //+ #version has to stay first, the defines go right after it
+    size_t versionEnd {source.find('\n')};
+    std::string preprocessed {source.substr(0, versionEnd)};
+    preprocessed += '\n';
+    for (const std::string& define : defines) {
+        size_t equals {define.find('=')};
+        if (equals == std::string::npos)
+            preprocessed += fmt::format("#define {}\n", define);
+        else
+            preprocessed += fmt::format("#define {} {}\n", define.substr(0, equals), define.substr(equals + 1));
+    }
+    preprocessed += "#line 2\n";
+
+    std::string body;
+    std::unordered_set<std::string> included;
+    if (versionEnd != std::string::npos &&
+        !ResolveIncludes(source.substr(versionEnd + 1), path, 2, 0, included, body))
+        return false;
 
+    source = std::move(preprocessed) + body;
+    return true;
+}
+
+bool Shader::ResolveIncludes(const std::string& source, const std::string& filePath, int firstLine, int depth,
+                             std::unordered_set<std::string>& included, std::string& outSource) {
+    constexpr int maxIncludeDepth {16};
+    if (depth > maxIncludeDepth) {
+        LOG_WARN("Shader includes nested more than {} levels, is there a cycle? ({})", maxIncludeDepth, filePath);
+        return false;
+    }
+
+    size_t directoryEnd {filePath.find_last_of("/\\")};
+    std::string directory {directoryEnd != std::string::npos ? filePath.substr(0, directoryEnd + 1) : ""};
+
+    const std::string token {"#include"};
+    int lineNumber {firstLine};
+    size_t lineStart {0};
+    while (lineStart < source.size()) {
+        size_t lineEnd {source.find('\n', lineStart)};
+        if (lineEnd == std::string::npos)
+            lineEnd = source.size();
+
+        size_t tokenStart {source.find_first_not_of(" \t", lineStart)};
+        if (tokenStart == std::string::npos || tokenStart >= lineEnd || source.compare(tokenStart, token.size(), token) != 0) {
+            outSource.append(source, lineStart, lineEnd - lineStart);
+            outSource += '\n';
+        }
+        else {
+            size_t nameStart {source.find('"', tokenStart + token.size())};
+            size_t nameEnd {nameStart < lineEnd ? source.find('"', nameStart + 1) : std::string::npos};
+            if (nameStart >= lineEnd || nameEnd >= lineEnd) {
+                LOG_WARN("Invalid #include at line {}, the file name must be between quotes. ({})", lineNumber, filePath);
+                return false;
+            }
+
+            std::string includePath {directory + source.substr(nameStart + 1, nameEnd - nameStart - 1)};
+            //! Included once per stage, so the same declarations don't end up defined twice
+            if (included.insert(includePath).second) {
+                std::ifstream file {includePath, std::ios::in | std::ios::binary};
+                if (!file.is_open()) {
+                    LOG_WARN("Could not find/open included file {} at line {}. ({})", includePath, lineNumber, filePath);
+                    return false;
+                }
+                std::stringstream stream;
+                stream << file.rdbuf();
+
+                bool isTracked {false};
+                for (const IncludedFile& includedFile : includedFiles)
+                    isTracked |= includedFile.path == includePath;
+                if (!isTracked)
+                    includedFiles.push_back(IncludedFile{includePath, FileSystem::GetLastModifiedTime(includePath)});
+
+                outSource += "#line 1\n";
+                if (!ResolveIncludes(stream.str(), includePath, 1, depth + 1, included, outSource))
+                    return false;
+            }
+            outSource += fmt::format("#line {}\n", lineNumber + 1);
+        }
+
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+    }
     return true;
 }
 
@@ -176,42 +405,50 @@ const char* Shader::GetOpenGLShaderName(uint32_t shaderType) {
 }
 
 void Shader::Unload() {
+    CancelPendingLoad();
     if (id != 0) {
         LOG_DEBUG("Shader [{}] deleted.", id);
+        GLState::OnProgramDeleted(id);
         glDeleteProgram(id);
         id = 0;
     }
 }
 
 void Shader::Use() const {
-    glUseProgram(id);
+    GLState::UseProgram(id);
 }
 
 void Shader::Unbind() const {
-    glUseProgram(0);
+    GLState::UseProgram(0);
 }
 
 bool Shader::HotReload() {
     if (id != 0 && !path.empty()) {
-        // https://stackoverflow.com/questions/40504281/c-how-to-check-the-last-modified-time-of-a-file
-        struct stat result;
-        if (stat(path.c_str(), &result) == 0) {
-            auto mod_time = result.st_mtime;
-            double diff {difftime(mod_time, lastModifiedTime)};
-            if (diff != 0.0) {
-                lastModifiedTime = mod_time;
-                Shader newShader;
-                if (newShader.Load(path)) {
-                    Unload();
-                    id = newShader.id;
-                    newShader.id = 0;
-                    uniforms = std::move(newShader.uniforms);
-                    return true;
-                }
+        bool changed {false};
+        time_t modTime {FileSystem::GetLastModifiedTime(path)};
+        if (modTime != 0 && difftime(modTime, lastModifiedTime) != 0.0) {
+            lastModifiedTime = modTime;
+            changed = true;
+        }
+        for (IncludedFile& includedFile : includedFiles) {
+            time_t includeModTime {FileSystem::GetLastModifiedTime(includedFile.path)};
+            if (includeModTime != 0 && difftime(includeModTime, includedFile.lastModifiedTime) != 0.0) {
+                includedFile.lastModifiedTime = includeModTime;
+                changed = true;
             }
         }
 
-        
+        if (changed) {
+            Shader newShader;
+            if (newShader.Load(path, defines)) {
+                Unload();
+                id = newShader.id;
+                newShader.id = 0;
+                includedFiles = std::move(newShader.includedFiles);
+                RetrieveUniformsData();
+                return true;
+            }
+        }
     }
     return false;
 }
@@ -221,252 +458,391 @@ bool Shader::HotReload() {
 
 const char* index_0_str { "[0]" };
 
+uint32_t Shader::uploadedUniforms {0};
+uint32_t Shader::skippedUniforms {0};
+uint32_t Shader::lastUploadedUniforms {0};
+uint32_t Shader::lastSkippedUniforms {0};
+
+void Shader::EndFrame() {
+    lastUploadedUniforms = uploadedUniforms;
+    lastSkippedUniforms = skippedUniforms;
+    uploadedUniforms = 0;
+    skippedUniforms = 0;
+}
+
+UniformHandle Shader::GetUniform(const std::string& name) const {
+    auto iter {uniformHandles.find(name)};
+    if (iter != uniformHandles.end())
+        return UniformHandle{iter->second};
+
+    UniformSlot& slot {uniformSlots.emplace_back()};
+    slot.name = name;
+    ResolveUniform(slot);
+
+    int index {static_cast<int>(uniformSlots.size()) - 1};
+    uniformHandles.emplace(name, index);
+    return UniformHandle{index};
+}
+
+UniformHandle Shader::GetUniform(const std::string& name, int index) const {
+    std::string elementName {fmt::format("{}[{}]", name, index)};
+    auto iter {uniformHandles.find(elementName)};
+    if (iter != uniformHandles.end())
+        return UniformHandle{iter->second};
+
+    UniformSlot& slot {uniformSlots.emplace_back()};
+    slot.name = name;
+    slot.arrayIndex = index;
+    ResolveUniform(slot);
+
+    int handleIndex {static_cast<int>(uniformSlots.size()) - 1};
+    uniformHandles.emplace(std::move(elementName), handleIndex);
+    return UniformHandle{handleIndex};
+}
+
+void Shader::ResolveUniform(UniformSlot& slot) const {
+    slot.location = -1;
+    slot.shadow = -1;
+    if (slot.arrayIndex < 0) {
+        //! Arrays are listed by their first element, so their name alone refers to it
+        auto iter {uniforms.find(slot.name)};
+        if (iter == uniforms.end())
+            iter = uniforms.find(slot.name + index_0_str);
+        if (iter != uniforms.end())
+            slot.location = iter->second.location;
+    }
+    else {
+        auto iter {uniforms.find(slot.name + index_0_str)};
+        if (iter != uniforms.end() && slot.arrayIndex < static_cast<int>(iter->second.count))
+            slot.location = iter->second.location + slot.arrayIndex;
+    }
+
+    if (slot.location < 0)
+        return;
+
+    for (size_t i {0}; i < shadowValues.size(); ++i) {
+        if (shadowValues[i].location == slot.location) {
+            slot.shadow = static_cast<int>(i);
+            return;
+        }
+    }
+    shadowValues.emplace_back().location = slot.location;
+    slot.shadow = static_cast<int>(shadowValues.size()) - 1;
+}
+
+int Shader::UpdateShadowValue(UniformHandle uniform, const void* value, uint32_t size) const {
+    if (!uniform.IsValid() || uniform.index >= static_cast<int>(uniformSlots.size()))
+        return -1;
+
+    const UniformSlot& slot {uniformSlots[uniform.index]};
+    if (slot.shadow < 0)
+        return -1;
+
+    ShadowValue& shadow {shadowValues[slot.shadow]};
+    if (shadow.size == size && std::memcmp(shadow.value, value, size) == 0) {
+        ++skippedUniforms;
+        return -1;
+    }
+
+    shadow.size = size;
+    std::memcpy(shadow.value, value, size);
+    ++uploadedUniforms;
+    return shadow.location;
+}
+
+void Shader::InvalidateShadowValues(int location, int count) const {
+    for (ShadowValue& shadow : shadowValues) {
+        if (shadow.location >= location && shadow.location < location + count)
+            shadow.size = 0;
+    }
+}
+
+void Shader::SetBool(UniformHandle uniform, bool value) const {
+    //! Stored as an int so it shares the shadow value with SetInt
+    int intValue {value};
+    int location {UpdateShadowValue(uniform, &intValue, sizeof(intValue))};
+    if (location >= 0)
+        glProgramUniform1i(id, location, intValue);
+}
+
 void Shader::SetBool(const std::string& name, bool value) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform1i(id, iter->second.location, value);
+    SetBool(GetUniform(name), value);
 }
 
 void Shader::SetBool(const std::string& name, int index, bool value) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform1i(id, iter->second.location + index, value);
+    SetBool(GetUniform(name, index), value);
 }
 
 void Shader::SetBoolv(const std::string& name, int count, int* value) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform1iv(id, iter->second.location, count, value);
+    }
+}
+
+void Shader::SetInt(UniformHandle uniform, int value) const {
+    int location {UpdateShadowValue(uniform, &value, sizeof(value))};
+    if (location >= 0)
+        glProgramUniform1i(id, location, value);
 }
 
 void Shader::SetInt(const std::string& name, int value) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform1i(id, iter->second.location, value);
+    SetInt(GetUniform(name), value);
 }
 
 void Shader::SetInt(const std::string& name, int index, int value) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform1i(id, iter->second.location + index, value);
+    SetInt(GetUniform(name, index), value);
 }
 
 void Shader::SetIntv(const std::string& name, int count, int* value) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform1iv(id, iter->second.location, count, value);
+    }
+}
+
+void Shader::SetUInt(UniformHandle uniform, uint32_t value) const {
+    int location {UpdateShadowValue(uniform, &value, sizeof(value))};
+    if (location >= 0)
+        glProgramUniform1ui(id, location, value);
 }
 
 void Shader::SetUInt(const std::string& name, uint32_t value) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform1ui(id, iter->second.location, value);
+    SetUInt(GetUniform(name), value);
 }
 
 void Shader::SetUInt(const std::string& name, int index, uint32_t value) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform1ui(id, iter->second.location + index, value);
+    SetUInt(GetUniform(name, index), value);
 }
 
 void Shader::SetUIntv(const std::string& name, int count, uint32_t* value) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform1uiv(id, iter->second.location, count, value);
+    }
+}
+
+void Shader::SetFloat(UniformHandle uniform, float value) const {
+    int location {UpdateShadowValue(uniform, &value, sizeof(value))};
+    if (location >= 0)
+        glProgramUniform1f(id, location, value);
 }
 
 void Shader::SetFloat(const std::string& name, float value) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform1f(id, iter->second.location, value);
+    SetFloat(GetUniform(name), value);
 }
 
 void Shader::SetFloat(const std::string& name, int index, float value) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform1f(id, iter->second.location + index, value);
+    SetFloat(GetUniform(name, index), value);
 }
 
 void Shader::SetFloatv(const std::string& name, int count, float* value) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform1fv(id, iter->second.location, count, value);
+    }
+}
+
+void Shader::SetIVec2(UniformHandle uniform, const glm::ivec2& vec) const {
+    int location {UpdateShadowValue(uniform, &vec, sizeof(vec))};
+    if (location >= 0)
+        glProgramUniform2iv(id, location, 1, glm::value_ptr(vec));
 }
 
 void Shader::SetIVec2(const std::string& name, const glm::ivec2& vec) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform2iv(id, iter->second.location, 1, glm::value_ptr(vec));
+    SetIVec2(GetUniform(name), vec);
 }
 
 void Shader::SetIVec2(const std::string& name, int index, const glm::ivec2& vec) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform2iv(id, iter->second.location + index, 1, glm::value_ptr(vec));
+    SetIVec2(GetUniform(name, index), vec);
 }
 
 void Shader::SetIVec2v(const std::string& name, int count, const glm::ivec2* vec) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform2iv(id, iter->second.location, count, glm::value_ptr(vec[0]));
+    }
+}
+
+void Shader::SetVec2(UniformHandle uniform, const glm::vec2& vec) const {
+    int location {UpdateShadowValue(uniform, &vec, sizeof(vec))};
+    if (location >= 0)
+        glProgramUniform2fv(id, location, 1, glm::value_ptr(vec));
 }
 
 void Shader::SetVec2(const std::string& name, const glm::vec2& vec) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform2fv(id, iter->second.location, 1, glm::value_ptr(vec));
+    SetVec2(GetUniform(name), vec);
 }
 
 void Shader::SetVec2(const std::string& name, int index, const glm::vec2& vec) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform2fv(id, iter->second.location + index, 1, glm::value_ptr(vec));
+    SetVec2(GetUniform(name, index), vec);
 }
 
 void Shader::SetVec2v(const std::string& name, int count, const glm::vec2* vec) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform2fv(id, iter->second.location, count, glm::value_ptr(vec[0]));
+    }
+}
+
+void Shader::SetIVec3(UniformHandle uniform, const glm::ivec3& vec) const {
+    int location {UpdateShadowValue(uniform, &vec, sizeof(vec))};
+    if (location >= 0)
+        glProgramUniform3iv(id, location, 1, glm::value_ptr(vec));
 }
 
 void Shader::SetIVec3(const std::string& name, const glm::ivec3& vec) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform3iv(id, iter->second.location, 1, glm::value_ptr(vec));
+    SetIVec3(GetUniform(name), vec);
 }
 
 void Shader::SetIVec3(const std::string& name, int index, const glm::ivec3& vec) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform3iv(id, iter->second.location + index, 1, glm::value_ptr(vec));
+    SetIVec3(GetUniform(name, index), vec);
 }
 
 void Shader::SetIVec3v(const std::string& name, int count, const glm::ivec3* vec) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform3iv(id, iter->second.location, count, glm::value_ptr(vec[0]));
+    }
+}
+
+void Shader::SetVec3(UniformHandle uniform, const glm::vec3& vec) const {
+    int location {UpdateShadowValue(uniform, &vec, sizeof(vec))};
+    if (location >= 0)
+        glProgramUniform3fv(id, location, 1, glm::value_ptr(vec));
 }
 
 void Shader::SetVec3(const std::string& name, const glm::vec3& vec) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform3fv(id, iter->second.location, 1, glm::value_ptr(vec));
+    SetVec3(GetUniform(name), vec);
 }
 
 void Shader::SetVec3(const std::string& name, int index, const glm::vec3& vec) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform3fv(id, iter->second.location + index, 1, glm::value_ptr(vec));
+    SetVec3(GetUniform(name, index), vec);
 }
 
 void Shader::SetVec3v(const std::string& name, int count, const glm::vec3* vec) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform3fv(id, iter->second.location, count, glm::value_ptr(vec[0]));
+    }
+}
+
+void Shader::SetIVec4(UniformHandle uniform, const glm::ivec4& vec) const {
+    int location {UpdateShadowValue(uniform, &vec, sizeof(vec))};
+    if (location >= 0)
+        glProgramUniform4iv(id, location, 1, glm::value_ptr(vec));
 }
 
 void Shader::SetIVec4(const std::string& name, const glm::ivec4& vec) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform4iv(id, iter->second.location, 1, glm::value_ptr(vec));
+    SetIVec4(GetUniform(name), vec);
 }
 
 void Shader::SetIVec4(const std::string& name, int index, const glm::ivec4& vec) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform4iv(id, iter->second.location + index, 1, glm::value_ptr(vec));
+    SetIVec4(GetUniform(name, index), vec);
 }
 
 void Shader::SetIVec4v(const std::string& name, int count, const glm::ivec4* vec) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform4iv(id, iter->second.location, count, glm::value_ptr(vec[0]));
+    }
+}
+
+void Shader::SetVec4(UniformHandle uniform, const glm::vec4& vec) const {
+    int location {UpdateShadowValue(uniform, &vec, sizeof(vec))};
+    if (location >= 0)
+        glProgramUniform4fv(id, location, 1, glm::value_ptr(vec));
 }
 
 void Shader::SetVec4(const std::string& name, const glm::vec4& vec) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniform4fv(id, iter->second.location, 1, glm::value_ptr(vec));
+    SetVec4(GetUniform(name), vec);
 }
 
 void Shader::SetVec4(const std::string& name, int index, const glm::vec4& vec) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniform4fv(id, iter->second.location + index, 1, glm::value_ptr(vec));
+    SetVec4(GetUniform(name, index), vec);
 }
 
 void Shader::SetVec4v(const std::string& name, int count, const glm::vec4* vec) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniform4fv(id, iter->second.location, count, glm::value_ptr(vec[0]));
+    }
+}
+
+void Shader::SetMatrix2(UniformHandle uniform, const glm::mat2& mat) const {
+    int location {UpdateShadowValue(uniform, &mat, sizeof(mat))};
+    if (location >= 0)
+        glProgramUniformMatrix2fv(id, location, 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 void Shader::SetMatrix2(const std::string& name, const glm::mat2& mat) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniformMatrix2fv(id, iter->second.location, 1, GL_FALSE, glm::value_ptr(mat));
+    SetMatrix2(GetUniform(name), mat);
 }
 
 void Shader::SetMatrix2(const std::string& name, int index, const glm::mat2& mat) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniformMatrix2fv(id, iter->second.location + index, 1, GL_FALSE, glm::value_ptr(mat));
+    SetMatrix2(GetUniform(name, index), mat);
 }
 
 void Shader::SetMatrix2v(const std::string& name, int count, const glm::mat2* mat) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniformMatrix2fv(id, iter->second.location, count, GL_FALSE, glm::value_ptr(mat[0]));
+    }
+}
+
+void Shader::SetMatrix3(UniformHandle uniform, const glm::mat3& mat) const {
+    int location {UpdateShadowValue(uniform, &mat, sizeof(mat))};
+    if (location >= 0)
+        glProgramUniformMatrix3fv(id, location, 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 void Shader::SetMatrix3(const std::string& name, const glm::mat3& mat) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniformMatrix3fv(id, iter->second.location, 1, GL_FALSE, glm::value_ptr(mat));
+    SetMatrix3(GetUniform(name), mat);
 }
 
 void Shader::SetMatrix3(const std::string& name, int index, const glm::mat3& mat) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniformMatrix3fv(id, iter->second.location + index, 1, GL_FALSE, glm::value_ptr(mat));
+    SetMatrix3(GetUniform(name, index), mat);
 }
 
 void Shader::SetMatrix3v(const std::string& name, int count, const glm::mat3* mat) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniformMatrix3fv(id, iter->second.location, count, GL_FALSE, glm::value_ptr(mat[0]));
+    }
+}
+
+void Shader::SetMatrix4(UniformHandle uniform, const glm::mat4& mat) const {
+    int location {UpdateShadowValue(uniform, &mat, sizeof(mat))};
+    if (location >= 0)
+        glProgramUniformMatrix4fv(id, location, 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 void Shader::SetMatrix4(const std::string& name, const glm::mat4& mat) const {
-    auto iter{uniforms.find(name)};
-    if (iter != uniforms.end())
-        glProgramUniformMatrix4fv(id, iter->second.location, 1, GL_FALSE, glm::value_ptr(mat));
+    SetMatrix4(GetUniform(name), mat);
 }
 
 void Shader::SetMatrix4(const std::string& name, int index, const glm::mat4& mat) const {
-    auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
-        glProgramUniformMatrix4fv(id, iter->second.location + index, 1, GL_FALSE, glm::value_ptr(mat));
+    SetMatrix4(GetUniform(name, index), mat);
 }
 
 void Shader::SetMatrix4v(const std::string& name, int count, const glm::mat4* mat) const {
     auto iter{uniforms.find(name + index_0_str)};
-    if (iter != uniforms.end())
+    if (iter != uniforms.end()) {
+        InvalidateShadowValues(iter->second.location, count);
         glProgramUniformMatrix4fv(id, iter->second.location, count, GL_FALSE, glm::value_ptr(mat[0]));
-}
-
-bool Shader::CompileShaderFromString(const std::string& shader, GLenum shaderType, uint32_t* outShader) {
-    *outShader = glCreateShader(shaderType);
-    const char* code{shader.c_str()};
-    glShaderSource(*outShader, 1, &code, nullptr);
-    glCompileShader(*outShader);
-
-    if (!IsCompiled(*outShader)) {
-        LOG_WARN("Failed to compile shader of type: {}. ({})", GetOpenGLShaderName(shaderType), path);
-        return false;
     }
-
-    return true;
 }
 
 bool Shader::IsCompiled(uint32_t shader) const {
@@ -493,7 +869,71 @@ bool Shader::IsValidProgram() const {
     return true;
 }
 
+//+ Binary Cache ==============================================================
+
+bool Shader::LoadFromCache(const std::string& cachePath, uint64_t sourceHash) {
+    MappedFile cache {cachePath};
+    if (!cache.IsOpen() || cache.GetSize() < sizeof(ShaderCacheHeader))
+        return false;
+
+    ShaderCacheHeader header;
+    std::memcpy(&header, cache.GetData(), sizeof(ShaderCacheHeader));
+
+    if (header.magic != shaderCacheMagic || header.version != shaderCacheVersion || header.sourceHash != sourceHash ||
+        header.binarySize != cache.GetSize() - sizeof(ShaderCacheHeader)) {
+        LOG_DEBUG("Shader cache {} is stale, compiling from source again.", cachePath);
+        return false;
+    }
+
+    id = glCreateProgram();
+    glProgramBinary(id, header.binaryFormat, cache.GetData() + sizeof(ShaderCacheHeader), header.binarySize);
+
+    //! The driver may still reject the binary (e.g. after an update that kept the version string)
+    int status;
+    glGetProgramiv(id, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        LOG_DEBUG("Shader cache {} was rejected by the driver, compiling from source again.", cachePath);
+        glDeleteProgram(id);
+        id = 0;
+        return false;
+    }
+
+    ++cacheStats.cachedPrograms;
+    cacheStats.cachedCompileTime += header.compileTime;
+    return true;
+}
+
+void Shader::SaveToCache(const std::string& cachePath, uint64_t sourceHash, float compileTime) const {
+    int binaryLength {0};
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0 || !FileSystem::CreateDirectories(cacheDirectory))
+        return;
+
+    std::vector<uint8_t> binary(binaryLength);
+    GLenum binaryFormat {GL_NONE};
+    glGetProgramBinary(id, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+    ShaderCacheHeader header;
+    header.magic = shaderCacheMagic;
+    header.version = shaderCacheVersion;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = static_cast<uint32_t>(binaryLength);
+    header.sourceHash = sourceHash;
+    header.compileTime = compileTime;
+
+    // A partially written file will fail the size check on the next load, so there is no need for a temporary file
+    std::ofstream file {cachePath, std::ios::out | std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+        LOG_WARN("Failed to open shader cache file {}.", cachePath);
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(ShaderCacheHeader));
+    file.write(reinterpret_cast<const char*>(binary.data()), binaryLength);
+}
+
 void Shader::RetrieveUniformsData() {
+    uniforms.clear();
     GLint uniformCount {0};
     glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniformCount);
 
@@ -524,4 +964,9 @@ void Shader::RetrieveUniformsData() {
     }
     
     // LOG_DEBUG("\nShader '{}' uniforms:\n" + debugUniforms, path);
+
+    //+ Handles are kept by name, so they keep working if the uniforms moved (e.g. after a hot reload)
+    shadowValues.clear();
+    for (UniformSlot& slot : uniformSlots)
+        ResolveUniform(slot);
 }
\ No newline at end of file
@@ -2,25 +2,57 @@
 #define __SHADER_H__
 
 #include <glm/glm.hpp>
+#include <stdint.h>
 #include <string>
+#include <time.h>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 struct UniformInfo {
     int location;
     uint32_t count;
 };
 
+struct ShaderCacheStats {
+    uint32_t cachedPrograms   {0}; // Programs created from the binary cache
+    uint32_t compiledPrograms {0}; // Programs compiled from source
+    float cacheLoadTime       {0.0f};
+    float compileTime         {0.0f};
+    float cachedCompileTime   {0.0f}; // Compile time stored in the cache files used, what loading them saved
+};
+
+// Uniform resolved once by name through Shader::GetUniform. Stays valid across hot reloads, where it's resolved again
+struct UniformHandle {
+    int index {-1};
+
+    bool IsValid() const { return index >= 0; }
+};
+
 class Shader {
 public:
     Shader();
-    explicit Shader(const std::string& shaderPath);
+    explicit Shader(const std::string& shaderPath, const std::vector<std::string>& defines = {});
     Shader(Shader&& other);    
     Shader& operator=(Shader&& other);
     ~Shader();
     Shader(const Shader&) = delete;    
     Shader& operator=(const Shader&) = delete;
 
-    bool Load(const std::string& shaderPath);
+    /**
+     * @brief Loads the shader file, every stage is preprocessed before compiling it:
+     * - #include "file" is replaced by the file contents (relative to the file that includes it, once per stage).
+     * - Each define is added as "#define NAME" (or "#define NAME VALUE" for "NAME=VALUE") after #version, so a single
+     *   file can have multiple variants.
+     */
+    bool Load(const std::string& shaderPath, const std::vector<std::string>& defines = {});
+    // Load split in two: BeginLoad issues the compilation and link without waiting for them, so several shaders can be
+    // compiled at once when the driver supports GL_KHR_parallel_shader_compile. FinishLoad waits and checks the results
+    bool BeginLoad(const std::string& shaderPath, const std::vector<std::string>& defines = {});
+    bool FinishLoad();
+    bool IsLoadPending() const { return pendingLoad.program != 0; }
+    // Whether FinishLoad can be called without blocking (always true without parallel compilation)
+    bool IsLoadComplete() const;
     bool GetShadersSource(const std::string& shader, std::unordered_map<uint32_t, std::string>& outSources);
     void Unload();
     void Use() const;
@@ -28,6 +60,33 @@ public:
     bool IsNull() const { return id == 0; }
 
     uint32_t GetID() const { return id; }
+    const std::string& GetPath() const { return path; }
+    const std::vector<std::string>& GetDefines() const { return defines; }
+    /**
+     * @brief Handle of a uniform (or of an element of a uniform array) to use with the handle setters, which skip the
+     * upload when the value didn't change since the last set. Handles of uniforms that don't exist are valid and ignored.
+     * 
+     * //! Registers the uniform the first time it's asked for, don't call it from several threads at once
+     */
+    UniformHandle GetUniform(const std::string& name) const;
+    UniformHandle GetUniform(const std::string& name, int index) const;
+
+    // Linked program binaries are stored in the cache directory so the next launch can skip compiling and linking.
+    // The cache is invalidated when the source or the driver (vendor, renderer or version) changes
+    static void EnableBinaryCache(bool enable) { useBinaryCache = enable; }
+    static bool IsBinaryCacheEnabled() { return useBinaryCache; }
+    static void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+    static const std::string& GetCacheDirectory() { return cacheDirectory; }
+    static const ShaderCacheStats& GetCacheStats() { return cacheStats; }
+
+    // Lets the driver use as many threads as it wants for the compilations started by BeginLoad
+    static bool IsParallelCompileSupported();
+
+    // Uniform uploads issued and skipped by every shader during the last finished frame
+    static uint32_t GetUploadedUniforms() { return lastUploadedUniforms; }
+    static uint32_t GetSkippedUniforms() { return lastSkippedUniforms; }
+    // Stores the uniform counters of the frame and starts counting a new one
+    static void EndFrame();
     
     //+ Utility:
     bool HotReload();
@@ -35,7 +94,22 @@ public:
     uint32_t GetOpenGLShaderFromString(const std::string& shaderType);
     const char* GetOpenGLShaderName(uint32_t shaderType);
 
-    // Utility uniform functions
+    // Uniform setters by handle
+    void SetBool(UniformHandle uniform, bool value) const;
+    void SetInt(UniformHandle uniform, int value) const;
+    void SetUInt(UniformHandle uniform, uint32_t value) const;
+    void SetFloat(UniformHandle uniform, float value) const;
+    void SetIVec2(UniformHandle uniform, const glm::ivec2& vec) const;
+    void SetVec2(UniformHandle uniform, const glm::vec2& vec) const;
+    void SetIVec3(UniformHandle uniform, const glm::ivec3& vec) const;
+    void SetVec3(UniformHandle uniform, const glm::vec3& vec) const;
+    void SetIVec4(UniformHandle uniform, const glm::ivec4& vec) const;
+    void SetVec4(UniformHandle uniform, const glm::vec4& vec) const;
+    void SetMatrix2(UniformHandle uniform, const glm::mat2& mat) const;
+    void SetMatrix3(UniformHandle uniform, const glm::mat3& mat) const;
+    void SetMatrix4(UniformHandle uniform, const glm::mat4& mat) const;
+
+    // Utility uniform functions (single values go through the handles, the array versions always upload)
     void SetBool(const std::string& name, bool value) const;
     void SetBool(const std::string& name, int index, bool value) const;
     void SetBoolv(const std::string& name, int count, int* value) const;
@@ -89,18 +163,74 @@ public:
     void SetMatrix4v(const std::string& name, int count, const glm::mat4* mat) const;
 
 private:
-    bool CompileShaderFromString(const std::string& shader, uint32_t shaderType, uint32_t* outShader);
+    struct UniformSlot {
+        std::string name;
+        int arrayIndex {-1}; // -1 if it isn't an element of an array
+        int location   {-1}; // -1 if the current program doesn't have the uniform
+        int shadow     {-1}; // Index of the shadow value of the location, shared by every slot resolved to it
+    };
+
+    // Last value uploaded to a location
+    struct ShadowValue {
+        int location  {-1};
+        uint32_t size {0};  // 0 when it's unknown
+        alignas(16) uint8_t value[sizeof(glm::mat4)];
+    };
+
+    struct IncludedFile {
+        std::string path;
+        time_t lastModifiedTime;
+    };
+
+    // Compilation started by BeginLoad, waiting for FinishLoad
+    struct PendingLoad {
+        uint32_t program {0};
+        std::vector<uint32_t> stages;
+        std::vector<uint32_t> stageTypes;
+        std::string cachePath;
+        uint64_t sourceHash   {0};
+        uint64_t startCounter {0};
+    };
+
+    bool PreprocessSource(std::string& source);
+    bool ResolveIncludes(const std::string& source, const std::string& filePath, int firstLine, int depth,
+                         std::unordered_set<std::string>& included, std::string& outSource);
+    void CancelPendingLoad();
     bool IsCompiled(uint32_t shader) const;
     bool IsValidProgram() const;
+    bool LoadFromCache(const std::string& cachePath, uint64_t sourceHash);
+    void SaveToCache(const std::string& cachePath, uint64_t sourceHash, float compileTime) const;
 
     void RetrieveUniformsData();
+    void ResolveUniform(UniformSlot& slot) const;
+    // Location to upload to, or -1 if the uniform doesn't exist or already has that value
+    int UpdateShadowValue(UniformHandle uniform, const void* value, uint32_t size) const;
+    // Forgets the shadow values of the locations written without going through the handles
+    void InvalidateShadowValues(int location, int count) const;
 
 private:
     uint32_t id {0};
     std::string path;
     time_t lastModifiedTime;
+    std::vector<std::string> defines;
+    std::vector<IncludedFile> includedFiles;
+    PendingLoad pendingLoad;
 
     std::unordered_map<std::string, UniformInfo> uniforms;
+    //! Registered lazily by the const GetUniform
+    mutable std::vector<UniformSlot> uniformSlots;
+    mutable std::unordered_map<std::string, int> uniformHandles;
+    //! Keyed by location, so "name[0]" and (name, 0) don't keep separate values of the same uniform
+    mutable std::vector<ShadowValue> shadowValues;
+
+    static uint32_t uploadedUniforms;
+    static uint32_t skippedUniforms;
+    static uint32_t lastUploadedUniforms;
+    static uint32_t lastSkippedUniforms;
+
+    static bool useBinaryCache;
+    static std::string cacheDirectory;
+    static ShaderCacheStats cacheStats;
 };
 
 #endif  // __SHADER_H__
\ No newline at end of file
@@ -1,18 +1,43 @@
 #include "Sprite.hpp"
 
 #include "Texture.hpp"
+#include "TextureAtlas.hpp"
 
 Sprite::Sprite(Ref<Texture> texture)
-    : texture{texture}, size{glm::ivec2{texture->GetWidth(), texture->GetHeight()}} {
-    spriteMinUV = glm::vec2 { 0.0f };
-    spriteMaxUV = glm::vec2 { 1.0f };
+    : sourceTexture{texture}, size{glm::ivec2{texture->GetWidth(), texture->GetHeight()}} {
+    sourceMinUV = glm::vec2 { 0.0f };
+    sourceMaxUV = glm::vec2 { 1.0f };
+    ResolveTexture();
 }
 
 Sprite::Sprite(Ref<Texture> spriteSheet, const glm::ivec2& startCoords, const glm::ivec2& size)
-    : texture{spriteSheet}, size{size} {
+    : sourceTexture{spriteSheet}, size{size} {
     glm::ivec2 endCoords {startCoords + size};
-    spriteMinUV = glm::vec2 {(float)startCoords.x / (float)texture->GetWidth(), 
-                             (float)startCoords.y / (float)texture->GetHeight() };
-    spriteMaxUV = glm::vec2 {(float)endCoords.x / (float)texture->GetWidth(), 
-                             (float)endCoords.y / (float)texture->GetHeight() };
+    sourceMinUV = glm::vec2 {(float)startCoords.x / (float)sourceTexture->GetWidth(), 
+                             (float)startCoords.y / (float)sourceTexture->GetHeight() };
+    sourceMaxUV = glm::vec2 {(float)endCoords.x / (float)sourceTexture->GetWidth(), 
+                             (float)endCoords.y / (float)sourceTexture->GetHeight() };
+    ResolveTexture();
+}
+
+void Sprite::SetTexture(Ref<Texture> texture) {
+    sourceTexture = texture;
+    ResolveTexture();
+}
+
+void Sprite::ResolveTexture() {
+    instanceRectID = -1;
+    const AtlasEntry* entry {TextureAtlas::Find(sourceTexture)};
+    if (entry) {
+        texture = entry->page;
+        atlasLayer = entry->pageIndex;
+        spriteMinUV = entry->uvOffset + sourceMinUV * entry->uvScale;
+        spriteMaxUV = entry->uvOffset + sourceMaxUV * entry->uvScale;
+    }
+    else {
+        texture = sourceTexture;
+        atlasLayer = -1;
+        spriteMinUV = sourceMinUV;
+        spriteMaxUV = sourceMaxUV;
+    }
 }
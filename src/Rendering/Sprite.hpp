@@ -25,24 +25,41 @@ public:
      */
     Sprite(Ref<Texture> spriteSheet, const glm::ivec2& startCoords, const glm::ivec2& size);
 
+    // If the source texture is packed in the TextureAtlas, the atlas page is returned
     const Ref<Texture> GetTexture() const { return texture; }
+    const Ref<Texture> GetSourceTexture() const { return sourceTexture; }
     const glm::ivec2& GetSize() const { return size; }
     const glm::vec2& GetMinUV() const { return spriteMinUV; }
     const glm::vec2& GetMaxUV() const { return spriteMaxUV; }
+    // Layer inside TextureAtlas::GetPageArray(), -1 if the texture is not packed
+    int GetAtlasLayer() const { return atlasLayer; }
+    // Index of the uv rect in the SpriteInstanceBatch table, -1 until the sprite is drawn instanced
+    int GetInstanceRectID() const { return instanceRectID; }
+    void SetInstanceRectID(int id) { instanceRectID = id; }
 
-    void SetTexture(Ref<Texture> texture) { this->texture = texture; }
+    void SetTexture(Ref<Texture> texture);
 
 public:
     bool flipX{false};
     bool flipY{false};
 
 private:
+    // Remaps the sprite to its atlas page if the source texture was packed
+    void ResolveTexture();
+
+private:
+    Ref<Texture> sourceTexture;
     Ref<Texture> texture;
     glm::ivec2 size;
+    // UVs inside the source texture
+    glm::vec2 sourceMinUV;
+    glm::vec2 sourceMaxUV;
     // Bottom-Left UV coordinate
     glm::vec2 spriteMinUV;
     // Top-Right UV coordinate
     glm::vec2 spriteMaxUV;
+    int atlasLayer {-1};
+    int instanceRectID {-1};
 };
 
 #endif // __SPRITE_H__
\ No newline at end of file
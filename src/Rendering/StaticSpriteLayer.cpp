@@ -0,0 +1,253 @@
+#include "StaticSpriteLayer.hpp"
+
+#include "Batch.hpp"
+#include "Core/AssetManager.hpp"
+#include "Core/Components.hpp"
+#include "RenderStats.hpp"
+#include "Shader.hpp"
+#include "Sprite.hpp"
+#include "Texture.hpp"
+#include "TextureArray.hpp"
+#include "TextureAtlas.hpp"
+#include "VertexArray.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+
+StaticSpriteLayer::StaticSpriteLayer(entt::registry& registry) : registry{registry} {
+    registry.on_construct<StaticSprite>().connect<&StaticSpriteLayer::OnConstruct>(*this);
+    registry.on_update<StaticSprite>().connect<&StaticSpriteLayer::OnUpdate>(*this);
+    registry.on_destroy<StaticSprite>().connect<&StaticSpriteLayer::OnDestroy>(*this);
+    registry.on_construct<SpriteRenderer>().connect<&StaticSpriteLayer::OnSpriteChanged>(*this);
+    registry.on_update<SpriteRenderer>().connect<&StaticSpriteLayer::OnSpriteChanged>(*this);
+    registry.on_destroy<SpriteRenderer>().connect<&StaticSpriteLayer::OnSpriteChanged>(*this);
+}
+
+StaticSpriteLayer::~StaticSpriteLayer() {
+    registry.on_construct<StaticSprite>().disconnect<&StaticSpriteLayer::OnConstruct>(*this);
+    registry.on_update<StaticSprite>().disconnect<&StaticSpriteLayer::OnUpdate>(*this);
+    registry.on_destroy<StaticSprite>().disconnect<&StaticSpriteLayer::OnDestroy>(*this);
+    registry.on_construct<SpriteRenderer>().disconnect<&StaticSpriteLayer::OnSpriteChanged>(*this);
+    registry.on_update<SpriteRenderer>().disconnect<&StaticSpriteLayer::OnSpriteChanged>(*this);
+    registry.on_destroy<SpriteRenderer>().disconnect<&StaticSpriteLayer::OnSpriteChanged>(*this);
+}
+
+void StaticSpriteLayer::Prepare(const Bounds2D& viewBounds) {
+    //+ Rebuild dirty chunks (a rebuild may move sprites that changed position into other chunks, so repeat until none is dirty)
+    rebuiltChunks = 0;
+    std::vector<uint64_t> dirtyChunks;
+    do {
+        dirtyChunks.clear();
+        for (auto& [key, chunk] : chunks) {
+            if (chunk.isDirty)
+                dirtyChunks.push_back(key);
+        }
+
+        for (uint64_t key : dirtyChunks) {
+            Rebuild(key);
+            ++rebuiltChunks;
+        }
+    } while (!dirtyChunks.empty());
+
+    //+ Gather the ranges of the visible chunks and sort them like the dynamic sprites, so the render order holds across chunks
+    visibleRanges.clear();
+    drawnChunks = 0;
+    for (auto& [key, chunk] : chunks) {
+        if (!chunk.mesh || !chunk.bounds.Overlaps(viewBounds))
+            continue;
+
+        ++drawnChunks;
+        for (auto& range : chunk.ranges)
+            visibleRanges.push_back(VisibleRange{&chunk, &range});
+    }
+    // Stable, so ranges with the same key keep the chunk order and the order inside of each chunk
+    std::stable_sort(visibleRanges.begin(), visibleRanges.end(), [](const VisibleRange& a, const VisibleRange& b) {
+        return a.range->sortKey < b.range->sortKey;
+    });
+
+    nextRange = 0;
+}
+
+uint64_t StaticSpriteLayer::GetNextSortKey() const {
+    return nextRange < visibleRanges.size() ? visibleRanges[nextRange].range->sortKey : UINT64_MAX;
+}
+
+void StaticSpriteLayer::DrawUpTo(uint64_t maxSortKey) {
+    if (GetNextSortKey() > maxSortKey)
+        return;
+
+    //! The dynamic sprites drawn in between bind their own shader and vertex array, so nothing is kept across calls
+    auto spriteShader {AssetManager::GetShader("sprite")};
+    auto spriteArrayShader {AssetManager::GetShader("spriteArray")};
+    const Shader* activeShader {nullptr};
+    const Chunk* activeChunk {nullptr};
+    for (; nextRange < visibleRanges.size() && visibleRanges[nextRange].range->sortKey <= maxSortKey; ++nextRange) {
+        const VisibleRange& visible {visibleRanges[nextRange]};
+        if (visible.chunk != activeChunk) {
+            visible.chunk->mesh->Use();
+            activeChunk = visible.chunk;
+        }
+
+        const DrawRange& range {*visible.range};
+        const Shader* shader {range.texture ? spriteShader.get() : spriteArrayShader.get()};
+        if (shader != activeShader) {
+            shader->Use();
+            activeShader = shader;
+        }
+
+        if (range.texture)
+            range.texture->Use(0);
+        else
+            TextureAtlas::GetPageArray()->Use(0);
+
+        RenderStats::AddDrawCalls();
+        RenderStats::AddSpriteQuads(range.quadCount);
+        glDrawElements(GL_TRIANGLES, range.quadCount * 6, GL_UNSIGNED_INT,
+                       reinterpret_cast<const void*>(static_cast<uintptr_t>(range.firstQuad) * 6 * sizeof(uint32_t)));
+    }
+}
+
+void StaticSpriteLayer::OnConstruct(entt::registry& registry, entt::entity entity) {
+    auto& staticSprite {registry.get<StaticSprite>(entity)};
+    auto* transform {registry.try_get<Transform>(entity)};
+    staticSprite.chunk = transform ? GetChunkCoords(transform->GetPosition()) : glm::ivec2{0, 0};
+    AddToChunk(entity, staticSprite.chunk);
+}
+
+void StaticSpriteLayer::OnUpdate(entt::registry& registry, entt::entity entity) {
+    auto chunk {chunks.find(GetChunkKey(registry.get<StaticSprite>(entity).chunk))};
+    if (chunk != chunks.end())
+        chunk->second.isDirty = true;
+}
+
+void StaticSpriteLayer::OnDestroy(entt::registry& registry, entt::entity entity) {
+    RemoveFromChunk(entity, registry.get<StaticSprite>(entity).chunk);
+}
+
+void StaticSpriteLayer::OnSpriteChanged(entt::registry& registry, entt::entity entity) {
+    if (registry.all_of<StaticSprite>(entity))
+        OnUpdate(registry, entity);
+}
+
+void StaticSpriteLayer::AddToChunk(entt::entity entity, const glm::ivec2& chunk) {
+    Chunk& target {chunks[GetChunkKey(chunk)]};
+    target.members.push_back(entity);
+    target.isDirty = true;
+    ++spriteCount;
+}
+
+void StaticSpriteLayer::RemoveFromChunk(entt::entity entity, const glm::ivec2& chunk) {
+    auto target {chunks.find(GetChunkKey(chunk))};
+    if (target == chunks.end())
+        return;
+
+    auto& members {target->second.members};
+    auto member {std::find(members.begin(), members.end(), entity)};
+    if (member != members.end()) {
+        *member = members.back();
+        members.pop_back();
+        target->second.isDirty = true;
+        --spriteCount;
+    }
+}
+
+void StaticSpriteLayer::Rebuild(uint64_t key) {
+    Chunk& chunk {chunks[key]};
+    chunk.isDirty = false;
+
+    struct Member {
+        const Transform* transform;
+        const SpriteRenderer* spriteRenderer;
+    };
+    std::vector<Member> sprites;
+    sprites.reserve(chunk.members.size());
+    std::vector<std::pair<entt::entity, glm::ivec2>> moved;
+
+    for (entt::entity entity : chunk.members) {
+        auto* transform {registry.try_get<Transform>(entity)};
+        auto* spriteRenderer {registry.try_get<SpriteRenderer>(entity)};
+        auto* staticSprite {registry.try_get<StaticSprite>(entity)};
+        if (!transform || !spriteRenderer || !staticSprite)
+            continue;
+
+        glm::ivec2 coords {GetChunkCoords(transform->GetPosition())};
+        if (coords != staticSprite->chunk) {
+            moved.emplace_back(entity, coords);
+            continue;
+        }
+        sprites.push_back(Member{transform, spriteRenderer});
+    }
+    for (auto& [entity, coords] : moved) {
+        chunk.members.erase(std::find(chunk.members.begin(), chunk.members.end(), entity));
+        --spriteCount;
+    }
+
+    // The sort keys are refreshed by the scene before rendering
+    std::stable_sort(sprites.begin(), sprites.end(), [](const Member& a, const Member& b) {
+        return a.spriteRenderer->GetSortKey() < b.spriteRenderer->GetSortKey();
+    });
+
+    std::vector<SpriteVertex> vertices(sprites.size() * 4);
+    std::vector<uint32_t> indices(sprites.size() * 6);
+    chunk.ranges.clear();
+    chunk.bounds = Bounds2D{vec2::inf, vec2::ninf};
+    for (size_t i {0}; i < sprites.size(); ++i) {
+        const Sprite& sprite {*sprites[i].spriteRenderer->sprite};
+        bool isPacked {TextureAtlas::GetPageArray() && sprite.GetAtlasLayer() >= 0};
+        Ref<Texture> texture {isPacked ? nullptr : sprite.GetTexture()};
+        uint64_t sortKey {sprites[i].spriteRenderer->GetSortKey()};
+        // The render order is in the upper 32 bits of the key, ranges never mix orders so they can be sorted with other chunks
+        if (chunk.ranges.empty() || chunk.ranges.back().texture != texture || (chunk.ranges.back().sortKey >> 32) != (sortKey >> 32))
+            chunk.ranges.push_back(DrawRange{texture, static_cast<uint32_t>(i), 0, sortKey});
+        ++chunk.ranges.back().quadCount;
+
+        WriteSpriteQuad(&vertices[i * 4], *sprites[i].transform, *sprites[i].spriteRenderer, isPacked ? sprite.GetAtlasLayer() : 0);
+        for (size_t v {i * 4}; v < i * 4 + 4; ++v) {
+            glm::vec2 position {vertices[v].position.x, vertices[v].position.y};
+            chunk.bounds.min = glm::min(chunk.bounds.min, position);
+            chunk.bounds.max = glm::max(chunk.bounds.max, position);
+        }
+
+        uint32_t vertex {static_cast<uint32_t>(i * 4)};
+        uint32_t* quadIndices {&indices[i * 6]};
+        quadIndices[0] = vertex + 0;
+        quadIndices[1] = vertex + 1;
+        quadIndices[2] = vertex + 2;
+        quadIndices[3] = vertex + 2;
+        quadIndices[4] = vertex + 1;
+        quadIndices[5] = vertex + 3;
+    }
+
+    if (sprites.empty()) {
+        chunk.mesh.reset();
+    }
+    else {
+        // Same layout as SpriteBatch
+        VertexLayout layout{
+            VertexElement{4, DataType::Float},      // Position
+            VertexElement{2, DataType::Float},      // UV
+            VertexElement{4, DataType::Float},      // Color
+            VertexElement{1, DataType::Int, true}   // texIndex
+        };
+        chunk.mesh = MakeOwned<VertexArray>(vertices.data(), static_cast<uint32_t>(vertices.size()), layout, BufferUsage::Static,
+                                            indices.data(), static_cast<uint32_t>(indices.size()), BufferUsage::Static);
+    }
+
+    if (chunk.members.empty())
+        chunks.erase(key);
+
+    //+ Move the sprites that changed position to their new chunk (chunk can't be used after this since it may have been erased)
+    for (auto& [entity, coords] : moved) {
+        registry.get<StaticSprite>(entity).chunk = coords;
+        AddToChunk(entity, coords);
+    }
+}
+
+glm::ivec2 StaticSpriteLayer::GetChunkCoords(const glm::vec3& position) {
+    return glm::ivec2{static_cast<int>(std::floor(position.x / chunkSize)), static_cast<int>(std::floor(position.y / chunkSize))};
+}
+
+uint64_t StaticSpriteLayer::GetChunkKey(const glm::ivec2& chunk) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(chunk.x)) << 32) | static_cast<uint32_t>(chunk.y);
+}
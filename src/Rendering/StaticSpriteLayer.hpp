@@ -0,0 +1,94 @@
+#ifndef __STATICSPRITELAYER_H__
+#define __STATICSPRITELAYER_H__
+
+#include "Common.hpp"
+#include "Utils/MathExtras.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <glm/vec2.hpp>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+class Texture;
+class VertexArray;
+
+/**
+ * @brief Retained GPU buffers for the sprites marked with StaticSprite, partitioned in square chunks of chunkSize world units.
+ * A chunk is only rebuilt when one of its sprites is added, removed or changed, so static sprites cost nothing per frame
+ * besides one draw per texture and render order run of each visible chunk.
+ */
+class StaticSpriteLayer {
+public:
+    static constexpr float chunkSize {256.0f};
+
+    StaticSpriteLayer(entt::registry& registry);
+    ~StaticSpriteLayer();
+    StaticSpriteLayer(const StaticSpriteLayer&) = delete;
+    StaticSpriteLayer& operator=(const StaticSpriteLayer&) = delete;
+
+    // Rebuilds the dirty chunks and gathers the ranges of the ones overlapping viewBounds. Transforms must be up to date.
+    void Prepare(const Bounds2D& viewBounds);
+    // Sort key of the next gathered range that wasn't drawn yet, UINT64_MAX if every range was drawn
+    uint64_t GetNextSortKey() const;
+    /**
+     * @brief Draws the gathered ranges up to maxSortKey (inclusive), the scene calls it between the dynamic sprite 
+     * batches so both are drawn in a single sequence ordered by sort key
+     */
+    void DrawUpTo(uint64_t maxSortKey);
+
+    uint32_t GetChunkCount() const { return static_cast<uint32_t>(chunks.size()); }
+    uint32_t GetSpriteCount() const { return spriteCount; }
+    // Chunks rebuilt during the last Prepare
+    uint32_t GetRebuiltChunks() const { return rebuiltChunks; }
+    // Chunks inside the view during the last Prepare
+    uint32_t GetDrawnChunks() const { return drawnChunks; }
+
+private:
+    // Consecutive quads sharing the same texture and render order, a null texture means the atlas page array
+    struct DrawRange {
+        Ref<Texture> texture;
+        uint32_t firstQuad;
+        uint32_t quadCount;
+        uint64_t sortKey; // Sort key of the first quad
+    };
+
+    struct Chunk;
+    struct VisibleRange {
+        const Chunk* chunk;
+        const DrawRange* range;
+    };
+
+    struct Chunk {
+        std::vector<entt::entity> members;
+        Owned<VertexArray> mesh;
+        std::vector<DrawRange> ranges;
+        // Bounds of the built quads, they may go past the chunk area
+        Bounds2D bounds;
+        bool isDirty {true};
+    };
+
+    void OnConstruct(entt::registry& registry, entt::entity entity);
+    void OnUpdate(entt::registry& registry, entt::entity entity);
+    void OnDestroy(entt::registry& registry, entt::entity entity);
+    void OnSpriteChanged(entt::registry& registry, entt::entity entity);
+
+    void AddToChunk(entt::entity entity, const glm::ivec2& chunk);
+    void RemoveFromChunk(entt::entity entity, const glm::ivec2& chunk);
+    void Rebuild(uint64_t key);
+
+    static glm::ivec2 GetChunkCoords(const glm::vec3& position);
+    static uint64_t GetChunkKey(const glm::ivec2& chunk);
+
+private:
+    entt::registry& registry;
+    // Ordered so chunks with ranges of the same sort key are always drawn in the same order
+    std::map<uint64_t, Chunk> chunks;
+    std::vector<VisibleRange> visibleRanges;
+    size_t nextRange {0};
+    uint32_t spriteCount   {0};
+    uint32_t rebuiltChunks {0};
+    uint32_t drawnChunks   {0};
+};
+
+#endif // __STATICSPRITELAYER_H__
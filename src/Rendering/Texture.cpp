@@ -1,11 +1,44 @@
 #include "Texture.hpp"
 
 #include "Core/Log.hpp"
+#include "GLState.hpp"
+#include "RenderStats.hpp"
+#include "Utils/FileSystem.hpp"
 
+#include <cstring>
+#include <fmt/core.h>
+#include <fstream>
 #include <stb_image.h>
 
 #define OGL_DSA
 
+bool Texture::useDiskCache {true};
+std::string Texture::cacheDirectory {"cache/textures"};
+
+// Binary layout of the cached files: header followed by the tightly packed pixels, ready to upload
+struct TextureCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    int32_t width;
+    int32_t height;
+    uint32_t internalFormat;
+    uint32_t imageFormat;
+    uint32_t wrapS;
+    uint32_t wrapT;
+    uint32_t minFilter;
+    uint32_t magFilter;
+    uint32_t padding {0};
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t pixelsSize;
+};
+
+constexpr uint32_t textureCacheMagic       {0x58455454}; // "TTEX"
+constexpr uint32_t textureCacheVersion     {1};
+constexpr uint32_t cacheFlagFlipY          {1 << 0};
+constexpr uint32_t cacheFlagPremultiplied  {1 << 1};
+
 uint32_t ToOpenGL(TextureTarget target) {
     switch (target)
     { 
@@ -156,18 +189,37 @@ uint32_t ToOpenGL(TextureFormat format) {
         case TextureFormat::RGBA32I          : return GL_RGBA32I;
         case TextureFormat::RGBA32UI         : return GL_RGBA32UI;
         case TextureFormat::Depth24_Stencil8 : return GL_DEPTH24_STENCIL8;
+
+        case TextureFormat::RED_INTEGER      : return GL_RED_INTEGER;
         default                              : return GL_INVALID_ENUM;
     }
 }
 
+uint32_t GetChannelCount(TextureFormat imageFormat) {
+    switch (imageFormat) {
+        case TextureFormat::RED              : return 1;
+        case TextureFormat::RED_INTEGER      : return 1;
+        case TextureFormat::DepthComponent   : return 1;
+        case TextureFormat::StencilIndex     : return 1;
+        case TextureFormat::RG               : return 2;
+        case TextureFormat::RGB              : return 3;
+        case TextureFormat::BGR              : return 3;
+        case TextureFormat::RGBA             : return 4;
+        case TextureFormat::BGRA             : return 4;
+        // Packed in a single UInt24_8
+        case TextureFormat::Depth_Stencil    : return 1;
+        default                              : return 0;
+    }
+}
+
 Texture::Texture()
     : internalFormat{TextureFormat::RGB}, imageFormat{TextureFormat::RGB8}, wrapS{TextureParameter::Repeat}, wrapT{TextureParameter::Repeat}, 
       minFilter{TextureParameter::Linear}, magFiler{TextureParameter::Linear}, hasMipmap{false} {}
 
-Texture::Texture(const std::string& fileName, bool flipYAxis)
+Texture::Texture(const std::string& fileName, bool flipYAxis, bool premultiplyAlpha)
     : width{0}, height{0}, internalFormat{TextureFormat::RGB8}, imageFormat{TextureFormat::RGB}, wrapS{TextureParameter::Repeat}, wrapT{TextureParameter::Repeat}, 
       minFilter{TextureParameter::Linear}, magFiler{TextureParameter::Linear}, hasMipmap{false} {
-    if (!Load(fileName, flipYAxis)) {
+    if (!Load(fileName, flipYAxis, premultiplyAlpha)) {
         LOG_WARN("Failed to load texture: {}.", fileName);
     }
 }
@@ -199,13 +251,32 @@ Texture& Texture::operator=(Texture&& other) {
     return *this;
 }
 
-bool Texture::Load(const std::string& fileName, bool flipYAxis) {
+bool Texture::Load(const std::string& fileName, bool flipYAxis, bool premultiplyAlpha) {
     Unload();
 
+    MappedFile source {fileName};
+    if (!source.IsOpen()) {
+        LOG_WARN("Failed to load image: {}.", fileName);
+        return false;
+    }
+
+    uint32_t flags {(flipYAxis ? cacheFlagFlipY : 0u) | (premultiplyAlpha ? cacheFlagPremultiplied : 0u)};
+    uint64_t sourceHash {FileSystem::Hash(source.GetData(), source.GetSize())};
+    std::string cachePath;
+
+    if (useDiskCache) {
+        cachePath = fmt::format("{}/{}.tex", cacheDirectory, FileSystem::HashToString(FileSystem::Hash(&flags, sizeof(flags), FileSystem::Hash(fileName))));
+        if (LoadFromCache(cachePath, sourceHash, source.GetSize(), flags)) {
+            path = fileName;
+            LOG_DEBUG("Texture [{}] ({}) created from cache.", id, fileName);
+            return true;
+        }
+    }
+
     stbi_set_flip_vertically_on_load(flipYAxis);
 
     int channels;
-    unsigned char* data{stbi_load(fileName.c_str(), &width, &height, &channels, 0)};
+    unsigned char* data{stbi_load_from_memory(source.GetData(), static_cast<int>(source.GetSize()), &width, &height, &channels, 0)};
 
     if (!data) {
         LOG_WARN("Failed to load image: {}.", fileName);
@@ -230,8 +301,31 @@ bool Texture::Load(const std::string& fileName, bool flipYAxis) {
     else if (channels == 4) {
         internalFormat = TextureFormat::RGBA8;
         imageFormat = TextureFormat::RGBA;
+
+        if (premultiplyAlpha) {
+            size_t pixelCount {static_cast<size_t>(width) * height};
+            for (size_t i {0}; i < pixelCount; ++i) {
+                unsigned char* pixel {data + i * 4};
+                pixel[0] = static_cast<unsigned char>((pixel[0] * pixel[3] + 127) / 255);
+                pixel[1] = static_cast<unsigned char>((pixel[1] * pixel[3] + 127) / 255);
+                pixel[2] = static_cast<unsigned char>((pixel[2] * pixel[3] + 127) / 255);
+            }
+        }
     }
 
+    CreateStorage(data);
+
+    if (useDiskCache)
+        SaveToCache(cachePath, sourceHash, source.GetSize(), flags, data, static_cast<size_t>(width) * height * channels);
+
+    stbi_image_free(data);
+
+    LOG_DEBUG("Texture [{}] ({}) created.", id, fileName);
+
+    return true;
+}
+
+void Texture::CreateStorage(const void* pixels) {
 #ifdef OGL_DSA
     glCreateTextures(GL_TEXTURE_2D, 1, &id);
 
@@ -244,7 +338,8 @@ bool Texture::Load(const std::string& fileName, bool flipYAxis) {
     // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexStorage2D.xhtml
     glTextureStorage2D(id, 1, ToOpenGL(internalFormat), width, height);
     // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexSubImage2D.xhtml
-    glTextureSubImage2D(id, 0, 0, 0, width, height, ToOpenGL(imageFormat), GL_UNSIGNED_BYTE, data);
+    glTextureSubImage2D(id, 0, 0, 0, width, height, ToOpenGL(imageFormat), GL_UNSIGNED_BYTE, pixels);
+    RenderStats::AddUploadedBytes(static_cast<uint64_t>(width) * height * GetChannelCount(imageFormat));
 #else 
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
@@ -257,18 +352,75 @@ bool Texture::Load(const std::string& fileName, bool flipYAxis) {
 
     glPixelStorei(GL_PACK_ALIGNMENT, 1);
     glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, imageFormat, GL_UNSIGNED_BYTE, data);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, imageFormat, GL_UNSIGNED_BYTE, pixels);
 
     // glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, imageFormat, GL_UNSIGNED_BYTE, data);
 #endif  // OGL_DSA
+}
 
-    stbi_image_free(data);
+//+ Disk Cache ================================================================
 
-    LOG_DEBUG("Texture [{}] ({}) created.", id, fileName);
+bool Texture::LoadFromCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint32_t flags) {
+    MappedFile cache {cachePath};
+    if (!cache.IsOpen() || cache.GetSize() < sizeof(TextureCacheHeader))
+        return false;
+
+    TextureCacheHeader header;
+    std::memcpy(&header, cache.GetData(), sizeof(TextureCacheHeader));
+
+    if (header.magic != textureCacheMagic || header.version != textureCacheVersion ||
+        header.sourceHash != sourceHash || header.sourceSize != sourceSize || header.flags != flags ||
+        header.pixelsSize != cache.GetSize() - sizeof(TextureCacheHeader)) {
+        LOG_DEBUG("Texture cache {} is stale, decoding source image again.", cachePath);
+        return false;
+    }
+
+    width = header.width;
+    height = header.height;
+    internalFormat = static_cast<TextureFormat>(header.internalFormat);
+    imageFormat = static_cast<TextureFormat>(header.imageFormat);
+    wrapS = static_cast<TextureParameter>(header.wrapS);
+    wrapT = static_cast<TextureParameter>(header.wrapT);
+    minFilter = static_cast<TextureParameter>(header.minFilter);
+    magFiler = static_cast<TextureParameter>(header.magFilter);
+
+    // The pixels are uploaded straight from the mapped file, no intermediate copy is needed
+    CreateStorage(cache.GetData() + sizeof(TextureCacheHeader));
 
     return true;
 }
 
+void Texture::SaveToCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint32_t flags, const void* pixels, size_t pixelsSize) const {
+    if (!FileSystem::CreateDirectories(cacheDirectory))
+        return;
+
+    TextureCacheHeader header;
+    header.magic = textureCacheMagic;
+    header.version = textureCacheVersion;
+    header.flags = flags;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.width = width;
+    header.height = height;
+    header.internalFormat = static_cast<uint32_t>(internalFormat);
+    header.imageFormat = static_cast<uint32_t>(imageFormat);
+    header.wrapS = static_cast<uint32_t>(wrapS);
+    header.wrapT = static_cast<uint32_t>(wrapT);
+    header.minFilter = static_cast<uint32_t>(minFilter);
+    header.magFilter = static_cast<uint32_t>(magFiler);
+    header.pixelsSize = pixelsSize;
+
+    // A partially written file will fail the size check on the next load, so there is no need for a temporary file
+    std::ofstream file {cachePath, std::ios::out | std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+        LOG_WARN("Failed to open texture cache file {}.", cachePath);
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(TextureCacheHeader));
+    file.write(static_cast<const char*>(pixels), pixelsSize);
+}
+
 void Texture::Generate(uint32_t width, uint32_t height, const void* pixels, TextureFormat internalFormat, TextureFormat imageFormat, DataType type) {
     Unload();
 
@@ -286,18 +438,23 @@ void Texture::Generate(uint32_t width, uint32_t height, const void* pixels, Text
     glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, ToOpenGL(magFiler));
 
     glTextureStorage2D(id, 1, ToOpenGL(internalFormat), width, height);
-    if (pixels)
+    if (pixels) {
         glTextureSubImage2D(id, 0, 0, 0, width, height, ToOpenGL(imageFormat), ToOpenGL(type), pixels);
+        RenderStats::AddUploadedBytes(static_cast<uint64_t>(width) * height * GetChannelCount(imageFormat) * GetDataTypeSize(type));
+    }
 }
 
 void Texture::SubImage(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height, const void* pixels, DataType type) {
-    if (pixels) 
+    if (pixels) {
         glTextureSubImage2D(id, 0, xoffset, yoffset, width, height, ToOpenGL(imageFormat), ToOpenGL(type), pixels);
+        RenderStats::AddUploadedBytes(static_cast<uint64_t>(width) * height * GetChannelCount(imageFormat) * GetDataTypeSize(type));
+    }
 }
 
 void Texture::Unload() {
     if (id != 0) {
         LOG_DEBUG("Texture [{}] deleted.", id);
+        GLState::OnTextureDeleted(id);
         glDeleteTextures(1, &id);
         id = 0;
     }
@@ -305,15 +462,20 @@ void Texture::Unload() {
 
 void Texture::Use(int index) const {
 #ifdef OGL_DSA
-    glBindTextureUnit(index, id);
+    GLState::BindTextureUnit(index, id);
 #else
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, id);
 #endif  // OGL_DSA
 }
 
-void Texture::Unbind() const {
+void Texture::Unbind(int index) const {
+#ifdef OGL_DSA
+    GLState::BindTextureUnit(index, 0);
+#else
+    glActiveTexture(GL_TEXTURE0 + index);
     glBindTexture(GL_TEXTURE_2D, 0);
+#endif  // OGL_DSA
 }
 
 Texture& Texture::SetWrapS(TextureParameter wrapS) {
@@ -156,27 +156,32 @@ enum class TextureFormat : uint32_t {
     RGBA16UI,
     RGBA32I,
     RGBA32UI,
-    Depth24_Stencil8
+    Depth24_Stencil8,
+
+    //+ Integer image formats (appended so the values stored in the texture cache don't change):
+    RED_INTEGER
 };
 
 uint32_t ToOpenGL(TextureFormat format);
+// Components per pixel of an image (client data) format, 0 for internal formats
+uint32_t GetChannelCount(TextureFormat imageFormat);
 
 class Texture {
    public:
     Texture();
-    Texture(const std::string& fileName, bool flipYAxis = false);
+    Texture(const std::string& fileName, bool flipYAxis = false, bool premultiplyAlpha = false);
     Texture(Texture&& other);
     Texture& operator=(Texture&& other);
     ~Texture();
     Texture(const Texture& other) = delete;
     Texture& operator=(const Texture& other) = delete;
 
-    bool Load(const std::string& fileName, bool flipYAxis = false);
+    bool Load(const std::string& fileName, bool flipYAxis = false, bool premultiplyAlpha = false);
     void Generate(uint32_t width, uint32_t height, const void* pixels, TextureFormat internalFormat, TextureFormat imageFormat, DataType type = DataType::UByte);
     void SubImage(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height, const void* pixels, DataType type = DataType::UByte);
     void Unload();
     void Use(int index = 0) const;
-    void Unbind() const;
+    void Unbind(int index = 0) const;
     bool IsNull() const { return id == 0; }
 
     Texture& SetWrapS(TextureParameter param);
@@ -200,7 +205,17 @@ class Texture {
 
     static float GetMaxAnisotropicLevel();
 
+    // Decoded images are stored in the cache directory so the next launch can skip the png decoding
+    static void EnableDiskCache(bool enable) { useDiskCache = enable; }
+    static bool IsDiskCacheEnabled() { return useDiskCache; }
+    static void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+    static const std::string& GetCacheDirectory() { return cacheDirectory; }
+
 private:
+    void CreateStorage(const void* pixels);
+    bool LoadFromCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint32_t flags);
+    void SaveToCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint32_t flags, const void* pixels, size_t pixelsSize) const;
+
     uint32_t id{0};
     int width{0};
     int height{0};
@@ -216,6 +231,9 @@ private:
     TextureParameter magFiler;
 
     bool hasMipmap;
+
+    static bool useDiskCache;
+    static std::string cacheDirectory;
 };
 
 #endif  // __TEXTURE_H__
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "TextureArray.hpp"
+
+#include "Core/Log.hpp"
+#include "GLState.hpp"
+#include "RenderStats.hpp"
+
+#include <glad/glad.h>
+
+TextureArray::TextureArray()
+    : internalFormat{TextureFormat::RGBA8}, imageFormat{TextureFormat::RGBA}, wrapS{TextureParameter::ClampToEdge}, wrapT{TextureParameter::ClampToEdge},
+      minFilter{TextureParameter::Nearest}, magFilter{TextureParameter::Nearest} {}
+
+TextureArray::TextureArray(TextureArray&& other)
+    : id{other.id}, width{other.width}, height{other.height}, layers{other.layers}, internalFormat{other.internalFormat}, imageFormat{other.imageFormat},
+      wrapS{other.wrapS}, wrapT{other.wrapT}, minFilter{other.minFilter}, magFilter{other.magFilter} {
+    other.id = 0;
+}
+
+TextureArray& TextureArray::operator=(TextureArray&& other) {
+    Unload();
+    id = other.id;
+    other.id = 0;
+    width = other.width;
+    height = other.height;
+    layers = other.layers;
+    internalFormat = other.internalFormat;
+    imageFormat = other.imageFormat;
+    wrapS = other.wrapS;
+    wrapT = other.wrapT;
+    minFilter = other.minFilter;
+    magFilter = other.magFilter;
+    return *this;
+}
+
+TextureArray::~TextureArray() {
+    Unload();
+}
+
+void TextureArray::Generate(uint32_t width, uint32_t height, uint32_t layers, TextureFormat internalFormat, TextureFormat imageFormat) {
+    Unload();
+
+    this->width = width;
+    this->height = height;
+    this->layers = layers;
+    this->internalFormat = internalFormat;
+    this->imageFormat = imageFormat;
+
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id);
+
+    glTextureParameteri(id, GL_TEXTURE_WRAP_S, ToOpenGL(wrapS));
+    glTextureParameteri(id, GL_TEXTURE_WRAP_T, ToOpenGL(wrapT));
+    glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, ToOpenGL(minFilter));
+    glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, ToOpenGL(magFilter));
+
+    glTextureStorage3D(id, 1, ToOpenGL(internalFormat), width, height, layers);
+
+    LOG_DEBUG("Texture array [{}] ({}x{}, {} layers) created.", id, width, height, layers);
+}
+
+void TextureArray::SubImage(uint32_t layer, uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height, const void* pixels, DataType type) {
+    if (pixels) {
+        glTextureSubImage3D(id, 0, xoffset, yoffset, layer, width, height, 1, ToOpenGL(imageFormat), ToOpenGL(type), pixels);
+        RenderStats::AddUploadedBytes(static_cast<uint64_t>(width) * height * GetChannelCount(imageFormat) * GetDataTypeSize(type));
+    }
+}
+
+void TextureArray::CopyFromTexture(uint32_t layer, const Texture& texture) {
+    if (texture.GetWidth() != width || texture.GetHeight() != height) {
+        LOG_WARN("Texture [{}] ({}x{}) does not match the texture array size ({}x{}).", texture.GetID(), texture.GetWidth(), texture.GetHeight(), width, height);
+        return;
+    }
+
+    glCopyImageSubData(texture.GetID(), GL_TEXTURE_2D, 0, 0, 0, 0,
+                       id, GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer,
+                       width, height, 1);
+}
+
+void TextureArray::Unload() {
+    if (id != 0) {
+        LOG_DEBUG("Texture array [{}] deleted.", id);
+        GLState::OnTextureDeleted(id);
+        glDeleteTextures(1, &id);
+        id = 0;
+    }
+}
+
+void TextureArray::Use(int index) const {
+    GLState::BindTextureUnit(index, id);
+}
+
+TextureArray& TextureArray::SetWrapS(TextureParameter wrapS) {
+    this->wrapS = wrapS;
+    glTextureParameteri(id, GL_TEXTURE_WRAP_S, ToOpenGL(this->wrapS));
+    return *this;
+}
+
+TextureArray& TextureArray::SetWrapT(TextureParameter wrapT) {
+    this->wrapT = wrapT;
+    glTextureParameteri(id, GL_TEXTURE_WRAP_T, ToOpenGL(this->wrapT));
+    return *this;
+}
+
+TextureArray& TextureArray::SetMinFilter(TextureParameter minFilter) {
+    this->minFilter = minFilter;
+    glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, ToOpenGL(this->minFilter));
+    return *this;
+}
+
+TextureArray& TextureArray::SetMagFilter(TextureParameter magFilter) {
+    this->magFilter = magFilter;
+    glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, ToOpenGL(this->magFilter));
+    return *this;
+}
@@ -0,0 +1,51 @@
+#ifndef __TEXTUREARRAY_H__
+#define __TEXTUREARRAY_H__
+
+#include "Texture.hpp"
+
+// GL_TEXTURE_2D_ARRAY where all the layers share the same size and format
+class TextureArray {
+public:
+    TextureArray();
+    TextureArray(TextureArray&& other);
+    TextureArray& operator=(TextureArray&& other);
+    ~TextureArray();
+    TextureArray(const TextureArray& other) = delete;
+    TextureArray& operator=(const TextureArray& other) = delete;
+
+    void Generate(uint32_t width, uint32_t height, uint32_t layers, TextureFormat internalFormat, TextureFormat imageFormat);
+    void SubImage(uint32_t layer, uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height, const void* pixels, DataType type = DataType::UByte);
+    // Copies the whole texture into the layer, both must have the same size and a compatible format
+    void CopyFromTexture(uint32_t layer, const Texture& texture);
+    void Unload();
+    void Use(int index = 0) const;
+    bool IsNull() const { return id == 0; }
+
+    TextureArray& SetWrapS(TextureParameter param);
+    TextureArray& SetWrapT(TextureParameter param);
+    TextureArray& SetMinFilter(TextureParameter param);
+    TextureArray& SetMagFilter(TextureParameter param);
+
+    uint32_t GetID() const { return id; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    int GetLayers() const { return layers; }
+    TextureFormat GetInternalFormat() const { return internalFormat; }
+    TextureFormat GetImageFormat() const { return imageFormat; }
+
+private:
+    uint32_t id{0};
+    int width{0};
+    int height{0};
+    int layers{0};
+
+    TextureFormat internalFormat;
+    TextureFormat imageFormat;
+
+    TextureParameter wrapS;
+    TextureParameter wrapT;
+    TextureParameter minFilter;
+    TextureParameter magFilter;
+};
+
+#endif // __TEXTUREARRAY_H__
@@ -0,0 +1,224 @@
+#include "TextureAtlas.hpp"
+
+#include "Core/Log.hpp"
+#include "Texture.hpp"
+#include "TextureArray.hpp"
+
+#include <algorithm>
+#include <glad/glad.h>
+
+//+ SkylinePacker =============================================================
+
+SkylinePacker::SkylinePacker(int width, int height)
+    : width{width}, height{height} {
+    Reset();
+}
+
+bool SkylinePacker::Insert(const glm::ivec2& size, glm::ivec2* outPosition) {
+    int bestTop {height + 1};
+    int bestWidth {width + 1};
+    size_t bestIndex {skyline.size()};
+    glm::ivec2 bestPosition {0};
+
+    for (size_t i {0}; i < skyline.size(); ++i) {
+        int y {Fit(i, size)};
+        if (y < 0)
+            continue;
+
+        // Prefer the lowest placement, and on ties the one wasting less of the skyline segment
+        int top {y + size.y};
+        if (top < bestTop || (top == bestTop && skyline[i].width < bestWidth)) {
+            bestTop = top;
+            bestWidth = skyline[i].width;
+            bestIndex = i;
+            bestPosition = glm::ivec2{skyline[i].x, y};
+        }
+    }
+
+    if (bestIndex == skyline.size())
+        return false;
+
+    AddNode(bestIndex, bestPosition, size);
+    usedArea += size.x * size.y;
+    *outPosition = bestPosition;
+    return true;
+}
+
+void SkylinePacker::Reset() {
+    usedArea = 0;
+    skyline.clear();
+    skyline.push_back(Node{0, 0, width});
+}
+
+int SkylinePacker::Fit(size_t index, const glm::ivec2& size) const {
+    if (skyline[index].x + size.x > width)
+        return -1;
+
+    int y {skyline[index].y};
+    int widthLeft {size.x};
+    for (size_t i {index}; widthLeft > 0 && i < skyline.size(); ++i) {
+        y = std::max(y, skyline[i].y);
+        if (y + size.y > height)
+            return -1;
+        widthLeft -= skyline[i].width;
+    }
+
+    return y;
+}
+
+void SkylinePacker::AddNode(size_t index, const glm::ivec2& position, const glm::ivec2& size) {
+    skyline.insert(skyline.begin() + index, Node{position.x, position.y + size.y, size.x});
+
+    // Shrink or remove the nodes covered by the new one
+    for (size_t i {index + 1}; i < skyline.size();) {
+        const Node& previous {skyline[i - 1]};
+        int previousEnd {previous.x + previous.width};
+        if (skyline[i].x >= previousEnd)
+            break;
+
+        int shrink {previousEnd - skyline[i].x};
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0)
+            break;
+
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Merge neighbours with the same height
+    for (size_t i {0}; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+//+ TextureAtlas ==============================================================
+
+std::vector<Ref<Texture>> TextureAtlas::sources;
+std::vector<Ref<Texture>> TextureAtlas::pages;
+Ref<TextureArray> TextureAtlas::pageArray;
+std::unordered_map<Ref<Texture>, AtlasEntry> TextureAtlas::entries;
+
+void TextureAtlas::Add(Ref<Texture> texture) {
+    if (!texture || texture->IsNull())
+        return;
+
+    if (std::find(sources.begin(), sources.end(), texture) == sources.end())
+        sources.push_back(texture);
+}
+
+bool TextureAtlas::Build(int pageSize, int padding) {
+    pages.clear();
+    pageArray.reset();
+    entries.clear();
+
+    int maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    pageSize = std::min(pageSize, maxTextureSize);
+
+    // Taller textures first gives a flatter skyline
+    std::vector<Ref<Texture>> sortedSources {sources};
+    std::sort(sortedSources.begin(), sortedSources.end(), [](const Ref<Texture>& a, const Ref<Texture>& b) {
+        if (a->GetHeight() != b->GetHeight())
+            return a->GetHeight() > b->GetHeight();
+        return a->GetWidth() > b->GetWidth();
+    });
+
+    struct Placement {
+        Ref<Texture> source;
+        int page;
+        glm::ivec2 position;
+    };
+
+    std::vector<SkylinePacker> packers;
+    std::vector<Placement> placements;
+    placements.reserve(sortedSources.size());
+
+    for (auto& source : sortedSources) {
+        glm::ivec2 paddedSize {source->GetWidth() + padding * 2, source->GetHeight() + padding * 2};
+        if (paddedSize.x > pageSize || paddedSize.y > pageSize) {
+            LOG_WARN("Texture {} ({}x{}) is too big for the atlas pages and will be drawn on its own.",
+                     source->GetPath(), source->GetWidth(), source->GetHeight());
+            continue;
+        }
+
+        glm::ivec2 position;
+        int page {-1};
+        for (size_t i {0}; i < packers.size(); ++i) {
+            if (packers[i].Insert(paddedSize, &position)) {
+                page = static_cast<int>(i);
+                break;
+            }
+        }
+
+        if (page < 0) {
+            packers.emplace_back(pageSize, pageSize);
+            packers.back().Insert(paddedSize, &position);
+            page = static_cast<int>(packers.size() - 1);
+        }
+
+        placements.push_back(Placement{source, page, position + glm::ivec2{padding}});
+    }
+
+    for (size_t i {0}; i < packers.size(); ++i) {
+        auto page {MakeRef<Texture>()};
+        page->Generate(pageSize, pageSize, nullptr, TextureFormat::RGBA8, TextureFormat::RGBA);
+        page->SetMinFilter(TextureParameter::Nearest).SetMagFilter(TextureParameter::Nearest)
+            .SetWrapS(TextureParameter::ClampToEdge).SetWrapT(TextureParameter::ClampToEdge);
+        glClearTexImage(page->GetID(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        pages.push_back(page);
+    }
+
+    // The sources may have any number of channels, so they are read back as RGBA instead of using glCopyImageSubData
+    std::vector<uint8_t> pixels;
+    for (auto& placement : placements) {
+        auto& source {placement.source};
+        auto& page {pages[placement.page]};
+        pixels.resize(static_cast<size_t>(source->GetWidth()) * source->GetHeight() * 4);
+        glGetTextureImage(source->GetID(), 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<int>(pixels.size()), pixels.data());
+        page->SubImage(placement.position.x, placement.position.y, source->GetWidth(), source->GetHeight(), pixels.data());
+
+        // Sprite uvs have their origin at the top-left corner while the packer works from the bottom-left
+        glm::vec2 topLeft {placement.position.x, pageSize - placement.position.y - source->GetHeight()};
+        AtlasEntry entry;
+        entry.page = page;
+        entry.pageIndex = placement.page;
+        entry.uvOffset = topLeft / static_cast<float>(pageSize);
+        entry.uvScale = glm::vec2{source->GetWidth(), source->GetHeight()} / static_cast<float>(pageSize);
+        entries.emplace(source, entry);
+    }
+
+    if (!pages.empty()) {
+        pageArray = MakeRef<TextureArray>();
+        pageArray->Generate(pageSize, pageSize, static_cast<uint32_t>(pages.size()), TextureFormat::RGBA8, TextureFormat::RGBA);
+        for (size_t i {0}; i < pages.size(); ++i)
+            pageArray->CopyFromTexture(static_cast<uint32_t>(i), *pages[i]);
+    }
+
+    for (size_t i {0}; i < packers.size(); ++i) {
+        LOG_DEBUG("Texture atlas page {} ({}x{}): {:.1f}% used.", i, pageSize, pageSize,
+                  100.0f * packers[i].GetUsedArea() / (static_cast<float>(pageSize) * pageSize));
+    }
+    LOG_INFO("Texture atlas built: {} textures packed in {} pages.", entries.size(), pages.size());
+
+    return !pages.empty();
+}
+
+void TextureAtlas::Clear() {
+    sources.clear();
+    pages.clear();
+    pageArray.reset();
+    entries.clear();
+}
+
+const AtlasEntry* TextureAtlas::Find(const Ref<Texture>& texture) {
+    auto entry {entries.find(texture)};
+    if (entry != entries.end())
+        return &entry->second;
+    return nullptr;
+}
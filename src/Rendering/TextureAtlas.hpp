@@ -0,0 +1,82 @@
+#ifndef __TEXTUREATLAS_H__
+#define __TEXTUREATLAS_H__
+
+#include "Common.hpp"
+
+#include <glm/vec2.hpp>
+#include <unordered_map>
+#include <vector>
+
+class Texture;
+class TextureArray;
+
+// Skyline bottom-left rectangle packer
+class SkylinePacker {
+public:
+    SkylinePacker(int width, int height);
+
+    /**
+     * @brief Finds a place for a rectangle of the given size
+     *
+     * @param size Size of the rectangle in pixels
+     * @param outPosition Bottom-left corner of the placed rectangle
+     * @return false if the rectangle does not fit anymore
+     */
+    bool Insert(const glm::ivec2& size, glm::ivec2* outPosition);
+    void Reset();
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    int GetUsedArea() const { return usedArea; }
+
+private:
+    // Returns the y coordinate the rectangle would rest on if placed at the node index, or -1 if it does not fit
+    int Fit(size_t index, const glm::ivec2& size) const;
+    void AddNode(size_t index, const glm::ivec2& position, const glm::ivec2& size);
+
+    struct Node {
+        int x;
+        int y;
+        int width;
+    };
+
+    int width;
+    int height;
+    int usedArea {0};
+    std::vector<Node> skyline;
+};
+
+struct AtlasEntry {
+    Ref<Texture> page;
+    int pageIndex;
+    // Transforms the uvs of the source texture (top-left origin) to the uvs of the page: uvOffset + uv * uvScale
+    glm::vec2 uvOffset;
+    glm::vec2 uvScale;
+};
+
+/**
+ * @brief Packs the registered textures into a few big pages so sprites from different sprite sheets can be drawn
+ * with the same texture binding. Sprites created after Build() are remapped automatically.
+ */
+class TextureAtlas {
+public:
+    static void Add(Ref<Texture> texture);
+    static bool Build(int pageSize = 2048, int padding = 1);
+    static void Clear();
+
+    // Returns nullptr if the texture is not packed in any page
+    static const AtlasEntry* Find(const Ref<Texture>& texture);
+
+    static const std::vector<Ref<Texture>>& GetPages() { return pages; }
+    // Same pages stored as layers of a GL_TEXTURE_2D_ARRAY, the layer of each page is its AtlasEntry::pageIndex
+    static const Ref<TextureArray>& GetPageArray() { return pageArray; }
+    static bool IsBuilt() { return !pages.empty(); }
+
+private:
+    static std::vector<Ref<Texture>> sources;
+    static std::vector<Ref<Texture>> pages;
+    static Ref<TextureArray> pageArray;
+    static std::unordered_map<Ref<Texture>, AtlasEntry> entries;
+};
+
+#endif // __TEXTUREATLAS_H__
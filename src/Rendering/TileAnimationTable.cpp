@@ -0,0 +1,74 @@
+#include "TileAnimationTable.hpp"
+
+#include "Core/Log.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <glad/glad.h>
+
+TileAnimationTable::TileAnimationTable() {
+}
+
+TileAnimationTable::~TileAnimationTable() {
+    if (textureID != 0) {
+        GLState::OnTextureDeleted(textureID);
+        glDeleteTextures(1, &textureID);
+    }
+}
+
+void TileAnimationTable::SetAnimation(uint16_t tile, const std::vector<TileAnimationFrame>& frames) {
+    if (frames.empty())
+        animations.erase(tile);
+    else
+        animations[tile] = frames;
+    isDirty = true;
+}
+
+void TileAnimationTable::Clear() {
+    animations.clear();
+    isDirty = true;
+}
+
+void TileAnimationTable::Upload() {
+    isDirty = false;
+
+    entryCount = 0;
+    uint32_t frameCount {0};
+    for (auto& [tile, frames] : animations) {
+        entryCount = std::max(entryCount, static_cast<uint32_t>(tile) + 1);
+        frameCount += static_cast<uint32_t>(frames.size());
+    }
+
+    //+ Entries first, then the frames of every animation one after the other
+    std::vector<uint32_t> texels((entryCount + frameCount) * 2, 0);
+    uint32_t nextFrame {entryCount};
+    for (auto& [tile, frames] : animations) {
+        texels[tile * 2 + 0] = nextFrame;
+        texels[tile * 2 + 1] = static_cast<uint32_t>(frames.size());
+
+        float endTime {0.0f};
+        for (auto& frame : frames) {
+            endTime += frame.duration;
+            texels[nextFrame * 2 + 0] = frame.tile;
+            std::memcpy(&texels[nextFrame * 2 + 1], &endTime, sizeof(float));
+            ++nextFrame;
+        }
+    }
+
+    if (texels.empty()) {
+        buffer.Destroy();
+        return;
+    }
+
+    buffer.Create(static_cast<uint32_t>(texels.size() * sizeof(uint32_t)), texels.data(), BufferUsage::Static, BufferTarget::TextureBuffer);
+    if (textureID == 0)
+        glCreateTextures(GL_TEXTURE_BUFFER, 1, &textureID);
+    glTextureBuffer(textureID, GL_RG32UI, buffer.GetID());
+
+    LOG_DEBUG("Tile animation table uploaded: {} animations, {} entries, {} frames.", animations.size(), entryCount, frameCount);
+}
+
+void TileAnimationTable::Use() const {
+    GLState::BindTextureUnit(textureUnit, textureID);
+}
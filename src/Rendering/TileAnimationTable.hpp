@@ -0,0 +1,51 @@
+#ifndef __TILEANIMATIONTABLE_H__
+#define __TILEANIMATIONTABLE_H__
+
+#include "Buffer.hpp"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+struct TileAnimationFrame {
+    uint16_t tile;  // Same type as tile_t
+    float duration; // In seconds
+};
+
+/**
+ * @brief Animation sequences of the tile ids of a tileset, uploaded once to a buffer texture (RG32UI) that the tilemap
+ * shaders read to replace each animated tile id by its current frame using the global time. Every tile sharing an id
+ * animates without any CPU work per frame.
+ *
+ * Texel layout: [0, GetEntryCount()) indexed by tile id, x = first frame texel (0 if not animated), y = frame count;
+ * followed by the frames, x = tile, y = end time of the frame in the cycle (float bits).
+ */
+class TileAnimationTable {
+public:
+    static constexpr int textureUnit {2};
+
+    TileAnimationTable();
+    ~TileAnimationTable();
+    TileAnimationTable(const TileAnimationTable&) = delete;
+    TileAnimationTable& operator=(const TileAnimationTable&) = delete;
+
+    // Replaces the animation of tile, an empty sequence removes it. Changes take effect on the next Upload
+    void SetAnimation(uint16_t tile, const std::vector<TileAnimationFrame>& frames);
+    void Clear();
+    void Upload();
+    void Use() const;
+
+    // Number of tile ids covered by the uploaded table, ids equal or greater are never animated
+    uint32_t GetEntryCount() const { return entryCount; }
+    uint32_t GetAnimationCount() const { return static_cast<uint32_t>(animations.size()); }
+    bool IsDirty() const { return isDirty; }
+
+private:
+    std::unordered_map<uint16_t, std::vector<TileAnimationFrame>> animations;
+    Buffer buffer;
+    uint32_t textureID  {0};
+    uint32_t entryCount {0};
+    bool isDirty        {false};
+};
+
+#endif // __TILEANIMATIONTABLE_H__
@@ -1,6 +1,8 @@
 #include "VertexArray.hpp"
 
 #include "Core/Log.hpp"
+#include "GLState.hpp"
+#include "RenderStats.hpp"
 
 #include <glad/glad.h>
 
@@ -81,11 +83,11 @@ VertexArray& VertexArray::operator=(VertexArray && other) {
 }
 
 void VertexArray::Use() const {
-    glBindVertexArray(id);
+    GLState::BindVertexArray(id);
 }
 
 void VertexArray::Unbind() const {
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 }
 
 void VertexArray::Destroy() {
@@ -97,22 +99,37 @@ void VertexArray::Destroy() {
             ibo.Destroy();
         }
         LOG_DEBUG("VAO [{}] deleted.", id);
+        GLState::OnVertexArrayDeleted(id);
         glDeleteVertexArrays(1, &id);
         id = 0;
     }
 }
 
 void VertexArray::Draw() const {
+    RenderStats::AddDrawCalls();
     if (indicesCount != 0)
         glDrawElements(ToOpenGL(drawMode), indicesCount, GL_UNSIGNED_INT, nullptr);
     else
         glDrawArrays(ToOpenGL(drawMode), 0, verticesCount);
 }
 
+void VertexArray::MultiDraw(const int* firsts, const int* counts, int drawCount) const {
+    RenderStats::AddDrawCalls(static_cast<uint32_t>(drawCount));
+    glMultiDrawArrays(ToOpenGL(drawMode), firsts, counts, drawCount);
+}
+
 void VertexArray::SetDrawMode(DrawMode drawMode) {
     this->drawMode = drawMode;
 }
 
+void VertexArray::SetBindingDivisor(uint32_t divisor) {
+    glVertexArrayBindingDivisor(id, 0, divisor);
+}
+
+void VertexArray::SetVertexBuffer(uint32_t bufferID, uint32_t offset, uint32_t stride) {
+    glVertexArrayVertexBuffer(id, 0, bufferID, offset, stride);
+}
+
 uint32_t CalculateVertexSizeAndOffsets(VertexLayout& layout) {
     uint32_t size {0};
     for (VertexElement& element : layout) {
@@ -52,11 +52,18 @@ public:
     void Unbind() const;
     void Destroy();
     void Draw() const;
+    // Draws several ranges of vertices (glMultiDrawArrays), ignores the indices
+    void MultiDraw(const int* firsts, const int* counts, int drawCount) const;
     bool IsNull() const { return id == 0 && vbo.IsNull(); }
 
     void SetDrawMode(DrawMode drawMode);
+    // A divisor different than 0 makes the vertex buffer advance per instance instead of per vertex
+    void SetBindingDivisor(uint32_t divisor);
+    // Sources the vertices from another buffer (e.g. a StreamingBuffer) starting at offset bytes
+    void SetVertexBuffer(uint32_t bufferID, uint32_t offset, uint32_t stride);
 
     uint32_t GetID() const { return id; }
+    DrawMode GetDrawMode() const { return drawMode; }
     uint32_t GetVerticesCount() const { return verticesCount; }
     uint32_t GetIndicesCount() const { return indicesCount; }
 
@@ -1,10 +1,7 @@
 #include "Image.hpp"
 
-#include "Core/AssetManager.hpp"
-#include "Rendering/Shader.hpp"
 #include "Rendering/Sprite.hpp"
 #include "Rendering/Texture.hpp"
-#include "Rendering/VertexArray.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -25,30 +22,11 @@ Image::Image(const Rect& rect, const std::vector<Ref<class Sprite>>&& sprites, c
 }
 
 void Image::Draw() {
-    auto uiShader{AssetManager::GetShader("gui")};
-    uiShader->Use();
-
     if (!useNineSlice) {
         UpdateTransform();
-        sprite->GetTexture()->Use();
-        uiShader->SetMatrix4("model", GetModel());
-        uiShader->SetVec2("spriteMinUV", sprite->GetMinUV());
-        uiShader->SetVec2("spriteMaxUV", sprite->GetMaxUV());
-        uiShader->SetVec4("color", color);
-        uiShader->SetBool("flipX", sprite->flipX);
-        uiShader->SetBool("flipY", sprite->flipY);
-        uiShader->SetBool("useVirtualResolution", true);
-        auto guiVao{AssetManager::GetVertexArray("gui")};
-        guiVao->Use();
-        guiVao->Draw();
+        RecordGuiQuad(GetModel(), sprite->GetTexture()->GetID(), *sprite, color);
     }
     else {
-        auto guiVao {AssetManager::GetVertexArray("gui")};
-        slicedSprites[0]->GetTexture()->Use();
-
-        uiShader->SetVec4("color", color);
-        uiShader->SetBool("useVirtualResolution", true);
-        
         glm::mat4 newModel;
 
         for (int i {0}; i < slicedSprites.size(); ++i) {
@@ -104,13 +82,7 @@ void Image::Draw() {
                 return;
             }
             
-            uiShader->SetMatrix4("model", newModel);
-            uiShader->SetVec2("spriteMinUV", slicedSprites[i]->GetMinUV());
-            uiShader->SetVec2("spriteMaxUV", slicedSprites[i]->GetMaxUV());
-            uiShader->SetBool("flipX", slicedSprites[i]->flipX);
-            uiShader->SetBool("flipY", slicedSprites[i]->flipY);
-            guiVao->Use();
-            guiVao->Draw();
+            RecordGuiQuad(newModel, slicedSprites[0]->GetTexture()->GetID(), *slicedSprites[i], color);
         }
     }
 }
\ No newline at end of file
@@ -2,9 +2,10 @@
 
 #include "Core/Log.hpp"
 #include "Rendering/Camera.hpp"
+#include "Rendering/RenderCommands.hpp"
 #include "Text/TextRenderer.hpp"
 
-#include <glad/glad.h>
+bool Label::useTextMeshes {true};
 
 Label::Label(const std::string& text, int textSize, const std::string& name) : Widget{Rect{glm::vec2{0.0f}, glm::vec2{0.0f}}, name}, text{text}, textSize{textSize} {
     SplitTextLines(text, textLines);
@@ -37,20 +38,33 @@ void Label::Draw() {
     if (!atlas) 
         return;
 
+    RenderCommandList& commands {RenderQueue::GetList()};
+    RenderState previousState {commands.GetState()};
     if (clipText) {
-        glEnable(GL_SCISSOR_TEST);
         Rect scaledRect{Camera::GetMainCamera().RectFromVirtual2ScreenSize(rect, true)};
-        glScissor(static_cast<int>(scaledRect.position.x),
-                  static_cast<int>(scaledRect.position.y),
-                  static_cast<int>(scaledRect.size.x),
-                  static_cast<int>(scaledRect.size.y));
+        commands.GetState().scissorTest = true;
+        commands.GetState().scissor = glm::ivec4{static_cast<int>(scaledRect.position.x),
+                                                 static_cast<int>(scaledRect.position.y),
+                                                 static_cast<int>(scaledRect.size.x),
+                                                 static_cast<int>(scaledRect.size.y)};
     }
 
     // TextRenderer::RenderText(text, textSize, rect.position, appearance, settings, font);
-    TextRenderer::RenderText(textLines, textSize, rect, textBounds, appearance, settings, horizontalAlign, verticalAlign, transform, font, atlas);
+    if (useTextMeshes) {
+        if (isTextMeshDirty || IsTextMeshOutdated(atlas) || !textMesh.AreGlyphsCached()) {
+            textMesh.Build(textLines, textSize, rect, textBounds, appearance, settings, horizontalAlign, verticalAlign, transform, font, atlas);
+            textMeshInputs = TextMeshInputs{rect, horizontalAlign, verticalAlign, transform, appearance.color,
+                                            appearance.useColorGradient, appearance.colorGradient, atlas};
+            isTextMeshDirty = false;
+        }
+        textMesh.Draw(appearance);
+    }
+    else {
+        TextRenderer::RenderText(textLines, textSize, rect, textBounds, appearance, settings, horizontalAlign, verticalAlign, transform, font, atlas);
+    }
 
     if (clipText) {
-        glDisable(GL_SCISSOR_TEST);
+        commands.SetState(previousState);
     }
 }
 
@@ -91,7 +105,25 @@ void Label::SetSpacesPerTab(int value) {
 }
 
 
+bool Label::IsTextMeshOutdated(const Atlas* atlas) const {
+    auto sameColor {[](const Color& a, const Color& b) { return a.c == b.c; }};
+    const TextMeshInputs& inputs {textMeshInputs};
+    if (inputs.atlas != atlas || inputs.rect.position != rect.position || inputs.rect.size != rect.size ||
+        inputs.horizontalAlign != horizontalAlign || inputs.verticalAlign != verticalAlign || inputs.transform != transform ||
+        inputs.useColorGradient != appearance.useColorGradient)
+        return true;
+
+    if (appearance.useColorGradient) {
+        return !sameColor(inputs.colorGradient.topLeftColor, appearance.colorGradient.topLeftColor) ||
+               !sameColor(inputs.colorGradient.topRightColor, appearance.colorGradient.topRightColor) ||
+               !sameColor(inputs.colorGradient.bottomLeftColor, appearance.colorGradient.bottomLeftColor) ||
+               !sameColor(inputs.colorGradient.bottomRightColor, appearance.colorGradient.bottomRightColor);
+    }
+    return !sameColor(inputs.color, appearance.color);
+}
+
 void Label::UpdateLinesAndBounds() {
+    isTextMeshDirty = true;
     Atlas* atlas {TextRenderer::GetAtlas(font)};
     if (atlas) {
         textBounds = TextRenderer::GetTextBounds(textLines, textSize, settings, *atlas);
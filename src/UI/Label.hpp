@@ -40,6 +40,8 @@ public:
 
 private:
     void UpdateLinesAndBounds();
+    // Whether something used by the text mesh layout changed since it was built
+    bool IsTextMeshOutdated(const Atlas* atlas) const;
 
 public:
     TextAppearance appearance;
@@ -48,6 +50,9 @@ public:
     TextTransform transform       {TextTransform::None};
     bool wrap                     {false}; // TODO
     bool clipText                 {false};
+
+    // Draw the labels from their cached text mesh instead of laying out the text every frame
+    static bool useTextMeshes;
     
 protected:
     std::string text;
@@ -58,6 +63,20 @@ protected:
 
     glm::vec2 textBounds;
     std::vector<LineInfo> textLines;
+
+    TextMesh textMesh;
+    bool isTextMeshDirty {true};
+    // Values of the public members the mesh was built with, they can change without going through a setter
+    struct TextMeshInputs {
+        Rect rect;
+        TextHorzAlign horizontalAlign;
+        TextVertAlign verticalAlign;
+        TextTransform transform;
+        Color color;
+        bool useColorGradient;
+        TextGradient colorGradient;
+        const Atlas* atlas {nullptr};
+    } textMeshInputs;
 };
 
 #endif // __LABEL_H__
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "FontFace.hpp"
+
+#include "Core/Log.hpp"
+#include "GlyphCache.hpp"
+#include "TextRenderer.hpp"
+
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+bool FontFace::useDiskCache {true};
+std::string FontFace::cacheDirectory {"cache/fonts"};
+FontCacheStats FontFace::cacheStats;
+
+// Binary layout of the cached files: header, glyph records and the tightly packed pixels of every glyph
+struct FontCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    int32_t fontSize;
+    uint32_t mode;
+    int32_t metricsWidth;
+    int32_t metricsHeight;
+    int32_t maxBearingX;
+    int32_t maxBearingY;
+    uint32_t glyphCount;
+    uint32_t padding {0};
+    uint64_t pixelsSize;
+};
+
+constexpr uint32_t fontCacheMagic   {0x544E4654}; // "TFNT"
+constexpr uint32_t fontCacheVersion {1};
+
+FontFace::FontFace(const std::string& fontFile, int fontSize, FontRenderMode mode)
+    : fontFile{fontFile}, fontSize{fontSize}, mode{mode} {}
+
+FontFace::~FontFace() {
+    if (face)
+        FT_Done_Face(face);
+}
+
+bool FontFace::Open() {
+    if (!source.Open(fontFile)) {
+        LOG_WARN("Could not open font {}.", fontFile);
+        return false;
+    }
+    sourceHash = FileSystem::Hash(source.GetData(), source.GetSize());
+
+    if (useDiskCache) {
+        int32_t key[] {fontSize, static_cast<int32_t>(mode)};
+        cachePath = fmt::format("{}/{}.font", cacheDirectory, FileSystem::HashToString(FileSystem::Hash(key, sizeof(key), sourceHash)));
+        if (LoadCache()) {
+            ++cacheStats.cachedFonts;
+            return true;
+        }
+    }
+
+    // Without a cache the metrics come from FreeType
+    if (!OpenFreeType())
+        return false;
+
+    metricsWidth = face->size->metrics.max_advance;
+    metricsHeight = face->size->metrics.height;
+    isDirty = true;
+    return true;
+}
+
+bool FontFace::LoadGlyph(uint32_t codepoint, GlyphBitmap& outGlyph) {
+    auto it {glyphIndices.find(codepoint)};
+    if (it == glyphIndices.end())
+        return Rasterize(codepoint, outGlyph);
+
+    // Glyphs evicted from the GlyphCache come back from here too, without rasterizing them again
+    const CachedGlyph& glyph {glyphs[it->second]};
+    bool isCached {it->second < cachedGlyphCount};
+    outGlyph.size = glm::ivec2{glyph.width, glyph.height};
+    outGlyph.bearing = glm::ivec2{glyph.bearingX, glyph.bearingY};
+    outGlyph.advance = glm::ivec2{glyph.advanceX, glyph.advanceY};
+    outGlyph.pixels = (isCached ? cachedPixels : rasterizedPixels.data()) + glyph.pixelsOffset;
+    if (isCached)
+        ++cacheStats.cachedGlyphs;
+    return true;
+}
+
+void FontFace::SetMaxBearing(const glm::ivec2& bearing) {
+    if (bearing == maxBearing)
+        return;
+
+    maxBearing = bearing;
+    isDirty = true;
+}
+
+bool FontFace::OpenFreeType() {
+    FT_Library library {GlyphCache::GetLibrary()};
+    if (!library) {
+        LOG_WARN("Could not load font {}, FreeType is not initialized.", fontFile);
+        return false;
+    }
+
+    // The file stays mapped while the face is open, so FreeType reads it from memory
+    if (FT_New_Memory_Face(library, source.GetData(), static_cast<FT_Long>(source.GetSize()), 0, &face)) {
+        LOG_WARN("Could not open font {}.", fontFile);
+        face = nullptr;
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(face, 0, fontSize);
+    return true;
+}
+
+bool FontFace::Rasterize(uint32_t codepoint, GlyphBitmap& outGlyph) {
+    if (!face && !OpenFreeType())
+        return false;
+
+    if (mode == FontRenderMode::SDF) {
+        if (FT_Load_Char(face, codepoint, FT_LOAD_DEFAULT)) {
+            LOG_CRITICAL("Could not load character '{}'.", codepoint);
+            return false;
+        }
+
+        if (FT_Render_Glyph(face->glyph, FT_Render_Mode::FT_RENDER_MODE_SDF)) {
+            LOG_CRITICAL("Could not load character '{}' as SDF.", codepoint);
+            return false;
+        }
+    }
+    else {
+        if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) {
+            LOG_CRITICAL("Could not load character '{}'.", codepoint);
+            return false;
+        }
+    }
+
+    const FT_Bitmap& bitmap {face->glyph->bitmap};
+    CachedGlyph glyph;
+    glyph.codepoint = codepoint;
+    glyph.width = static_cast<int32_t>(bitmap.width);
+    glyph.height = static_cast<int32_t>(bitmap.rows);
+    glyph.bearingX = face->glyph->bitmap_left;
+    glyph.bearingY = face->glyph->bitmap_top;
+    glyph.advanceX = static_cast<int32_t>(face->glyph->advance.x);
+    glyph.advanceY = static_cast<int32_t>(face->glyph->advance.y);
+    glyph.pixelsOffset = static_cast<uint32_t>(rasterizedPixels.size());
+
+    // Rows of the FreeType bitmaps can be padded, they are stored packed
+    rasterizedPixels.resize(rasterizedPixels.size() + bitmap.width * bitmap.rows);
+    for (uint32_t row {0}; row < bitmap.rows; ++row)
+        std::memcpy(&rasterizedPixels[glyph.pixelsOffset + row * bitmap.width], bitmap.buffer + row * bitmap.pitch, bitmap.width);
+
+    glyphIndices[codepoint] = glyphs.size();
+    glyphs.push_back(glyph);
+    isDirty = true;
+    ++cacheStats.rasterizedGlyphs;
+
+    outGlyph.size = glm::ivec2{glyph.width, glyph.height};
+    outGlyph.bearing = glm::ivec2{glyph.bearingX, glyph.bearingY};
+    outGlyph.advance = glm::ivec2{glyph.advanceX, glyph.advanceY};
+    outGlyph.pixels = rasterizedPixels.data() + glyph.pixelsOffset;
+    return true;
+}
+
+//+ Disk Cache ================================================================
+
+bool FontFace::LoadCache() {
+    if (!cache.Open(cachePath))
+        return false;
+
+    if (cache.GetSize() < sizeof(FontCacheHeader)) {
+        cache.Close();
+        return false;
+    }
+
+    FontCacheHeader header;
+    std::memcpy(&header, cache.GetData(), sizeof(FontCacheHeader));
+
+    uint64_t glyphsSize {static_cast<uint64_t>(header.glyphCount) * sizeof(CachedGlyph)};
+    if (header.magic != fontCacheMagic || header.version != fontCacheVersion || header.sourceHash != sourceHash ||
+        header.fontSize != fontSize || header.mode != static_cast<uint32_t>(mode) ||
+        sizeof(FontCacheHeader) + glyphsSize + header.pixelsSize != cache.GetSize()) {
+        LOG_DEBUG("Font cache {} is stale, rasterizing glyphs again.", cachePath);
+        cache.Close();
+        return false;
+    }
+
+    const uint8_t* data {cache.GetData() + sizeof(FontCacheHeader)};
+    std::vector<CachedGlyph> cachedGlyphs(header.glyphCount);
+    std::memcpy(cachedGlyphs.data(), data, glyphsSize);
+    for (const CachedGlyph& glyph : cachedGlyphs) {
+        if (glyph.width < 0 || glyph.height < 0 ||
+            glyph.pixelsOffset + static_cast<uint64_t>(glyph.width) * glyph.height > header.pixelsSize) {
+            LOG_DEBUG("Font cache {} is stale, rasterizing glyphs again.", cachePath);
+            cache.Close();
+            return false;
+        }
+    }
+
+    metricsWidth = header.metricsWidth;
+    metricsHeight = header.metricsHeight;
+    maxBearing = glm::ivec2{header.maxBearingX, header.maxBearingY};
+
+    // The pixels are uploaded straight from the mapped file when the glyphs are used
+    glyphs = std::move(cachedGlyphs);
+    cachedGlyphCount = glyphs.size();
+    cachedPixels = data + glyphsSize;
+    cachedPixelsSize = header.pixelsSize;
+    glyphIndices.clear();
+    for (size_t i {0}; i < glyphs.size(); ++i)
+        glyphIndices[glyphs[i].codepoint] = i;
+
+    return true;
+}
+
+void FontFace::Save() {
+    if (!useDiskCache || !isDirty || cachePath.empty())
+        return;
+    isDirty = false;
+
+    if (!FileSystem::CreateDirectories(cacheDirectory))
+        return;
+
+    FontCacheHeader header;
+    header.magic = fontCacheMagic;
+    header.version = fontCacheVersion;
+    header.sourceHash = sourceHash;
+    header.fontSize = fontSize;
+    header.mode = static_cast<uint32_t>(mode);
+    header.metricsWidth = metricsWidth;
+    header.metricsHeight = metricsHeight;
+    header.maxBearingX = maxBearing.x;
+    header.maxBearingY = maxBearing.y;
+    header.glyphCount = static_cast<uint32_t>(glyphs.size());
+    header.pixelsSize = cachedPixelsSize + rasterizedPixels.size();
+
+    // Built in memory first since the pixels of the old file are read from its mapping, which must be closed to write it
+    size_t glyphsSize {glyphs.size() * sizeof(CachedGlyph)};
+    std::vector<uint8_t> contents(sizeof(FontCacheHeader) + glyphsSize + header.pixelsSize);
+    uint8_t* data {contents.data()};
+    std::memcpy(data, &header, sizeof(FontCacheHeader));
+    data += sizeof(FontCacheHeader);
+    for (size_t i {0}; i < glyphs.size(); ++i) {
+        CachedGlyph glyph {glyphs[i]};
+        if (i >= cachedGlyphCount)
+            glyph.pixelsOffset += static_cast<uint32_t>(cachedPixelsSize);
+        std::memcpy(data + i * sizeof(CachedGlyph), &glyph, sizeof(CachedGlyph));
+    }
+    data += glyphsSize;
+    if (cachedPixelsSize > 0)
+        std::memcpy(data, cachedPixels, cachedPixelsSize);
+    if (!rasterizedPixels.empty())
+        std::memcpy(data + cachedPixelsSize, rasterizedPixels.data(), rasterizedPixels.size());
+
+    cache.Close();
+    cachedPixels = nullptr;
+    {
+        // A partially written file will fail the size check on the next load, so there is no need for a temporary file
+        std::ofstream file {cachePath, std::ios::out | std::ios::binary | std::ios::trunc};
+        if (!file.is_open()) {
+            LOG_WARN("Failed to open font cache file {}.", cachePath);
+        }
+        else {
+            file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+        }
+    }
+
+    // The glyphs are read from the new file from now on
+    glyphs.clear();
+    glyphIndices.clear();
+    cachedGlyphCount = 0;
+    cachedPixelsSize = 0;
+    rasterizedPixels.clear();
+    if (!LoadCache())
+        LOG_WARN("Could not read back font cache {}, its glyphs will be rasterized again.", cachePath);
+}
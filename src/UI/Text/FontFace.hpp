@@ -0,0 +1,99 @@
+#ifndef __FONTFACE_H__
+#define __FONTFACE_H__
+
+#include "Utils/FileSystem.hpp"
+
+#include <glm/vec2.hpp>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class FontRenderMode;
+
+struct GlyphBitmap {
+    glm::ivec2 size;
+    glm::ivec2 bearing;
+    glm::ivec2 advance;
+    const uint8_t* pixels; // size.x * size.y tightly packed bytes, valid until the next LoadGlyph or Save
+};
+
+struct FontCacheStats {
+    uint32_t cachedFonts      {0}; // Fonts opened with a valid cache file
+    uint32_t cachedGlyphs     {0}; // Glyphs read from the cache files
+    uint32_t rasterizedGlyphs {0}; // Glyphs rasterized with FreeType
+};
+
+/**
+ * @brief Source of the glyph bitmaps of a font at a size. Rasterized glyphs are stored in a cache file next to the
+ * metrics of the font, so the next launch reads them from the mapped file instead of running FreeType again (which is
+ * slow for SDF glyphs). FreeType is only opened when a glyph is not in the cache.
+ */
+class FontFace {
+public:
+    FontFace(const std::string& fontFile, int fontSize, FontRenderMode mode);
+    ~FontFace();
+    FontFace(const FontFace&) = delete;
+    FontFace& operator=(const FontFace&) = delete;
+
+    bool Open();
+    bool LoadGlyph(uint32_t codepoint, GlyphBitmap& outGlyph);
+    // Writes the cache file again if glyphs were rasterized since it was read
+    void Save();
+
+    bool IsCached() const { return cache.IsOpen(); }
+    int GetMetricsWidth() const { return metricsWidth; }
+    int GetMetricsHeight() const { return metricsHeight; }
+    const glm::ivec2& GetMaxBearing() const { return maxBearing; }
+    void SetMaxBearing(const glm::ivec2& bearing);
+
+    static void EnableDiskCache(bool enable) { useDiskCache = enable; }
+    static bool IsDiskCacheEnabled() { return useDiskCache; }
+    static void SetCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+    static const std::string& GetCacheDirectory() { return cacheDirectory; }
+    static const FontCacheStats& GetCacheStats() { return cacheStats; }
+
+private:
+    bool LoadCache();
+    bool OpenFreeType();
+    bool Rasterize(uint32_t codepoint, GlyphBitmap& outGlyph);
+
+    struct CachedGlyph {
+        uint32_t codepoint;
+        int32_t width;
+        int32_t height;
+        int32_t bearingX;
+        int32_t bearingY;
+        int32_t advanceX;
+        int32_t advanceY;
+        uint32_t pixelsOffset;
+    };
+
+    std::string fontFile;
+    int fontSize;
+    FontRenderMode mode;
+    std::string cachePath;
+
+    MappedFile source;
+    uint64_t sourceHash {0};
+    struct FT_FaceRec_* face {nullptr};
+
+    int metricsWidth {0};
+    int metricsHeight {0};
+    glm::ivec2 maxBearing {0};
+
+    MappedFile cache;
+    const uint8_t* cachedPixels {nullptr};
+    uint64_t cachedPixelsSize {0};
+    std::vector<CachedGlyph> glyphs; // Glyphs of the cache file followed by the ones rasterized since it was read
+    std::unordered_map<uint32_t, size_t> glyphIndices;
+    size_t cachedGlyphCount {0};
+    std::vector<uint8_t> rasterizedPixels;
+    bool isDirty {false};
+
+    static bool useDiskCache;
+    static std::string cacheDirectory;
+    static FontCacheStats cacheStats;
+};
+
+#endif // __FONTFACE_H__
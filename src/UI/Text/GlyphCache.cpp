@@ -0,0 +1,304 @@
+#include "GlyphCache.hpp"
+
+#include "Core/Log.hpp"
+#include "FontFace.hpp"
+#include "Rendering/TextureArray.hpp"
+#include "TextRenderer.hpp"
+
+#include <algorithm>
+#include <glad/glad.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+//+ GlyphHashMap ============================================================
+
+GlyphHashMap::GlyphHashMap() : slots(256) {}
+
+int GlyphHashMap::Find(uint64_t key) const {
+    size_t mask {slots.size() - 1};
+    for (size_t i {Home(key)};; i = (i + 1) & mask) {
+        if (slots[i].key == key)
+            return slots[i].value;
+        if (slots[i].key == 0)
+            return -1;
+    }
+}
+
+void GlyphHashMap::Insert(uint64_t key, int value) {
+    // Kept under 70% full so the probe sequences stay short
+    if ((count + 1) * 10 > slots.size() * 7)
+        Grow();
+
+    size_t mask {slots.size() - 1};
+    for (size_t i {Home(key)};; i = (i + 1) & mask) {
+        if (slots[i].key == key) {
+            slots[i].value = value;
+            return;
+        }
+        if (slots[i].key == 0) {
+            slots[i] = Slot{key, value};
+            ++count;
+            return;
+        }
+    }
+}
+
+void GlyphHashMap::Erase(uint64_t key) {
+    size_t mask {slots.size() - 1};
+    size_t i {Home(key)};
+    while (slots[i].key != key) {
+        if (slots[i].key == 0)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    // Move back the entries of the probe sequence that would not be found anymore with the hole in between
+    for (size_t j {(i + 1) & mask}; slots[j].key != 0; j = (j + 1) & mask) {
+        size_t home {Home(slots[j].key)};
+        bool reachable {i <= j ? (home > i && home <= j) : (home > i || home <= j)};
+        if (!reachable) {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i] = Slot{};
+    --count;
+}
+
+void GlyphHashMap::Clear() {
+    std::fill(slots.begin(), slots.end(), Slot{});
+    count = 0;
+}
+
+void GlyphHashMap::Grow() {
+    std::vector<Slot> oldSlots(slots.size() * 2);
+    oldSlots.swap(slots);
+    count = 0;
+    for (const Slot& slot : oldSlots) {
+        if (slot.key != 0)
+            Insert(slot.key, slot.value);
+    }
+}
+
+size_t GlyphHashMap::Home(uint64_t key) const {
+    // Fibonacci hashing, the codepoints of a text are usually close to each other
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (slots.size() - 1);
+}
+
+//+ GlyphCache ==============================================================
+
+FT_Library GlyphCache::library {nullptr};
+Ref<TextureArray> GlyphCache::pages;
+std::vector<GlyphCache::Shelf> GlyphCache::shelves;
+std::vector<int> GlyphCache::pageHeights;
+std::vector<CharacterInfo> GlyphCache::glyphs;
+std::vector<uint64_t> GlyphCache::glyphKeys;
+std::vector<int> GlyphCache::freeGlyphs;
+std::vector<int> GlyphCache::failedGlyphs;
+uint32_t GlyphCache::failedGeneration {0};
+GlyphHashMap GlyphCache::lookup;
+uint64_t GlyphCache::frame {1};
+GlyphCacheStats GlyphCache::stats;
+
+void GlyphCache::Init() {
+    if (FT_Init_FreeType(&library)) {
+        LOG_WARN("Could not initialize FreeType library.");
+        library = nullptr;
+    }
+
+    pages = MakeRef<TextureArray>();
+    pages->SetWrapS(TextureParameter::ClampToEdge).SetWrapT(TextureParameter::ClampToEdge)
+          .SetMinFilter(TextureParameter::Linear).SetMagFilter(TextureParameter::Linear);
+    pages->Generate(pageSize, pageSize, pageCount, TextureFormat::R8, TextureFormat::RED);
+    // The padding around the glyphs must be empty for the linear filtering
+    glClearTexImage(pages->GetID(), 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+    pageHeights.assign(pageCount, 0);
+}
+
+void GlyphCache::Shutdown() {
+    shelves.clear();
+    pageHeights.clear();
+    glyphs.clear();
+    glyphKeys.clear();
+    freeGlyphs.clear();
+    failedGlyphs.clear();
+    failedGeneration = 0;
+    lookup.Clear();
+    pages.reset();
+    stats = GlyphCacheStats{};
+
+    if (library) {
+        FT_Done_FreeType(library);
+        library = nullptr;
+    }
+}
+
+const CharacterInfo& GlyphCache::GetGlyph(const Atlas& atlas, uint32_t codepoint) {
+    uint64_t key {MakeGlyphKey(atlas.fontID, static_cast<uint16_t>(atlas.baseFontSize), codepoint)};
+    int index {lookup.Find(key)};
+    if (index >= 0) {
+        const CharacterInfo& glyph {glyphs[index]};
+        if (glyph.shelf < shelves.size())
+            shelves[glyph.shelf].lastUsedFrame = frame;
+        return glyph;
+    }
+
+    //+ Read or rasterize the glyph
+    static CharacterInfo missingGlyph {};
+    missingGlyph = CharacterInfo{glm::ivec2{0}, glm::ivec2{0}, glm::ivec2{0}, glm::vec2{0.0f}, 0, noShelf};
+    GlyphBitmap bitmap;
+    if (!atlas.face || !atlas.face->LoadGlyph(codepoint, bitmap))
+        return missingGlyph;
+
+    CharacterInfo glyph;
+    glyph.size = bitmap.size;
+    glyph.bearing = bitmap.bearing;
+    glyph.advance = bitmap.advance;
+    glyph.uv = glm::vec2{0.0f};
+    glyph.layer = 0;
+    glyph.shelf = noShelf;
+
+    // Glyphs without pixels (e.g. spaces) only need their metrics
+    bool isFailed {false};
+    if (glyph.size.x > 0 && glyph.size.y > 0) {
+        glm::ivec2 position;
+        glyph.shelf = Allocate(glyph.size, position, glyph.layer);
+        if (glyph.shelf == noShelf) {
+            //! Cached as an empty glyph keeping its advance, so it isn't loaded (and warned about) again every frame until
+            //! the next eviction frees some room
+            ++stats.failedGlyphs;
+            LOG_WARN("No room in the glyph cache for character '{}' of font {}.", codepoint, atlas.fontID);
+            glyph.size = glm::ivec2{0};
+            glyph.bearing = glm::ivec2{0};
+            glyph.shelf = failedShelf;
+            isFailed = true;
+        }
+        else {
+            glyph.uv = glm::vec2{position} / static_cast<float>(pageSize);
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            pages->SubImage(glyph.layer, position.x, position.y, glyph.size.x, glyph.size.y, bitmap.pixels);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+    }
+
+    if (freeGlyphs.empty()) {
+        index = static_cast<int>(glyphs.size());
+        glyphs.push_back(glyph);
+        glyphKeys.push_back(key);
+    }
+    else {
+        index = freeGlyphs.back();
+        freeGlyphs.pop_back();
+        glyphs[index] = glyph;
+        glyphKeys[index] = key;
+    }
+    if (isFailed)
+        failedGlyphs.push_back(index);
+    else if (glyph.shelf != noShelf)
+        shelves[glyph.shelf].glyphs.push_back(index);
+    lookup.Insert(key, index);
+
+    if (!isFailed)
+        ++stats.rasterizedGlyphs;
+    stats.cachedGlyphs = lookup.GetSize();
+    return glyphs[index];
+}
+
+void GlyphCache::TouchShelf(uint32_t shelf) {
+    if (shelf < shelves.size())
+        shelves[shelf].lastUsedFrame = frame;
+}
+
+uint32_t GlyphCache::Allocate(const glm::ivec2& size, glm::ivec2& outPosition, int& outLayer) {
+    glm::ivec2 paddedSize {size + padding};
+    int shelfHeight {(paddedSize.y + shelfHeightStep - 1) / shelfHeightStep * shelfHeightStep};
+    if (paddedSize.x + padding > pageSize || shelfHeight + padding > pageSize)
+        return noShelf;
+
+    //+ The shortest shelf with room for the glyph, not much taller than it so small glyphs don't waste the tall shelves
+    uint32_t bestShelf {noShelf};
+    for (uint32_t i {0}; i < shelves.size(); ++i) {
+        const Shelf& shelf {shelves[i]};
+        if (shelf.height < paddedSize.y || shelf.height > shelfHeight + shelfHeightStep || shelf.x + paddedSize.x > pageSize)
+            continue;
+        if (bestShelf == noShelf || shelf.height < shelves[bestShelf].height)
+            bestShelf = i;
+    }
+
+    //+ A new shelf on the first page with room for it
+    if (bestShelf == noShelf) {
+        for (int layer {0}; layer < pageCount; ++layer) {
+            if (pageHeights[layer] + shelfHeight + padding > pageSize)
+                continue;
+
+            Shelf shelf;
+            shelf.layer = layer;
+            shelf.y = pageHeights[layer] + padding;
+            shelf.height = shelfHeight;
+            shelf.x = padding;
+            pageHeights[layer] = shelf.y + shelfHeight;
+            bestShelf = static_cast<uint32_t>(shelves.size());
+            shelves.push_back(std::move(shelf));
+            stats.shelves = static_cast<uint32_t>(shelves.size());
+            break;
+        }
+    }
+
+    //+ Every page is full, reuse the least recently used shelf
+    if (bestShelf == noShelf) {
+        bestShelf = FindLeastRecentlyUsedShelf(paddedSize.y);
+        if (bestShelf == noShelf)
+            return noShelf;
+        EvictShelf(bestShelf);
+    }
+
+    Shelf& shelf {shelves[bestShelf]};
+    outPosition = glm::ivec2{shelf.x, shelf.y};
+    outLayer = shelf.layer;
+    shelf.x += paddedSize.x;
+    shelf.lastUsedFrame = frame;
+    return bestShelf;
+}
+
+uint32_t GlyphCache::FindLeastRecentlyUsedShelf(int height) {
+    uint32_t bestShelf {noShelf};
+    for (uint32_t i {0}; i < shelves.size(); ++i) {
+        const Shelf& shelf {shelves[i]};
+        // Glyphs of this frame may already be in the vertices of a batch or a mesh
+        if (shelf.height < height || shelf.lastUsedFrame >= frame)
+            continue;
+        if (bestShelf == noShelf || shelf.lastUsedFrame < shelves[bestShelf].lastUsedFrame ||
+            (shelf.lastUsedFrame == shelves[bestShelf].lastUsedFrame && shelf.height < shelves[bestShelf].height))
+            bestShelf = i;
+    }
+    return bestShelf;
+}
+
+void GlyphCache::EvictShelf(uint32_t shelfIndex) {
+    Shelf& shelf {shelves[shelfIndex]};
+    for (int glyph : shelf.glyphs) {
+        lookup.Erase(glyphKeys[glyph]);
+        freeGlyphs.push_back(glyph);
+    }
+    stats.evictedGlyphs += static_cast<uint32_t>(shelf.glyphs.size());
+    // The glyphs that didn't fit are tried again now that there is room, the meshes that used them are built again
+    if (!failedGlyphs.empty()) {
+        for (int glyph : failedGlyphs) {
+            lookup.Erase(glyphKeys[glyph]);
+            freeGlyphs.push_back(glyph);
+        }
+        failedGlyphs.clear();
+        ++failedGeneration;
+    }
+    ++stats.evictedShelves;
+    stats.cachedGlyphs = lookup.GetSize();
+
+    shelf.glyphs.clear();
+    shelf.x = padding;
+    ++shelf.generation;
+    // The new glyphs could leave pixels of the old ones inside of their padding
+    glClearTexSubImage(pages->GetID(), 0, 0, shelf.y, shelf.layer, pageSize, shelf.height, 1, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+}
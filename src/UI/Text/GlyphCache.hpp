@@ -0,0 +1,133 @@
+#ifndef __GLYPHCACHE_H__
+#define __GLYPHCACHE_H__
+
+#include "Common.hpp"
+
+#include <glm/vec2.hpp>
+#include <stdint.h>
+#include <vector>
+
+class TextureArray;
+struct Atlas;
+
+struct CharacterInfo {
+    glm::ivec2 size;     // size of glyph
+    glm::ivec2 bearing;  // offset from baseline to left/top of glyph
+    glm::ivec2 advance;  // horizontal offset to advvance to next glyph
+    glm::vec2 uv;        // texture coordinates on the glyph page of the top-left corner of the glyph
+    int layer;           // glyph page (layer of GlyphCache::GetPages)
+    uint32_t shelf;      // shelf holding the glyph, GlyphCache::noShelf for glyphs without pixels or GlyphCache::failedShelf
+};
+
+// (font, size, codepoint) packed in a single value. Font ids start at 1, so 0 is never a valid key
+inline uint64_t MakeGlyphKey(uint16_t fontID, uint16_t size, uint32_t codepoint) {
+    return (static_cast<uint64_t>(fontID) << 48) | (static_cast<uint64_t>(size) << 32) | codepoint;
+}
+
+// Open addressing (linear probing) map from glyph keys to glyph indices. Erased entries are removed by shifting the
+// entries after them back, so lookups never go through tombstones
+class GlyphHashMap {
+public:
+    GlyphHashMap();
+
+    // -1 if the key is not in the map
+    int Find(uint64_t key) const;
+    void Insert(uint64_t key, int value);
+    void Erase(uint64_t key);
+    void Clear();
+
+    uint32_t GetSize() const { return count; }
+
+private:
+    void Grow();
+    size_t Home(uint64_t key) const;
+
+    struct Slot {
+        uint64_t key {0}; // 0 for empty slots
+        int value    {-1};
+    };
+
+    std::vector<Slot> slots;
+    uint32_t count {0};
+};
+
+struct GlyphCacheStats {
+    uint32_t cachedGlyphs     {0};
+    uint32_t rasterizedGlyphs {0}; // Uploaded since Init (rasterized or read from the font cache), including the ones uploaded again after being evicted
+    uint32_t evictedGlyphs    {0};
+    uint32_t evictedShelves   {0};
+    uint32_t shelves          {0};
+    uint32_t failedGlyphs     {0}; // Glyphs that didn't fit even after evicting (drawn as empty until the next eviction)
+};
+
+/**
+ * @brief Glyphs of every font loaded on demand from their FontFace and packed in shelves (rows) of a few pages, stored
+ * as the layers of a texture array so text using glyphs from different pages is still drawn at once.
+ *
+ * When no page has room for a new glyph, the least recently used shelf that wasn't used this frame is evicted whole:
+ * its glyphs are removed from the lookup and its generation increases, which tells the cached text meshes holding
+ * them to build again.
+ *
+ * //! Only used from the main thread (rasterizing uploads to the pages right away)
+ */
+class GlyphCache {
+public:
+    static constexpr int pageSize             {1024};
+    static constexpr int pageCount            {4};
+    static constexpr int padding              {2};
+    // Shelf heights are rounded up to this, so the glyphs of similar sizes share (and can reuse) shelves
+    static constexpr int shelfHeightStep      {8};
+    static constexpr uint32_t noShelf         {UINT32_MAX};
+    // Shelf of the glyphs that didn't fit, its generation increases when they are dropped to be loaded again
+    static constexpr uint32_t failedShelf     {UINT32_MAX - 1};
+
+    static void Init();
+    static void Shutdown();
+
+    // Glyphs used from now on belong to a new frame, the ones used in the previous frames can be evicted
+    static void NewFrame() { ++frame; }
+
+    // Returns the glyph, rasterizing it the first time it's asked for (or after being evicted). The reference is only
+    // valid until the next call
+    static const CharacterInfo& GetGlyph(const Atlas& atlas, uint32_t codepoint);
+    // Glyphs drawn from cached meshes don't go through GetGlyph, their shelves are kept from being evicted with this
+    static void TouchShelf(uint32_t shelf);
+    static uint32_t GetShelfGeneration(uint32_t shelf) { return shelf == failedShelf ? failedGeneration : shelves[shelf].generation; }
+
+    static const Ref<TextureArray>& GetPages() { return pages; }
+    static const GlyphCacheStats& GetStats() { return stats; }
+    static struct FT_LibraryRec_* GetLibrary() { return library; }
+
+private:
+    // Returns the shelf where the glyph was placed, or noShelf if there is no room for it
+    static uint32_t Allocate(const glm::ivec2& size, glm::ivec2& outPosition, int& outLayer);
+    static uint32_t FindLeastRecentlyUsedShelf(int height);
+    static void EvictShelf(uint32_t shelf);
+
+    struct Shelf {
+        int layer;
+        int y;
+        int height;
+        int x {0};
+        uint64_t lastUsedFrame {0};
+        uint32_t generation    {0};
+        std::vector<int> glyphs;
+    };
+
+    static struct FT_LibraryRec_* library;
+    static Ref<TextureArray> pages;
+    static std::vector<Shelf> shelves;
+    static std::vector<int> pageHeights; // Height used by the shelves of each page
+    static std::vector<CharacterInfo> glyphs;
+    static std::vector<uint64_t> glyphKeys;
+    static std::vector<int> freeGlyphs;
+    static std::vector<int> failedGlyphs; // Glyphs that didn't fit, kept in the lookup (without pixels) until the next eviction
+    static uint32_t failedGeneration;
+    static GlyphHashMap lookup;
+    static uint64_t frame;
+    static GlyphCacheStats stats;
+
+    friend class SelfTests;
+};
+
+#endif // __GLYPHCACHE_H__
@@ -2,115 +2,61 @@
 
 #include "Core/AssetManager.hpp"
 #include "Core/Log.hpp"
+#include "Core/Time.hpp"
+#include "FontFace.hpp"
 #include "Rendering/Shader.hpp"
 #include "Rendering/Texture.hpp"
+#include "Rendering/TextureArray.hpp"
 #include "Rendering/VertexArray.hpp"
 #include "Rendering/Batch.hpp"
+#include "Rendering/Buffer.hpp"
+#include "Rendering/RenderCommands.hpp"
+#include "Rendering/RenderStats.hpp"
 
+#include <algorithm>
 #include <imgui.h>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include <glm/gtc/matrix_transform.hpp>
 
 FontMap TextRenderer::fonts;
 
+uint16_t TextRenderer::nextFontID {1};
+
 void TextRenderer::LoadFont(const std::string& fontFile, const std::string& name, int fontSize, FontRenderMode renderMode) {
     if (fontSize == 0) {
         LOG_WARN("Could not create font with a size of 0.");
         return;
     }
     
-    FT_Library ft;
+    uint64_t loadStart {Time::GetPerformanceCounter()};
 
-    if (FT_Init_FreeType(&ft)) {
-        LOG_WARN("Could not initialize FreeType library.");
+    Ref<FontFace> face {MakeRef<FontFace>(fontFile, fontSize, renderMode)};
+    if (!face->Open())
         return;
-    }
 
-    FT_Face face;
-    if (FT_New_Face(ft, fontFile.c_str(), 0, &face)) {
-        LOG_WARN("Could not open font {}.", fontFile);
-        return;
-    }
-
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    int charactersNum {128}; // Hardcoded in here because for now this only works with ASCII
-    int padding {2};
-    
+    // Glyphs are loaded into the glyph cache the first time they are used, from the font cache file when they are in it
     Atlas atlas;
-    atlas.size = glm::ivec2{padding, padding * 2}; // Initial size
+    atlas.fontID = nextFontID++;
+    atlas.mode = renderMode;
+    atlas.face = face;
+    atlas.size = glm::ivec2{GlyphCache::pageSize};
     atlas.baseFontSize = fontSize;
-    atlas.characters = std::vector<CharacterInfo>(charactersNum);
-    atlas.maxBearing = glm::ivec2{0};
-
-    std::vector<std::vector<uint8_t>> glyphsBuffer(charactersNum);
+    atlas.metricsWidth = face->GetMetricsWidth();
+    atlas.metricsHeight = face->GetMetricsHeight();
 
+    // ASCII is cached right away, its bearings also give the ascent used to place the first line (stored in the font cache)
     // Caracters with code lower than 33 are control characters only
-    for (uint8_t c {33}; c < charactersNum; ++c) {
-        if (renderMode == FontRenderMode::SDF) {
-            if (FT_Load_Char(face, c, FT_LOAD_DEFAULT)) {
-                LOG_CRITICAL("Could not load character '{}'.", c);
-                // return;
-            }
-
-            if (FT_Render_Glyph(face->glyph, FT_Render_Mode::FT_RENDER_MODE_SDF)) {
-                LOG_CRITICAL("Could not load character '{}' as SDF.", c);
-                // return;
-            }
-        }
-        else if (renderMode == FontRenderMode::Raster) {
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-                LOG_CRITICAL("Could not load character '{}'.", c);
-                // return;
-            }
-        }
-
-        atlas.size.x += face->glyph->bitmap.width + padding;
-        atlas.size.y = std::max((uint32_t)atlas.size.y, face->glyph->bitmap.rows + padding * 2);
-
-        // Temporarily cache glyph buffers
-        uint32_t bufferSize {face->glyph->bitmap.width * face->glyph->bitmap.rows};
-        glyphsBuffer[c] = std::vector<uint8_t>(bufferSize);
-        memcpy(glyphsBuffer[c].data(), face->glyph->bitmap.buffer, bufferSize);
-
-        // Fill initial character info
-        atlas.characters[c].size = glm::ivec2{face->glyph->bitmap.width, face->glyph->bitmap.rows};
-        atlas.characters[c].bearing = glm::ivec2{face->glyph->bitmap_left, face->glyph->bitmap_top};
-        atlas.characters[c].advance = glm::ivec2{face->glyph->advance.x, face->glyph->advance.y};
-
-        atlas.maxBearing.x = std::max(atlas.maxBearing.x, face->glyph->bitmap_left);
-        atlas.maxBearing.y = std::max(atlas.maxBearing.y, face->glyph->bitmap_top);
+    glm::ivec2 maxBearing {0};
+    for (uint32_t c {33}; c < 128; ++c) {
+        const CharacterInfo& ch {GlyphCache::GetGlyph(atlas, c)};
+        maxBearing.x = std::max(maxBearing.x, ch.bearing.x);
+        maxBearing.y = std::max(maxBearing.y, ch.bearing.y);
     }
-
-    atlas.metricsWidth = face->size->metrics.max_advance;
-    atlas.metricsHeight = face->size->metrics.height;
-
-    atlas.texture = MakeRef<Texture>();
-    atlas.texture->Generate(atlas.size.x, atlas.size.y, nullptr, TextureFormat::R8, TextureFormat::RED);
-    atlas.texture->SetWrapS(TextureParameter::ClampToEdge).SetWrapT(TextureParameter::ClampToEdge).
-                SetMinFilter(TextureParameter::Linear).SetMagFilter(TextureParameter::Linear);
-
-    // Generate texture atlas and set characters uv coords (for now is a single row, so y is always = padding)
-    uint32_t x {static_cast<uint32_t>(padding)};
-    for (uint8_t c{32}; c < 128; ++c) {
-        atlas.characters[c].uv = glm::vec2{(float)x / atlas.size.x, padding};
-
-        // Upload glyph buffer to atlas texture
-        atlas.texture->SubImage(x, padding, atlas.characters[c].size.x, atlas.characters[c].size.y, glyphsBuffer[c].data());
-
-        x += atlas.characters[c].size.x + padding;
-    }
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    if (!face->IsCached())
+        face->SetMaxBearing(maxBearing);
+    atlas.maxBearing = face->GetMaxBearing();
+    face->Save();
 
     switch (renderMode) {
         case FontRenderMode::SDF:
@@ -120,155 +66,48 @@ void TextRenderer::LoadFont(const std::string& fontFile, const std::string& name
             fonts[name][fontSize] = atlas;
             break;
     }
-}
 
-void TextRenderer::RenderText(const std::string& text, float size, const glm::vec2& position, const TextAppearance& textAppearance, const TextSettings& settings, const Font& font) {
-    if (text.empty())
-        return;
-
-    auto shader {AssetManager::GetShader("text")};
-    if (font.mode == FontRenderMode::SDF) {
-        shader = AssetManager::GetShader("textSDF");
-    }
-    shader->Use();
-
-    Atlas* atlas {nullptr};
-
-    if (font.mode == FontRenderMode::Raster) {
-        auto fontIter {fonts.find(font.name)};
-        if (fontIter != fonts.end()) {
-            auto atlasIter {fontIter->second.find(font.size)};
-            if (atlasIter != fontIter->second.end()) {
-                atlas = &atlasIter->second;
-            }
-            else {
-                LOG_WARN("No font with name '{}' and size '{}' was loaded.", font.name, font.size);
-                return;
-            }
-        }
-    }
-    else {
-        auto fontIter {fonts.find(font.name)};
-        if (fontIter != fonts.end()) {
-            auto atlasIter {fontIter->second.find(0)};
-            if (atlasIter != fontIter->second.end()) {
-                atlas = &atlasIter->second;
-            }
-            else {
-                LOG_WARN("No sdf font with name '{}' was loaded.", font.name);
-                return;
-            }
-        }
-
-        shader->SetFloat("textInfo.width", textAppearance.width);
-        shader->SetFloat("textInfo.edge", textAppearance.edge);
-        shader->SetFloat("textInfo.borderWidth", textAppearance.borderWidth);
-        shader->SetFloat("textInfo.borderEdge", textAppearance.borderEdge);
-        shader->SetVec2("textInfo.borderOffset", textAppearance.borderOffset);
-        shader->SetVec3("textInfo.outlineColor", Color2Vec3(textAppearance.outlineColor));
-    }
-
-    atlas->texture->Use();
-
-    glm::vec2 scale {size / (float)atlas->baseFontSize};
-
-    glEnable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    float penx {position.x};
-    float peny {position.y + atlas->maxBearing.y * scale.y};
-    TextBatch::Start();
-    for (auto c {text.begin()}; c != text.end(); ++c) {
-        CharacterInfo& ch {atlas->characters[static_cast<uint8_t>(*c)]};
-
-        switch (*c) {
-            case ' ':
-                penx += settings.wordSpacing + (atlas->metricsWidth / 2 >> 6) * scale.x;
-                continue;
-            case '\n':
-                penx = position.x;
-                peny += settings.lineSpacing + (atlas->metricsHeight >> 6) * scale.y;
-                continue;
-            case '\t':
-                penx += (settings.wordSpacing + (atlas->metricsWidth / 2 >> 6) * scale.x) * settings.spacesPerTab;
-                continue;
-        }
+    LOG_DEBUG("Font {} ({}) loaded in {} ms{}.", name, fontFile, Time::GetMilisecondsSince(loadStart), face->IsCached() ? " from cache" : "");
+}
 
-        // Positions relative to the origin line for the glyph:
-        float xpos {penx + ch.bearing.x * scale.x};
-        float ypos {peny - ch.bearing.y * scale.y};
-
-        float w    {ch.size.x * scale.x};
-        float h    {ch.size.y * scale.y};
-
-        TextVertex tl{
-            glm::vec4{xpos, ypos,
-                      ch.uv.x, ch.uv.y / (float)atlas->size.y},
-        };
-        TextVertex tr{
-            glm::vec4{xpos + w, ypos,
-                      ch.uv.x + ch.size.x / (float)atlas->size.x, ch.uv.y / (float)atlas->size.y},
-        };
-        TextVertex bl {
-            glm::vec4{xpos, ypos + h, 
-                      ch.uv.x, (ch.uv.y + ch.size.y) / (float)atlas->size.y},
-        };
-        TextVertex br {
-            glm::vec4{xpos + w, ypos + h, 
-                      ch.uv.x + ch.size.x / (float)atlas->size.x, (ch.uv.y + ch.size.y) / (float)atlas->size.y},
-        };
-
-        if (textAppearance.useColorGradient) {
-            tr.color = Color2Vec4(textAppearance.colorGradient.topRightColor);
-            tl.color = Color2Vec4(textAppearance.colorGradient.topLeftColor);
-            bl.color = Color2Vec4(textAppearance.colorGradient.bottomLeftColor); 
-            br.color = Color2Vec4(textAppearance.colorGradient.bottomRightColor); 
+void TextRenderer::UnloadFonts() {
+    // Glyphs rasterized since the fonts were loaded are added to their cache files
+    for (auto& [name, atlases] : fonts) {
+        for (auto& [size, atlas] : atlases) {
+            if (atlas.face)
+                atlas.face->Save();
         }
-        else {
-            bl.color = Color2Vec4(textAppearance.color);
-            br.color = Color2Vec4(textAppearance.color);
-            tl.color = Color2Vec4(textAppearance.color);
-            tr.color = Color2Vec4(textAppearance.color);
-        }
-
-        TextBatch::AddCharacter(bl, br, tl, tr);
-
-        penx += settings.letterSpacing + (ch.advance.x >> 6) * scale.x;  // Bitshift by 6 to get a value in pixels (1/64th times 2^6 = 64)
-        peny += (ch.advance.y >> 6) * scale.y; 
     }
-    TextBatch::Flush();
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_BLEND);
+    fonts.clear();
 }
 
-void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rect& rect, const glm::vec2 textBounds,
-                              const TextAppearance& textAppearance, const TextSettings& settings, TextHorzAlign horzAlign, TextVertAlign vertAlign, TextTransform transform,
-                              const Font& font, const Atlas* atlas) {
+void TextRenderer::RenderText(const std::string& text, float size, const glm::vec2& position, const TextAppearance& textAppearance, const TextSettings& settings, const Font& font) {
     if (text.empty())
         return;
 
-    auto shader {AssetManager::GetShader("text")};
-    if (font.mode == FontRenderMode::SDF) {
-        shader = AssetManager::GetShader("textSDF");
-    }
-    shader->Use();
-
-    if (font.mode == FontRenderMode::SDF) {
-        shader->SetFloat("textInfo.width", textAppearance.width);
-        shader->SetFloat("textInfo.edge", textAppearance.edge);
-        shader->SetFloat("textInfo.borderWidth", textAppearance.borderWidth);
-        shader->SetFloat("textInfo.borderEdge", textAppearance.borderEdge);
-        shader->SetVec2("textInfo.borderOffset", textAppearance.borderOffset);
-        shader->SetVec3("textInfo.outlineColor", Color2Vec3(textAppearance.outlineColor));
-    }
+    Atlas* atlas {GetAtlas(font)};
+    if (!atlas)
+        return;
+
+    // Same layout as the lines of a top-left aligned label
+    static std::vector<LineInfo> lines;
+    SplitTextLines(text, lines);
 
-    atlas->texture->Use();
+    RenderCommandList& commands {RenderQueue::GetList()};
+    RenderState previousState {commands.GetState()};
+    commands.GetState().blend = BlendMode::Alpha;
+    RenderText(lines, size, Rect{position, glm::vec2{0.0f}}, glm::vec2{0.0f}, textAppearance, settings, TextHorzAlign::Left,
+               TextVertAlign::Top, TextTransform::None, font, atlas);
+    commands.SetState(previousState);
+}
 
+// Lays out the glyph quads of the lines inside of rect, passing each one to emitGlyph(ch, bl, br, tl, tr)
+template<class EmitGlyph>
+static void LayoutTextLines(const std::vector<LineInfo>& text, float size, const Rect& rect, const glm::vec2 textBounds,
+                            const TextAppearance& textAppearance, const TextSettings& settings, TextHorzAlign horzAlign, TextVertAlign vertAlign, TextTransform transform,
+                            const Atlas* atlas, EmitGlyph&& emitGlyph) {
     glm::vec2 scale {size / (float)atlas->baseFontSize};
 
-    // glEnable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glm::vec2 pen {0.0f};
     // pen.y = rect.position.y + atlas->maxBearing.y * scale.y;
 
@@ -284,7 +123,6 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
             break;
     }
 
-    TextBatch::Start();
     for (size_t i{}; i < text.size(); ++i) {
         const LineInfo& currentLine{text[i]};
 
@@ -301,8 +139,8 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
         }
 
         // for (auto c {currentLine.text.begin()}; c != currentLine.text.end(); ++c) {
-        for (size_t i {0}; i < currentLine.text.size(); ++i) {
-            char c {currentLine.text[i]};
+        for (size_t i {0}; i < currentLine.text.size();) {
+            uint32_t c {DecodeUTF8(currentLine.text, i)};
 
             switch (transform) {
                 case TextTransform::None:
@@ -329,8 +167,6 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
                     break;
             }
 
-            const CharacterInfo& ch {atlas->characters[c]};
-
             switch (c) {
                 case ' ':
                     pen.x += settings.wordSpacing + (atlas->metricsWidth / 2 >> 6) * scale.x;
@@ -340,6 +176,8 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
                     continue;
             }
 
+            const CharacterInfo& ch {GlyphCache::GetGlyph(*atlas, c)};
+
             // Positions relative to the origin line for the glyph:
             float xpos{pen.x + ch.bearing.x * scale.x};
             float ypos{pen.y - ch.bearing.y * scale.y};
@@ -347,22 +185,24 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
             float w{ch.size.x * scale.x};
             float h{ch.size.y * scale.y};
 
+            float layer {static_cast<float>(ch.layer)};
             TextVertex tl{
                 glm::vec4{xpos, ypos,
-                          ch.uv.x, ch.uv.y / (float)atlas->size.y},
+                          ch.uv.x, ch.uv.y},
             };
             TextVertex tr{
                 glm::vec4{xpos + w, ypos,
-                          ch.uv.x + ch.size.x / (float)atlas->size.x, ch.uv.y / (float)atlas->size.y},
+                          ch.uv.x + ch.size.x / (float)atlas->size.x, ch.uv.y},
             };
             TextVertex bl{
                 glm::vec4{xpos, ypos + h,
-                          ch.uv.x, (ch.uv.y + ch.size.y) / (float)atlas->size.y},
+                          ch.uv.x, ch.uv.y + ch.size.y / (float)atlas->size.y},
             };
             TextVertex br{
                 glm::vec4{xpos + w, ypos + h,
-                          ch.uv.x + ch.size.x / (float)atlas->size.x, (ch.uv.y + ch.size.y) / (float)atlas->size.y},
+                          ch.uv.x + ch.size.x / (float)atlas->size.x, ch.uv.y + ch.size.y / (float)atlas->size.y},
             };
+            tl.layer = tr.layer = bl.layer = br.layer = layer;
 
             if (textAppearance.useColorGradient) {
                 tr.color = Color2Vec4(textAppearance.colorGradient.topRightColor);
@@ -377,7 +217,7 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
                 tr.color = Color2Vec4(textAppearance.color);
             }
 
-            TextBatch::AddCharacter(bl, br, tl, tr);
+            emitGlyph(ch, bl, br, tl, tr);
 
             pen.x += settings.letterSpacing + (ch.advance.x >> 6) * scale.x;  // Bitshift by 6 to get a value in pixels (1/64th times 2^6 = 64)
             pen.y += (ch.advance.y >> 6) * scale.y;
@@ -385,9 +225,134 @@ void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rec
         pen.x = rect.position.x;
         pen.y += settings.lineSpacing + (atlas->metricsHeight >> 6) * scale.y;
     }
+}
+
+static Ref<Shader> GetTextShader(const Font& font) {
+    return AssetManager::GetShader(font.mode == FontRenderMode::SDF ? "textSDF" : "text");
+}
+
+void RecordTextInfoUniforms(RenderCommandList& commands, const Ref<Shader>& shader, const TextAppearance& appearance) {
+    // Handles of the last sdf shader, weak so the shader is still released with the other assets
+    static std::weak_ptr<Shader> textShader;
+    static UniformHandle widthUniform, edgeUniform, borderWidthUniform, borderEdgeUniform, borderOffsetUniform, outlineColorUniform;
+
+    if (textShader.lock() != shader) {
+        textShader = shader;
+        widthUniform = shader->GetUniform("textInfo.width");
+        edgeUniform = shader->GetUniform("textInfo.edge");
+        borderWidthUniform = shader->GetUniform("textInfo.borderWidth");
+        borderEdgeUniform = shader->GetUniform("textInfo.borderEdge");
+        borderOffsetUniform = shader->GetUniform("textInfo.borderOffset");
+        outlineColorUniform = shader->GetUniform("textInfo.outlineColor");
+    }
+
+    commands.SetUniform(widthUniform, appearance.width);
+    commands.SetUniform(edgeUniform, appearance.edge);
+    commands.SetUniform(borderWidthUniform, appearance.borderWidth);
+    commands.SetUniform(borderEdgeUniform, appearance.borderEdge);
+    commands.SetUniform(borderOffsetUniform, appearance.borderOffset);
+    commands.SetUniform(outlineColorUniform, Color2Vec3(appearance.outlineColor));
+}
+
+void TextRenderer::RenderText(std::vector<LineInfo>& text, float size, const Rect& rect, const glm::vec2 textBounds,
+                              const TextAppearance& textAppearance, const TextSettings& settings, TextHorzAlign horzAlign, TextVertAlign vertAlign, TextTransform transform,
+                              const Font& font, const Atlas* atlas) {
+    if (text.empty())
+        return;
+
+    TextBatch::SetMaterial(GetTextShader(font), GlyphCache::GetPages(), font.mode == FontRenderMode::SDF ? &textAppearance : nullptr);
+
+    RenderCommandList& commands {RenderQueue::GetList()};
+    RenderState previousState {commands.GetState()};
+    commands.GetState().cullFace = true;
+    TextBatch::Start();
+    LayoutTextLines(text, size, rect, textBounds, textAppearance, settings, horzAlign, vertAlign, transform, atlas,
+                    [](const CharacterInfo&, const TextVertex& bl, const TextVertex& br, const TextVertex& tl, const TextVertex& tr) {
+        TextBatch::AddCharacter(bl, br, tl, tr);
+    });
     TextBatch::Flush();
-    glDisable(GL_CULL_FACE);
-    // glDisable(GL_BLEND);
+    commands.SetState(previousState);
+}
+
+//+ Text Mesh ===============================================================================================
+
+void TextMesh::Build(const std::vector<LineInfo>& text, float size, const Rect& rect, const glm::vec2 textBounds,
+                     const TextAppearance& textAppearance, const TextSettings& settings, TextHorzAlign horzAlign, TextVertAlign vertAlign, TextTransform transform,
+                     const Font& font, const Atlas* atlas) {
+    //! Only touched from the main thread (the buffer is created and filled right away)
+    static std::vector<TextVertex> vertices;
+    vertices.clear();
+    shelves.clear();
+    LayoutTextLines(text, size, rect, textBounds, textAppearance, settings, horzAlign, vertAlign, transform, atlas,
+                    [this](const CharacterInfo& ch, const TextVertex& bl, const TextVertex& br, const TextVertex& tl, const TextVertex& tr) {
+        vertices.insert(vertices.end(), {bl, br, tl, tr});
+        if (ch.shelf != GlyphCache::noShelf) {
+            auto usedShelf {std::find_if(shelves.begin(), shelves.end(), [&ch](const GlyphShelf& shelf) { return shelf.index == ch.shelf; })};
+            if (usedShelf == shelves.end())
+                shelves.push_back(GlyphShelf{ch.shelf, GlyphCache::GetShelfGeneration(ch.shelf)});
+        }
+    });
+
+    shader = GetTextShader(font);
+    atlasTexture = GlyphCache::GetPages();
+    isSDF = font.mode == FontRenderMode::SDF;
+    quadCount = static_cast<uint32_t>(vertices.size() / 4);
+    if (quadCount == 0)
+        return;
+
+    // The buffer only grows, so editing a text doesn't reallocate it every time
+    uint32_t dataSize {static_cast<uint32_t>(vertices.size() * sizeof(TextVertex))};
+    if (!vertexBuffer || vertexBuffer->GetSize() < dataSize)
+        vertexBuffer = MakeRef<Buffer>(dataSize, vertices.data(), BufferUsage::Dynamic);
+    else
+        vertexBuffer->SetData(0, dataSize, vertices.data());
+}
+
+void TextMesh::Draw(const TextAppearance& textAppearance) const {
+    if (quadCount == 0)
+        return;
+
+    // The glyphs of the mesh aren't looked up again, this keeps them from being evicted while it's drawn
+    for (const GlyphShelf& shelf : shelves)
+        GlyphCache::TouchShelf(shelf.index);
+
+    RenderCommandList& commands {RenderQueue::GetList()};
+    RenderState previousState {commands.GetState()};
+    commands.GetState().cullFace = true;
+
+    // The index buffer of the text batch covers maxCharacters quads, longer texts are drawn in several parts
+    auto vao {AssetManager::GetVertexArray("textBatch")};
+    for (uint32_t firstQuad {0}; firstQuad < quadCount; firstQuad += TextBatch::maxCharacters) {
+        uint32_t count {std::min(quadCount - firstQuad, TextBatch::maxCharacters)};
+        DrawCommand& command {commands.Record(commands.NextSequentialKey(RenderPass::UI), *shader, *vao)};
+        command.vertexBuffer = vertexBuffer->GetID();
+        command.vertexOffset = firstQuad * 4 * static_cast<uint32_t>(sizeof(TextVertex));
+        command.vertexStride = sizeof(TextVertex);
+        command.textures[0] = atlasTexture->GetID();
+        command.count = count * 6;
+
+        if (isSDF)
+            RecordTextInfoUniforms(commands, shader, textAppearance);
+    }
+    RenderStats::AddGlyphs(quadCount);
+
+    commands.SetState(previousState);
+}
+
+void TextMesh::Clear() {
+    quadCount = 0;
+    vertexBuffer.reset();
+    shader.reset();
+    atlasTexture.reset();
+    shelves.clear();
+}
+
+bool TextMesh::AreGlyphsCached() const {
+    for (const GlyphShelf& shelf : shelves) {
+        if (GlyphCache::GetShelfGeneration(shelf.index) != shelf.generation)
+            return false;
+    }
+    return true;
 }
 
 Atlas* TextRenderer::GetAtlas(const Font& font) {
@@ -457,9 +422,8 @@ glm::vec2 TextRenderer::GetLineBounds(const std::string& text, float size, const
     if (text.empty())
         return bbox;
 
-    for (auto i {0}; i < text.size(); ++i) {
-        char c {text[i]};
-        CharacterInfo& ch {atlas.characters[c]};
+    for (size_t i {0}; i < text.size();) {
+        uint32_t c {DecodeUTF8(text, i)};
 
         switch (c) {
             case ' ':
@@ -472,6 +436,7 @@ glm::vec2 TextRenderer::GetLineBounds(const std::string& text, float size, const
                 return bbox;
         }
 
+        const CharacterInfo& ch {GlyphCache::GetGlyph(atlas, c)};
         bbox.x += settings.letterSpacing + (ch.advance.x >> 6) * scale.x;  // Bitshift by 6 to get a value in pixels (1/64th times 2^6 = 64)
     }
 
@@ -487,9 +452,8 @@ void TextRenderer::CalculateLineBounds(LineInfo& line, float size, const TextSet
     if (line.text.empty())
         return;
 
-    for (auto i{0}; i < line.text.size(); ++i) {
-        char c {line.text[i]};
-        CharacterInfo& ch {atlas.characters[c]};
+    for (size_t i {0}; i < line.text.size();) {
+        uint32_t c {DecodeUTF8(line.text, i)};
 
         switch (c) {
             case ' ':
@@ -502,12 +466,51 @@ void TextRenderer::CalculateLineBounds(LineInfo& line, float size, const TextSet
                 return;
         }
 
+        const CharacterInfo& ch {GlyphCache::GetGlyph(atlas, c)};
         line.size.x += settings.letterSpacing + (ch.advance.x >> 6) * scale.x;  // Bitshift by 6 to get a value in pixels (1/64th times 2^6 = 64)
     }
     line.size.x = std::ceil(line.size.x);
     line.size.y = std::ceil(line.size.y);
 }
 
+uint32_t DecodeUTF8(const std::string& text, size_t& index) {
+    constexpr uint32_t replacementCharacter {0xFFFD};
+
+    uint8_t lead {static_cast<uint8_t>(text[index++])};
+    if (lead < 0x80)
+        return lead;
+
+    int continuationBytes;
+    uint32_t codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+        continuationBytes = 1;
+        codepoint = lead & 0x1F;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        continuationBytes = 2;
+        codepoint = lead & 0x0F;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        continuationBytes = 3;
+        codepoint = lead & 0x07;
+    }
+    else {
+        return replacementCharacter;
+    }
+
+    for (int i {0}; i < continuationBytes; ++i) {
+        if (index >= text.size() || (static_cast<uint8_t>(text[index]) & 0xC0) != 0x80)
+            return replacementCharacter;
+        codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[index++]) & 0x3F);
+    }
+
+    // Overlong encodings, surrogates and values past the unicode range
+    constexpr uint32_t minCodepoints[] {0, 0x80, 0x800, 0x10000};
+    if (codepoint < minCodepoints[continuationBytes] || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+        return replacementCharacter;
+    return codepoint;
+}
+
 void SplitTextLines(const std::string& text, std::vector<LineInfo>& outLines) {
     outLines.clear();
 
@@ -4,11 +4,14 @@
 #include "Common.hpp"
 #include "Utils/Color.hpp"
 #include "UI/Rect.hpp"
+#include "UI/Text/GlyphCache.hpp"
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+class FontFace;
+
 struct TextGradient {
     Color topLeftColor;
     Color topRightColor;
@@ -42,6 +45,10 @@ struct TextAppearance {
     Color outlineColor;
 };
 
+// Sets the sdf parameters of the appearance as uniforms of the last draw recorded in the list. The uniform handles are
+// only resolved again when the shader changes
+void RecordTextInfoUniforms(class RenderCommandList& commands, const Ref<class Shader>& shader, const TextAppearance& appearance);
+
 struct TextSettings {
     float letterSpacing{0};
     float lineSpacing{0};
@@ -79,18 +86,13 @@ struct Font {
     FontRenderMode mode;
 };
 
-struct CharacterInfo {
-    glm::ivec2 size;     // size of glyph
-    glm::ivec2 bearing;  // offset from baseline to left/top of glyph
-    glm::ivec2 advance;  // horizontal offset to advvance to next glyph
-    glm::vec2 uv;        // texture coordinates on atlas texture of the top-left corner of the glyph
-};
-
+// Font loaded at a size, its glyphs are rasterized on demand into the GlyphCache
 struct Atlas {
-    Ref<class Texture> texture;
-    glm::ivec2 size;
+    uint16_t fontID {0};
+    FontRenderMode mode;
+    Ref<FontFace> face;
+    glm::ivec2 size; // Size of the glyph pages
     int baseFontSize;
-    std::vector<CharacterInfo> characters;
 
     int metricsWidth;
     int metricsHeight;
@@ -100,7 +102,6 @@ struct Atlas {
 using FontAtlasMap = std::unordered_map<int, Atlas>;
 using FontMap = std::unordered_map<std::string, FontAtlasMap>;
 
-// TODO: Support caching the atlas texture on the computer
 class TextRenderer {
 public:
     // When renderMode is SDF fontSize is recommended to be left as 64 since bigger sizes take longer to load and 64 is already produces really good results
@@ -120,11 +121,51 @@ public:
     static void CalculateLineBounds(LineInfo& line, float size, const TextSettings& settings, Atlas& atlas);
 
     static Atlas* GetAtlas(const Font& font);
+    // Saves the font caches and closes the font faces, their glyphs can't be loaded anymore
+    static void UnloadFonts();
 
 private: 
     static FontMap fonts;    
+    static uint16_t nextFontID;
 };
 
+/**
+ * @brief Glyph quads of a text laid out once and kept in a GPU buffer, so text that doesn't change is drawn every frame
+ * without repeating its layout. Colors are stored in the vertices, the sdf parameters are set as uniforms on each Draw.
+ */
+class TextMesh {
+public:
+    // Same layout as TextRenderer::RenderText
+    void Build(const std::vector<LineInfo>& text, float size, const Rect& rect, const glm::vec2 textBounds,
+               const TextAppearance& textAppearance, const TextSettings& settings, TextHorzAlign horzAlign, TextVertAlign vertAlign, TextTransform transform,
+               const Font& font, const Atlas* atlas);
+    // Records the draw of the mesh in the render queue of the calling thread
+    void Draw(const TextAppearance& textAppearance) const;
+    void Clear();
+
+    // False once a glyph of the mesh was evicted from the GlyphCache (or one that didn't fit can be loaded again), the
+    // mesh must be built again
+    bool AreGlyphsCached() const;
+    bool IsEmpty() const { return quadCount == 0; }
+    uint32_t GetQuadCount() const { return quadCount; }
+
+private:
+    struct GlyphShelf {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    Ref<class Buffer> vertexBuffer;
+    Ref<class Shader> shader;
+    Ref<class TextureArray> atlasTexture;
+    std::vector<GlyphShelf> shelves; // Glyph cache shelves holding the glyphs of the mesh
+    bool isSDF          {false};
+    uint32_t quadCount  {0};
+};
+
+// Decodes the UTF-8 sequence starting at index and moves index past it. Invalid sequences return U+FFFD
+uint32_t DecodeUTF8(const std::string& text, size_t& index);
+
 void SplitTextLines(const std::string& text, std::vector<LineInfo>& outLines);
 void SplitTextLines(const std::string& text, std::vector<std::string>& outLines);
 
@@ -3,6 +3,7 @@
 #include "Core/AssetManager.hpp"
 #include "Core/Log.hpp"
 #include "Rendering/Camera.hpp"
+#include "Rendering/RenderCommands.hpp"
 #include "Rendering/Shader.hpp"
 #include "Rendering/VertexArray.hpp"
 #include "Rendering/Sprite.hpp"
@@ -323,13 +324,15 @@ void Widget::Render() {
 
     Draw();
 
+    RenderCommandList& commands {RenderQueue::GetList()};
+    RenderState previousState {commands.GetState()};
     if (clipChildren) {
-        glEnable(GL_SCISSOR_TEST);
         Rect scaledRect {Camera::GetMainCamera().RectFromVirtual2ScreenSize(rect, true)};
-        glScissor(static_cast<int>(scaledRect.position.x), 
-                  static_cast<int>(scaledRect.position.y), 
-                  static_cast<int>(scaledRect.size.x), 
-                  static_cast<int>(scaledRect.size.y));
+        commands.GetState().scissorTest = true;
+        commands.GetState().scissor = glm::ivec4{static_cast<int>(scaledRect.position.x), 
+                                                 static_cast<int>(scaledRect.position.y), 
+                                                 static_cast<int>(scaledRect.size.x), 
+                                                 static_cast<int>(scaledRect.size.y)};
     }
 
     for (auto& child : children) {
@@ -338,28 +341,47 @@ void Widget::Render() {
     }
 
     if (clipChildren) {
-        glDisable(GL_SCISSOR_TEST);
+        commands.SetState(previousState);
     }
 
     RemovePendingChildren();
 }
 
 void Widget::Draw() {
-    auto uiShader{AssetManager::GetShader("gui")};
-    uiShader->Use();
     auto missingTex{AssetManager::GetTexture("missing")};
     Sprite tempSprite{missingTex};
-    missingTex->Use();
 
     UpdateTransform();
-    uiShader->SetMatrix4("model", model);
-    uiShader->SetVec2("spriteMinUV", tempSprite.GetMinUV());
-    uiShader->SetVec2("spriteMaxUV", tempSprite.GetMaxUV());
-    uiShader->SetVec4("color", glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
-    uiShader->SetBool("flipX", false);
-    uiShader->SetBool("flipY", false);
-    uiShader->SetBool("useVirtualResolution", true);
-    AssetManager::GetVertexArray("gui")->Draw();
+    RecordGuiQuad(model, missingTex->GetID(), tempSprite, glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+}
+
+void Widget::RecordGuiQuad(const glm::mat4& model, uint32_t texture, const Sprite& sprite, const glm::vec4& color) {
+    // Handles of the last gui shader, weak so the shader is still released with the other assets
+    static std::weak_ptr<Shader> guiShader;
+    static UniformHandle modelUniform, minUVUniform, maxUVUniform, colorUniform, flipXUniform, flipYUniform, virtualResolutionUniform;
+
+    auto shader {AssetManager::GetShader("gui")};
+    if (guiShader.lock() != shader) {
+        guiShader = shader;
+        modelUniform = shader->GetUniform("model");
+        minUVUniform = shader->GetUniform("spriteMinUV");
+        maxUVUniform = shader->GetUniform("spriteMaxUV");
+        colorUniform = shader->GetUniform("color");
+        flipXUniform = shader->GetUniform("flipX");
+        flipYUniform = shader->GetUniform("flipY");
+        virtualResolutionUniform = shader->GetUniform("useVirtualResolution");
+    }
+
+    RenderCommandList& commands {RenderQueue::GetList()};
+    DrawCommand& command {commands.Record(commands.NextSequentialKey(RenderPass::UI), *shader, *AssetManager::GetVertexArray("gui"))};
+    command.textures[0] = texture;
+    commands.SetUniform(modelUniform, model);
+    commands.SetUniform(minUVUniform, sprite.GetMinUV());
+    commands.SetUniform(maxUVUniform, sprite.GetMaxUV());
+    commands.SetUniform(colorUniform, color);
+    commands.SetUniform(flipXUniform, static_cast<int>(sprite.flipX));
+    commands.SetUniform(flipYUniform, static_cast<int>(sprite.flipY));
+    commands.SetUniform(virtualResolutionUniform, 1);
 }
 
 // TODO: Add handle for OnButtonDown and OnButtonUp
@@ -8,6 +8,7 @@
 #include <SDL.h>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 
 enum class Anchor {
     TopLeft,    Top,    TopRight,
@@ -80,6 +81,8 @@ public:
 
 protected:
     virtual void Draw();
+    // Records a quad of the gui shader in the UI pass. Its uniform handles are only resolved again when the shader changes
+    static void RecordGuiQuad(const glm::mat4& model, uint32_t texture, const class Sprite& sprite, const glm::vec4& color);
 
     void SortChildren();
     void RemovePendingChildren();
@@ -0,0 +1,177 @@
+#include "FileSystem.hpp"
+
+#include "Core/Log.hpp"
+
+#include <filesystem>
+#include <fmt/core.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <windows.h>
+#define stat _stat
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//+ MappedFile ================================================================
+
+MappedFile::MappedFile() { }
+
+MappedFile::MappedFile(const std::string& path) {
+    Open(path);
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data{other.data}, size{other.size} {
+#ifdef WIN32
+    fileHandle = other.fileHandle;
+    mappingHandle = other.mappingHandle;
+    other.fileHandle = nullptr;
+    other.mappingHandle = nullptr;
+#endif
+    other.data = nullptr;
+    other.size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    Close();
+    data = other.data;
+    size = other.size;
+#ifdef WIN32
+    fileHandle = other.fileHandle;
+    mappingHandle = other.mappingHandle;
+    other.fileHandle = nullptr;
+    other.mappingHandle = nullptr;
+#endif
+    other.data = nullptr;
+    other.size = 0;
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+#ifdef WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        Close();
+        return false;
+    }
+
+    data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd {open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return false;
+
+    struct stat result;
+    if (fstat(fd, &result) != 0 || result.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* view {mmap(nullptr, result.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+    close(fd); // The mapping keeps its own reference to the file
+    if (view == MAP_FAILED)
+        return false;
+
+    data = static_cast<const uint8_t*>(view);
+    size = static_cast<size_t>(result.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data)
+        munmap(const_cast<uint8_t*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+//+ FileSystem ================================================================
+
+namespace FileSystem {
+    bool Exists(const std::string& path) {
+        std::error_code error;
+        return std::filesystem::exists(path, error);
+    }
+
+    bool CreateDirectories(const std::string& path) {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        if (error) {
+            LOG_WARN("Could not create directory {}: {}.", path, error.message());
+            return false;
+        }
+        return true;
+    }
+
+    time_t GetLastModifiedTime(const std::string& path) {
+        struct stat result;
+        if (stat(path.c_str(), &result) == 0)
+            return result.st_mtime;
+        return 0;
+    }
+
+    uint64_t Hash(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* bytes {static_cast<const uint8_t*>(data)};
+        uint64_t hash {seed};
+        for (size_t i {0}; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= fnvPrime;
+        }
+        return hash;
+    }
+
+    uint64_t Hash(const std::string& str, uint64_t seed) {
+        return Hash(str.data(), str.size(), seed);
+    }
+
+    bool HashFile(const std::string& path, uint64_t* outHash) {
+        MappedFile file {path};
+        if (!file.IsOpen())
+            return false;
+
+        *outHash = Hash(file.GetData(), file.GetSize());
+        return true;
+    }
+
+    std::string HashToString(uint64_t hash) {
+        return fmt::format("{:016x}", hash);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef __FILESYSTEM_H__
+#define __FILESYSTEM_H__
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+// Read-only memory mapping of a whole file. The view stays valid until Close() is called or the object is destroyed
+class MappedFile {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& path);
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return data != nullptr; }
+
+    const uint8_t* GetData() const { return data; }
+    size_t GetSize() const { return size; }
+
+private:
+    const uint8_t* data {nullptr};
+    size_t size         {0};
+#ifdef WIN32
+    void* fileHandle    {nullptr};
+    void* mappingHandle {nullptr};
+#endif
+};
+
+namespace FileSystem {
+    constexpr uint64_t fnvOffsetBasis {14695981039346656037ull};
+    constexpr uint64_t fnvPrime       {1099511628211ull};
+
+    bool Exists(const std::string& path);
+    bool CreateDirectories(const std::string& path);
+    // Returns 0 if the file could not be found
+    time_t GetLastModifiedTime(const std::string& path);
+
+    // FNV-1a 64 bits. Pass the result of a previous call as seed to hash multiple chunks
+    uint64_t Hash(const void* data, size_t size, uint64_t seed = fnvOffsetBasis);
+    uint64_t Hash(const std::string& str, uint64_t seed = fnvOffsetBasis);
+    bool HashFile(const std::string& path, uint64_t* outHash);
+
+    // Returns the hash formatted as a 16 characters hexadecimal string, useful for cache file names
+    std::string HashToString(uint64_t hash);
+}
+
+#endif // __FILESYSTEM_H__
@@ -12,6 +12,17 @@ float MapValues(float value, float fromMin, float fromMax, float toMin, float to
     return (value - fromMin) * ((toMax - toMin) / (fromMax - fromMin)) + toMin;
 }
 
+Bounds2D TransformBounds(const Bounds2D& bounds, const glm::mat4& matrix) {
+    glm::vec2 corners[4] {bounds.min, glm::vec2{bounds.max.x, bounds.min.y}, glm::vec2{bounds.min.x, bounds.max.y}, bounds.max};
+    Bounds2D result {vec2::inf, vec2::ninf};
+    for (auto& corner : corners) {
+        glm::vec2 point {matrix * glm::vec4{corner, 0.0f, 1.0f}};
+        result.min = glm::min(result.min, point);
+        result.max = glm::max(result.max, point);
+    }
+    return result;
+}
+
 void RotateAroundPivot(Transform& transform, const glm::vec3& pivot, const glm::vec3& axis, float angle) {
     glm::quat rot{glm::angleAxis(angle, axis)};
     transform.SetPosition(rot * (transform.GetPosition() - pivot) + pivot);
@@ -30,6 +30,20 @@ namespace quaternion {
     constexpr glm::quat identity {1.0f, 0.0f, 0.0f, 0.0f};
 }
 
+// Axis aligned 2D bounding box
+struct Bounds2D {
+    glm::vec2 min {0.0f};
+    glm::vec2 max {0.0f};
+
+    bool Overlaps(const Bounds2D& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x 
+            && min.y <= other.max.y && max.y >= other.min.y;
+    }
+};
+
+// Bounds containing the 4 corners of the given bounds after being transformed by matrix
+Bounds2D TransformBounds(const Bounds2D& bounds, const glm::mat4& matrix);
+
 // Affine transformation
 float MapValues(float value, float fromMin, float fromMax, float toMin, float toMax);
 
@@ -1,17 +1,85 @@
 #include "Core/AssetManager.hpp"
 #include "Core/Engine.hpp"
 #include "Core/Log.hpp"
+#include "Core/SelfTests.hpp"
+#include "UI/Text/TextRenderer.hpp"
 #include "Utils/Random.hpp"
 
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// Writes the peaks of a headless run as the CMake variables the headless_budget test limits are computed from
+static bool WriteHeadlessBaseline(const std::string& path, uint32_t frames, const HeadlessResult& result) {
+    std::ofstream file {path, std::ios::out | std::ios::trunc};
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open headless baseline file {}.", path);
+        return false;
+    }
+
+    uint64_t uploadKB {(result.maxUploadedBytes + 1023) / 1024};
+    file << "# Peak per frame values of a headless run of " << frames << " frames (after the first one), written by\n"
+         << "# OGLRoguelike --headless " << frames << " --record-baseline. Record it again when the extra cost is intended.\n"
+         << "set(HEADLESS_BASELINE_FRAMES " << frames << ")\n"
+         << "set(HEADLESS_BASELINE_DRAW_CALLS " << result.maxDrawCalls << ")\n"
+         << "set(HEADLESS_BASELINE_UPLOAD_KB " << uploadKB << ")\n";
+    LOG_INFO("Headless baseline written to {}: {} draw calls, {} KB uploaded.", path, result.maxDrawCalls, uploadKB);
+    return true;
+}
 
 int main(int argc, char** argv) {
     Log::Init("SHDW", "%^[%d-%m-%Y %H:%M:%S] [%l]: %v%$");
-    Random::SetSeed(std::chrono::high_resolution_clock::now().time_since_epoch().count());
 
-    Engine app {"OGLRoguelike", 960, 540};
-    app.Run();
+    //+ --headless <frames> [--max-draw-calls <count>] [--max-upload-kb <size>] [--self-test] [--record-baseline <file>]
+    //+ Runs without a window on the null GL backend (e.g. in CI), the exit code is 1 if a frame went over the budget
+    //+ or, with --self-test, if any of the SelfTests failed after the frames. --record-baseline writes the measured
+    //+ peaks as the CMake baseline of the headless_budget test
+    bool headless {false};
+    bool selfTest {false};
+    std::string baselineFile;
+    uint32_t headlessFrames {0};
+    FrameBudget budget;
+    for (int i {1}; i < argc; ++i) {
+        std::string arg {argv[i]};
+        bool hasValue {i + 1 < argc};
+        if (arg == "--headless" && hasValue) {
+            headless = true;
+            headlessFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--max-draw-calls" && hasValue) {
+            budget.maxDrawCalls = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--max-upload-kb" && hasValue) {
+            budget.maxUploadedBytes = std::strtoull(argv[++i], nullptr, 10) * 1024;
+        }
+        else if (arg == "--self-test") {
+            selfTest = true;
+        }
+        else if (arg == "--record-baseline" && hasValue) {
+            baselineFile = argv[++i];
+        }
+    }
+
+    //! Headless runs use a fixed seed so their results can be compared between runs
+    Random::SetSeed(headless ? 0 : std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+    int exitCode {0};
+    Engine app {"OGLRoguelike", 960, 540, headless};
+    if (headless) {
+        HeadlessResult result;
+        bool passed {app.RunHeadless(headlessFrames, budget, &result)};
+        if (!baselineFile.empty())
+            passed = WriteHeadlessBaseline(baselineFile, headlessFrames, result) && passed;
+        if (selfTest)
+            passed = SelfTests::Run() && passed;
+        exitCode = passed ? 0 : 1;
+    }
+    else
+        app.Run();
 
+    TextRenderer::UnloadFonts();
+    GlyphCache::Shutdown();
     AssetManager::Clear();
 
-    return 0;
+    return exitCode;
 }
\ No newline at end of file